@@ -0,0 +1,464 @@
+//
+//  main.m
+//  Benchmark
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+#import <MAChineLearning/MAChineLearning.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else // __APPLE__
+#include <time.h>
+#endif // __APPLE__
+
+#define BENCHMARK_FORMAT_VERSION         (1)
+
+#define BENCHMARK_DEFAULT_MIN_DURATION   (0.25)
+#define BENCHMARK_DEFAULT_TOLERANCE      (0.10)
+#define BENCHMARK_WARMUP_STEPS           (3)
+#define BENCHMARK_LEARNING_RATE          (0.01)
+
+#define ARG_OUTPUT                       (@"output")
+#define ARG_BASELINE                     (@"baseline")
+#define ARG_TOLERANCE                    (@"tolerance")
+#define ARG_MIN_DURATION                 (@"minDuration")
+#define ARG_FILTER                       (@"filter")
+
+
+#pragma mark -
+#pragma mark Utilities
+
+#ifdef __APPLE__
+static double __secondsPerTick= 0.0;
+#endif // __APPLE__
+
+static double BenchmarkNow(void) {
+#ifdef __APPLE__
+    
+    // Mach time is used, as clock_gettime is missing before macOS 10.12 and iOS 10
+    if (__secondsPerTick == 0.0) {
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        
+        __secondsPerTick= 1.0e-9 * ((double) timebase.numer) / ((double) timebase.denom);
+    }
+    
+    return ((double) mach_absolute_time()) * __secondsPerTick;
+#else // __APPLE__
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return ((double) now.tv_sec) + 1.0e-9 * ((double) now.tv_nsec);
+#endif // __APPLE__
+}
+
+static NSString *ActivationName(MLActivationFunctionType funcType) {
+    switch (funcType) {
+        case MLActivationFunctionTypeLinear: return @"linear";
+        case MLActivationFunctionTypeRectifiedLinear: return @"relu";
+        case MLActivationFunctionTypeStep: return @"step";
+        case MLActivationFunctionTypeSigmoid: return @"sigmoid";
+        case MLActivationFunctionTypeTanH: return @"tanh";
+        case MLActivationFunctionTypeSoftmax: return @"softmax";
+    }
+}
+
+static NSString *BackPropagationName(MLBackPropagationType backPropType) {
+    switch (backPropType) {
+        case MLBackPropagationTypeStandard: return @"standard";
+        case MLBackPropagationTypeResilient: return @"rprop";
+        case MLBackPropagationTypeMomentum: return @"momentum";
+        case MLBackPropagationTypeNesterov: return @"nesterov";
+        case MLBackPropagationTypeRMSProp: return @"rmsprop";
+        case MLBackPropagationTypeAdam: return @"adam";
+        case MLBackPropagationTypeImprovedResilient: return @"irprop";
+    }
+}
+
+
+#pragma mark -
+#pragma mark Benchmark case
+
+@interface BenchmarkCase : NSObject
+
+- (nonnull instancetype) initWithLayerSizes:(nonnull NSArray<NSNumber *> *)layerSizes
+                                  batchSize:(NSUInteger)batchSize
+                                   funcType:(MLActivationFunctionType)funcType
+                               backPropType:(MLBackPropagationType)backPropType
+                                    threads:(NSUInteger)threads;
+
+- (nonnull NSDictionary<NSString *, id> *) runForDuration:(NSTimeInterval)minDuration;
+
+@property (nonatomic, readonly, nonnull) NSString *name;
+
+@end
+
+
+@implementation BenchmarkCase {
+    NSArray<NSNumber *> *_layerSizes;
+    NSUInteger _batchSize;
+    MLActivationFunctionType _funcType;
+    MLBackPropagationType _backPropType;
+    NSUInteger _threads;
+}
+
+- (instancetype) initWithLayerSizes:(NSArray<NSNumber *> *)layerSizes batchSize:(NSUInteger)batchSize funcType:(MLActivationFunctionType)funcType backPropType:(MLBackPropagationType)backPropType threads:(NSUInteger)threads {
+    if ((self = [super init])) {
+        _layerSizes= layerSizes;
+        _batchSize= batchSize;
+        _funcType= funcType;
+        _backPropType= backPropType;
+        _threads= threads;
+        
+        // The name identifies the case in the baseline
+        _name= [NSString stringWithFormat:@"%@/b%lu/%@/%@/t%lu",
+                [layerSizes componentsJoinedByString:@"-"],
+                (unsigned long) batchSize,
+                ActivationName(funcType),
+                BackPropagationName(backPropType),
+                (unsigned long) threads];
+    }
+    
+    return self;
+}
+
+- (NSDictionary<NSString *, id> *) runForDuration:(NSTimeInterval)minDuration {
+    MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:_layerSizes
+                                                              useBias:YES
+                                                     costFunctionType:MLCostFunctionTypeSquaredError
+                                                  backPropagationType:_backPropType
+                                                   hiddenFunctionType:_funcType
+                                                   outputFunctionType:MLActivationFunctionTypeSigmoid];
+    
+    [net randomizeWeights];
+    
+    // FLOPs of a training step, estimated from layer sizes:
+    // 2·N·P per sample for feed forward, as much for error fetch
+    // (not on the first layer) and for the gradient, N·P for update
+    double feedForwardFlops= 0.0;
+    double backPropagationFlops= 0.0;
+    double updateFlops= 0.0;
+    for (NSUInteger i= 1; i < net.layers.count; i++) {
+        double weights= (double) (net.layers[i].size * net.layers[i -1].size);
+        
+        feedForwardFlops += 2.0 * weights * _batchSize;
+        backPropagationFlops += ((i > 1) ? 4.0 : 2.0) * weights * _batchSize;
+        updateFlops += weights;
+    }
+    
+    MLParallelTrainer *trainer= nil;
+    MLReal *inputBuffer= NULL;
+    MLReal *expectedOutputBuffer= NULL;
+    
+    if (_threads > 1) {
+        trainer= [[MLParallelTrainer alloc] initWithNetwork:net workers:_threads batchSize:_batchSize];
+        
+        inputBuffer= trainer.batchInputBuffer;
+        expectedOutputBuffer= trainer.batchExpectedOutputBuffer;
+        
+    } else if (_batchSize > 1) {
+        [net setUpBatchOfSize:_batchSize];
+        
+        inputBuffer= net.batchInputBuffer;
+        expectedOutputBuffer= net.batchExpectedOutputBuffer;
+        
+    } else {
+        inputBuffer= net.inputBuffer;
+        expectedOutputBuffer= net.expectedOutputBuffer;
+    }
+    
+    // Inputs are random, outputs are a fixed one-hot pattern
+    [MLRandom setSeed:_name.hash];
+    
+    [MLRandom fillVector:inputBuffer size:_batchSize * net.inputSize ofUniformRealsWithMin:0.0 max:1.0];
+    
+    ML_VCLR(expectedOutputBuffer, 1, _batchSize * net.outputSize);
+    for (NSUInteger i= 0; i < _batchSize; i++)
+        expectedOutputBuffer[i * net.outputSize + (i % net.outputSize)]= 1.0;
+    
+    // Run the steps, the first few are not measured
+    NSUInteger steps= 0;
+    NSUInteger allocations= 0;
+    double feedForwardTime= 0.0;
+    double backPropagationTime= 0.0;
+    double updateTime= 0.0;
+    double begin= 0.0;
+    double now= 0.0;
+    
+    MLReal learningRate= ((_backPropType != MLBackPropagationTypeResilient) &&
+                          (_backPropType != MLBackPropagationTypeImprovedResilient)) ? BENCHMARK_LEARNING_RATE : 0.0;
+    
+    for (NSInteger step= -BENCHMARK_WARMUP_STEPS; ; step++) {
+        if (step == 0) {
+            allocations= MLAllocBufferCount();
+            begin= BenchmarkNow();
+        }
+        
+        if (trainer) {
+            [trainer trainBatchOfSize:_batchSize learningRate:learningRate];
+            now= BenchmarkNow();
+            
+        } else {
+            double start= BenchmarkNow();
+            
+            if (_batchSize > 1)
+                [net feedForwardBatchOfSize:_batchSize];
+            else
+                [net feedForward];
+            
+            double fed= BenchmarkNow();
+            
+            if (_batchSize > 1)
+                [net backPropagateBatchWithLearningRate:learningRate];
+            else
+                [net backPropagateWithLearningRate:learningRate];
+            
+            double propagated= BenchmarkNow();
+            
+            [net updateWeights];
+            now= BenchmarkNow();
+            
+            if (step >= 0) {
+                feedForwardTime += fed - start;
+                backPropagationTime += propagated - fed;
+                updateTime += now - propagated;
+            }
+        }
+        
+        if (step >= 0) {
+            steps++;
+            
+            if (now - begin >= minDuration)
+                break;
+        }
+    }
+    
+    double elapsed= now - begin;
+    double flops= feedForwardFlops + backPropagationFlops + updateFlops;
+    
+    NSMutableDictionary<NSString *, id> *result= [@{@"name": _name,
+                                                    @"layerSizes": _layerSizes,
+                                                    @"batchSize": @(_batchSize),
+                                                    @"activation": ActivationName(_funcType),
+                                                    @"backPropagation": BackPropagationName(_backPropType),
+                                                    @"threads": @(_threads),
+                                                    @"steps": @(steps),
+                                                    @"samplesPerSecond": @(((double) (steps * _batchSize)) / elapsed),
+                                                    @"gflops": @((flops * steps) / (elapsed * 1.0e9))} mutableCopy];
+    
+    // Phases can be timed only without the parallel trainer
+    if (!trainer) {
+        result[@"feedForwardGflops"]= @((feedForwardFlops * steps) / (feedForwardTime * 1.0e9));
+        result[@"backPropagationGflops"]= @((backPropagationFlops * steps) / (backPropagationTime * 1.0e9));
+        result[@"updateGflops"]= @((updateFlops * steps) / (updateTime * 1.0e9));
+    }
+    
+    // Allocations are counted in debug builds only
+#if DEBUG
+    result[@"allocationsPerStep"]= @(((double) (MLAllocBufferCount() - allocations)) / ((double) steps));
+#else // DEBUG
+    (void) allocations;
+    result[@"allocationsPerStep"]= [NSNull null];
+#endif // DEBUG
+    
+    return result;
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark Grid and baseline
+
+static NSArray<BenchmarkCase *> *CreateGrid(void) {
+    NSArray<NSArray<NSNumber *> *> *layerSizes= @[@[@64, @32, @10],
+                                                  @[@256, @128, @10],
+                                                  @[@784, @300, @10]];
+    
+    NSArray<NSNumber *> *batchSizes= @[@1, @16, @64];
+    NSArray<NSNumber *> *funcTypes= @[@(MLActivationFunctionTypeSigmoid),
+                                      @(MLActivationFunctionTypeRectifiedLinear),
+                                      @(MLActivationFunctionTypeTanH)];
+    
+    NSArray<NSNumber *> *backPropTypes= @[@(MLBackPropagationTypeStandard),
+                                          @(MLBackPropagationTypeResilient),
+                                          @(MLBackPropagationTypeAdam)];
+    
+    // Thread counts are powers of 2 up to the number of cores
+    NSMutableArray<NSNumber *> *threadCounts= [NSMutableArray arrayWithObject:@1];
+    for (NSUInteger threads= 2; threads <= [NSProcessInfo processInfo].activeProcessorCount; threads *= 2)
+        [threadCounts addObject:@(threads)];
+    
+    NSMutableArray<BenchmarkCase *> *grid= [NSMutableArray array];
+    for (NSArray<NSNumber *> *sizes in layerSizes) {
+        for (NSNumber *batchSize in batchSizes) {
+            for (NSNumber *funcType in funcTypes) {
+                for (NSNumber *backPropType in backPropTypes) {
+                    for (NSNumber *threads in threadCounts) {
+                        
+                        // The parallel trainer supports standard backpropagation only,
+                        // with at least one sample per worker
+                        if ((threads.unsignedIntegerValue > 1) &&
+                            ((backPropType.unsignedIntegerValue != MLBackPropagationTypeStandard) ||
+                             (batchSize.unsignedIntegerValue < threads.unsignedIntegerValue)))
+                            continue;
+                        
+                        [grid addObject:[[BenchmarkCase alloc] initWithLayerSizes:sizes
+                                                                        batchSize:batchSize.unsignedIntegerValue
+                                                                         funcType:funcType.unsignedIntegerValue
+                                                                     backPropType:backPropType.unsignedIntegerValue
+                                                                          threads:threads.unsignedIntegerValue]];
+                    }
+                }
+            }
+        }
+    }
+    
+    return grid;
+}
+
+static NSArray<NSDictionary<NSString *, id> *> *CompareWithBaseline(NSArray<NSDictionary<NSString *, id> *> *results, NSDictionary<NSString *, id> *baseline, double tolerance, NSUInteger *regressions) {
+    NSMutableDictionary<NSString *, NSDictionary<NSString *, id> *> *baselineResults= [NSMutableDictionary dictionary];
+    for (NSDictionary<NSString *, id> *result in baseline[@"results"])
+        baselineResults[result[@"name"]]= result;
+    
+    NSMutableArray<NSDictionary<NSString *, id> *> *comparison= [NSMutableArray array];
+    *regressions= 0;
+    
+    for (NSDictionary<NSString *, id> *result in results) {
+        NSDictionary<NSString *, id> *baselineResult= baselineResults[result[@"name"]];
+        if (!baselineResult)
+            continue;
+        
+        // Throughput ratio: below 1 is slower than the baseline
+        double ratio= [result[@"samplesPerSecond"] doubleValue] / [baselineResult[@"samplesPerSecond"] doubleValue];
+        
+        NSString *verdict= @"unchanged";
+        if (ratio < 1.0 - tolerance) {
+            verdict= @"slower";
+            (*regressions)++;
+            
+        } else if (ratio > 1.0 + tolerance)
+            verdict= @"faster";
+        
+        [comparison addObject:@{@"name": result[@"name"],
+                                @"ratio": @(ratio),
+                                @"verdict": verdict}];
+        
+        if (![verdict isEqualToString:@"unchanged"])
+            NSLog(@"%-7@ %-40@ %5.2fx", verdict, result[@"name"], ratio);
+    }
+    
+    return comparison;
+}
+
+
+#pragma mark -
+#pragma mark Main
+
+// Usage: Benchmark [-output <file>] [-baseline <file>] [-tolerance <fraction>]
+//                  [-minDuration <secs>] [-filter <substring>]
+//
+// Results are written as JSON to the output file (standard output by
+// default); a previous output may be passed as the baseline, in which
+// case the exit status is 1 if any case is slower beyond tolerance
+int main(int argc, const char * argv[]) {
+    int status= 0;
+    
+    @autoreleasepool {
+        @try {
+            NSUserDefaults *args= [NSUserDefaults standardUserDefaults];
+            
+            NSString *outputPath= [args stringForKey:ARG_OUTPUT];
+            NSString *baselinePath= [args stringForKey:ARG_BASELINE];
+            NSString *filter= [args stringForKey:ARG_FILTER];
+            
+            double tolerance= [args objectForKey:ARG_TOLERANCE] ? [args doubleForKey:ARG_TOLERANCE] : BENCHMARK_DEFAULT_TOLERANCE;
+            double minDuration= [args objectForKey:ARG_MIN_DURATION] ? [args doubleForKey:ARG_MIN_DURATION] : BENCHMARK_DEFAULT_MIN_DURATION;
+            
+            // Run the grid
+            NSMutableArray<NSDictionary<NSString *, id> *> *results= [NSMutableArray array];
+            for (BenchmarkCase *benchmarkCase in CreateGrid()) {
+                if (filter && ([benchmarkCase.name rangeOfString:filter].location == NSNotFound))
+                    continue;
+                
+                NSDictionary<NSString *, id> *result= [benchmarkCase runForDuration:minDuration];
+                [results addObject:result];
+                
+                NSLog(@"%-40@ %10.0f samples/sec, %7.3f GFLOP/s", benchmarkCase.name, [result[@"samplesPerSecond"] doubleValue], [result[@"gflops"] doubleValue]);
+            }
+            
+            NSMutableDictionary<NSString *, id> *report= [@{@"version": @(BENCHMARK_FORMAT_VERSION),
+                                                            @"date": [[NSDate date] description],
+                                                            @"realSize": @(sizeof(MLReal)),
+                                                            @"processors": @([NSProcessInfo processInfo].activeProcessorCount),
+                                                            @"osVersion": [NSProcessInfo processInfo].operatingSystemVersionString,
+                                                            @"results": results} mutableCopy];
+            
+            // Compare with the baseline, if any
+            if (baselinePath) {
+                NSData *baselineData= [NSData dataWithContentsOfFile:baselinePath];
+                if (!baselineData)
+                    @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                                   reason:@"Can't read the baseline file"
+                                                 userInfo:@{@"path": baselinePath}];
+                
+                NSDictionary<NSString *, id> *baseline= [NSJSONSerialization JSONObjectWithData:baselineData options:0 error:nil];
+                if ([baseline[@"realSize"] unsignedIntegerValue] != sizeof(MLReal))
+                    NSLog(@"Warning: baseline was measured with a different precision");
+                
+                NSUInteger regressions= 0;
+                report[@"comparison"]= CompareWithBaseline(results, baseline, tolerance, &regressions);
+                report[@"regressions"]= @(regressions);
+                
+                NSLog(@"Compared with baseline: %lu regressions beyond %.0f%% tolerance", (unsigned long) regressions, tolerance * 100.0);
+                
+                if (regressions > 0)
+                    status= 1;
+            }
+            
+            NSData *json= [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:nil];
+            
+            if (outputPath)
+                [json writeToFile:outputPath atomically:YES];
+            else
+                [[NSFileHandle fileHandleWithStandardOutput] writeData:json];
+
+        } @catch (NSException *e) {
+            NSLog(@"Exception caught: %@, reason: %@: user info: %@\nStack trace:\n%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+            
+            status= 2;
+        }
+    }
+    
+    return status;
+}
@@ -139,5 +139,9 @@
 @property (nonatomic, readonly) NSUInteger outputSize;
 @property (nonatomic, readonly, nonnull) MLReal *outputBuffer;
 
+@property (nonatomic, readonly) NSUInteger sparseSize;
+@property (nonatomic, readonly, nonnull) int *sparseIndices;
+@property (nonatomic, readonly, nonnull) MLReal *sparseValues;
+
 
 @end
@@ -57,6 +57,10 @@
     NSUInteger _outputSize;
     MLReal *_outputBuffer;
     BOOL _localBuffer;
+    
+    NSUInteger _sparseSize;
+    int *_sparseIndices;
+    MLReal *_sparseValues;
 }
 
 
@@ -73,6 +77,7 @@
 - (void) prepareOutputBuffer:(MLReal *)outputBuffer;
 - (void) fillOutputBuffer:(MLWordDictionary *)dictionary buildDictionary:(BOOL)buildDictionary featureNormalization:(MLFeatureNormalizationType)normalizationType;
 - (void) normalizeOutputBuffer:(MLWordDictionary *)dictionary featureNormalization:(MLFeatureNormalizationType)normalizationType;
+- (void) fillSparseValues;
 
 
 @end
@@ -214,6 +219,9 @@ static NSDictionary<NSString *, NSSet<NSString *> *> *__stopWords= nil;
 
         // Apply vector-wide normalization
         [self normalizeOutputBuffer:dictionary featureNormalization:normalizationType];
+        
+        // Collect values of the sparse representation
+        [self fillSparseValues];
     }
     
     return self;
@@ -255,14 +263,25 @@ static NSDictionary<NSString *, NSSet<NSString *> *> *__stopWords= nil;
 
         // Apply vector-wide normalization
         [self normalizeOutputBuffer:dictionary featureNormalization:normalizationType];
+        
+        // Collect values of the sparse representation
+        [self fillSparseValues];
     }
     
     return self;
 }
 
 - (void) dealloc {
-    MLFreeRealBuffer(_outputBuffer);
+    if (_localBuffer)
+        MLFreeRealBuffer(_outputBuffer);
+    
     _outputBuffer= NULL;
+    
+    MLFreeIntBuffer(_sparseIndices);
+    _sparseIndices= NULL;
+    
+    MLFreeRealBuffer(_sparseValues);
+    _sparseValues= NULL;
 }
 
 
@@ -281,6 +300,13 @@ static NSDictionary<NSString *, NSSet<NSString *> *> *__stopWords= nil;
     
     // Clear the output buffer
     ML_VCLR(_outputBuffer, 1, _outputSize);
+    
+    // Nonzero features can't be more than the words
+    NSUInteger maxSparseSize= MAX(_words.count, 1);
+    
+    _sparseSize= 0;
+    _sparseIndices= MLAllocIntBuffer(maxSparseSize);
+    _sparseValues= MLAllocRealBuffer(maxSparseSize);
 }
 
 - (void) fillOutputBuffer:(MLWordDictionary *)dictionary buildDictionary:(BOOL)buildDictionary featureNormalization:(MLFeatureNormalizationType)normalizationType {
@@ -293,6 +319,11 @@ static NSDictionary<NSString *, NSSet<NSString *> *> *__stopWords= nil;
         MLWordInfo *wordInfo= [dictionary infoForWord:word];
         
         if (wordInfo) {
+            
+            // Keep track of nonzero features
+            if (_outputBuffer[wordInfo.position] == 0.0)
+                _sparseIndices[_sparseSize++]= (int) wordInfo.position;
+            
             switch (normalizationType) {
                 case MLFeatureNormalizationTypeNone:
                 case MLFeatureNormalizationTypeL1:
@@ -362,6 +393,13 @@ static NSDictionary<NSString *, NSSet<NSString *> *> *__stopWords= nil;
 }
 
 
+- (void) fillSparseValues {
+    
+    // Gather the values of nonzero features, after normalization
+    for (NSUInteger i= 0; i < _sparseSize; i++)
+        _sparseValues[i]= _outputBuffer[_sparseIndices[i]];
+}
+
 #pragma mark -
 #pragma mark Dictionary building
 
@@ -926,5 +964,9 @@ static NSDictionary<NSString *, NSSet<NSString *> *> *__stopWords= nil;
 @synthesize outputSize= _outputSize;
 @synthesize outputBuffer= _outputBuffer;
 
+@synthesize sparseSize= _sparseSize;
+@synthesize sparseIndices= _sparseIndices;
+@synthesize sparseValues= _sparseValues;
+
 
 @end
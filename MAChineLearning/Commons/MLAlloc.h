@@ -44,3 +44,13 @@ void MLFreeRealPointerBuffer(MLReal * _Nonnull * _Nullable buffer);
 
 int * _Nonnull MLAllocIntBuffer(NSUInteger size);
 void MLFreeIntBuffer(int * _Nonnull buffer);
+
+int8_t * _Nonnull MLAllocInt8Buffer(NSUInteger size);
+void MLFreeInt8Buffer(int8_t * _Nonnull buffer);
+
+uint16_t * _Nonnull MLAllocUInt16Buffer(NSUInteger size);
+void MLFreeUInt16Buffer(uint16_t * _Nonnull buffer);
+
+// Number of buffers allocated since program start, counted
+// in debug builds only (always 0 in release builds)
+NSUInteger MLAllocBufferCount(void);
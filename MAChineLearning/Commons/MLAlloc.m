@@ -37,6 +37,14 @@
 #define ALLOC_EXCEPTION_NAME               (@"MLAllocException")
 
 
+#pragma mark -
+#pragma mark Statics
+
+#if DEBUG
+static volatile long __allocCount= 0;
+#endif
+
+
 void *MLAllocBuffer(NSUInteger itemSize, NSUInteger items, NSString *errorReason) {
     void *buffer= NULL;
     
@@ -46,6 +54,10 @@ void *MLAllocBuffer(NSUInteger itemSize, NSUInteger items, NSString *errorReason
                                        reason:errorReason
                                      userInfo:@{@"error": @(err)}];
     
+#if DEBUG
+    __sync_fetch_and_add(&__allocCount, 1);
+#endif
+    
     return buffer;
 }
 
@@ -80,3 +92,26 @@ void MLFreeIntBuffer(int *buffer) {
     MLFreeBuffer(buffer);
 }
 
+int8_t *MLAllocInt8Buffer(NSUInteger size) {
+    return MLAllocBuffer(sizeof(int8_t), size, @"Error while allocating a buffer of 8-bit ints");
+}
+
+void MLFreeInt8Buffer(int8_t *buffer) {
+    MLFreeBuffer(buffer);
+}
+
+uint16_t *MLAllocUInt16Buffer(NSUInteger size) {
+    return MLAllocBuffer(sizeof(uint16_t), size, @"Error while allocating a buffer of 16-bit words");
+}
+
+void MLFreeUInt16Buffer(uint16_t *buffer) {
+    MLFreeBuffer(buffer);
+}
+
+NSUInteger MLAllocBufferCount() {
+#if DEBUG
+    return (NSUInteger) __allocCount;
+#else
+    return 0;
+#endif
+}
@@ -34,14 +34,49 @@
 #ifndef MAChineLearning_MLReal_h
 #define MAChineLearning_MLReal_h
 
+
+/* Vector kernels are provided by Accelerate on Apple platforms,
+ * elsewhere (or if ML_PORTABLE_KERNELS is defined) by the portable
+ * kernels of MLVectorKernels.h. With ML_USE_CBLAS defined, portable
+ * kernels use the system CBLAS for matrix operations.
+ */
+
+#if defined(__APPLE__) && !defined(ML_PORTABLE_KERNELS)
+
+#define ML_USE_ACCELERATE
+
 #import <Accelerate/Accelerate.h>
 
+#define ML_VABSI        vDSP_vabsi
+#define ML_VSDIVI       vDSP_vsdivi
+
+#else // defined(__APPLE__) && !defined(ML_PORTABLE_KERNELS)
+
+#import "MLVectorKernels.h"
+
+#ifdef ML_USE_CBLAS
+#include <cblas.h>
+#else
+#define CblasRowMajor   MLVKRowMajor
+#define CblasColMajor   MLVKColMajor
+#define CblasNoTrans    MLVKNoTrans
+#define CblasTrans      MLVKTrans
+#define CblasConjTrans  MLVKConjTrans
+#endif
+
+#define ML_VABSI        MLVK_vabsi
+#define ML_VSDIVI       MLVK_vsdivi
+
+#endif // defined(__APPLE__) && !defined(ML_PORTABLE_KERNELS)
+
 
 /* Uncomment to use double precision.
  * Beware: it is much slower.
- 
+
 typedef double          MLReal;
 
+#ifdef ML_USE_ACCELERATE
+
 #define ML_VCLR         vDSP_vclrD
 #define ML_VFILL        vDSP_vfillD
 #define ML_VCLIP        vDSP_vclipD
@@ -60,35 +95,92 @@ typedef double          MLReal;
 #define ML_VADD         vDSP_vaddD
 #define ML_VSUB         vDSP_vsubD
 #define ML_VDIV         vDSP_vdivD
-#define ML_VMA		    vDSP_vmaD
+#define ML_VMA          vDSP_vmaD
 #define ML_VSMA         vDSP_vsmaD
-#define ML_SVE		    vDSP_sveD
+#define ML_SVE          vDSP_sveD
 #define ML_SVESQ        vDSP_svesqD
 #define ML_VGATHRA      vDSP_vgathraD
-#define ML_SVE          vDSP_sveD
 #define ML_DIST         vDSP_vdistD
 #define ML_VGEN         vDSP_vgenD
 #define ML_VFRAC        vDSP_vfracD
 #define ML_VFLT32       vDSP_vflt32D
- 
+#define ML_VMAXMGV      vDSP_maxmgvD
+
+#define ML_GEMM         cblas_dgemm
+#define ML_GEMV         cblas_dgemv
+#define ML_GER          cblas_dger
+
 #define ML_VVEXP        vvexp
 #define ML_VVLOG        vvlog
 #define ML_VVSQRT       vvsqrt
 #define ML_VVSIN        vvsin
 #define ML_VVCOS        vvcos
- 
+
+#else // ML_USE_ACCELERATE
+
+#define ML_VCLR         MLVK_vclrD
+#define ML_VFILL        MLVK_vfillD
+#define ML_VCLIP        MLVK_vclipD
+#define ML_VICLIP       MLVK_viclipD
+#define ML_VTHR         MLVK_vthrD
+#define ML_VTHRSC       MLVK_vthrscD
+#define ML_VTHRES       MLVK_vthresD
+#define ML_VABS         MLVK_vabsD
+#define ML_VSMUL        MLVK_vsmulD
+#define ML_VSDIV        MLVK_vsdivD
+#define ML_SVDIV        MLVK_svdivD
+#define ML_VSADD        MLVK_vsaddD
+#define ML_DOTPR        MLVK_dotprD
+#define ML_VSQ          MLVK_vsqD
+#define ML_VMUL         MLVK_vmulD
+#define ML_VADD         MLVK_vaddD
+#define ML_VSUB         MLVK_vsubD
+#define ML_VDIV         MLVK_vdivD
+#define ML_VMA          MLVK_vmaD
+#define ML_VSMA         MLVK_vsmaD
+#define ML_SVE          MLVK_sveD
+#define ML_SVESQ        MLVK_svesqD
+#define ML_VGATHRA      MLVK_vgathraD
+#define ML_DIST         MLVK_vdistD
+#define ML_VGEN         MLVK_vgenD
+#define ML_VFRAC        MLVK_vfracD
+#define ML_VFLT32       MLVK_vflt32D
+#define ML_VMAXMGV      MLVK_maxmgvD
+
+#ifdef ML_USE_CBLAS
+#define ML_GEMM         cblas_dgemm
+#define ML_GEMV         cblas_dgemv
+#define ML_GER          cblas_dger
+#else
+#define ML_GEMM         MLVK_gemmD
+#define ML_GEMV         MLVK_gemvD
+#define ML_GER          MLVK_gerD
+#endif
+
+#define ML_VVEXP        MLVK_vvexpD
+#define ML_VVLOG        MLVK_vvlogD
+#define ML_VVSQRT       MLVK_vvsqrtD
+#define ML_VVSIN        MLVK_vvsinD
+#define ML_VVCOS        MLVK_vvcosD
+
+#endif // ML_USE_ACCELERATE
+
 #define ML_SQRT         sqrt
 #define ML_LOG          log
+#define ML_EXP          exp
 #define ML_COS          cos
 #define ML_SIN          sin
 #define ML_MODF         modf
 #define ML_POW          pow
- 
+#define ML_ABS          fabs
+
  */
 
 
 typedef float           MLReal;
 
+#ifdef ML_USE_ACCELERATE
+
 #define ML_VCLR         vDSP_vclr
 #define ML_VFILL        vDSP_vfill
 #define ML_VCLIP        vDSP_vclip
@@ -107,16 +199,20 @@ typedef float           MLReal;
 #define ML_VADD         vDSP_vadd
 #define ML_VSUB         vDSP_vsub
 #define ML_VDIV         vDSP_vdiv
-#define ML_VMA		    vDSP_vma
+#define ML_VMA          vDSP_vma
 #define ML_VSMA         vDSP_vsma
-#define ML_SVE		    vDSP_sve
+#define ML_SVE          vDSP_sve
 #define ML_SVESQ        vDSP_svesq
 #define ML_VGATHRA      vDSP_vgathra
-#define ML_SVE          vDSP_sve
 #define ML_DIST         vDSP_vdist
 #define ML_VGEN         vDSP_vgen
 #define ML_VFRAC        vDSP_vfrac
 #define ML_VFLT32       vDSP_vflt32
+#define ML_VMAXMGV      vDSP_maxmgv
+
+#define ML_GEMM         cblas_sgemm
+#define ML_GEMV         cblas_sgemv
+#define ML_GER          cblas_sger
 
 #define ML_VVEXP        vvexpf
 #define ML_VVLOG        vvlogf
@@ -124,11 +220,62 @@ typedef float           MLReal;
 #define ML_VVSIN        vvsinf
 #define ML_VVCOS        vvcosf
 
+#else // ML_USE_ACCELERATE
+
+#define ML_VCLR         MLVK_vclr
+#define ML_VFILL        MLVK_vfill
+#define ML_VCLIP        MLVK_vclip
+#define ML_VICLIP       MLVK_viclip
+#define ML_VTHR         MLVK_vthr
+#define ML_VTHRSC       MLVK_vthrsc
+#define ML_VTHRES       MLVK_vthres
+#define ML_VABS         MLVK_vabs
+#define ML_VSMUL        MLVK_vsmul
+#define ML_VSDIV        MLVK_vsdiv
+#define ML_SVDIV        MLVK_svdiv
+#define ML_VSADD        MLVK_vsadd
+#define ML_DOTPR        MLVK_dotpr
+#define ML_VSQ          MLVK_vsq
+#define ML_VMUL         MLVK_vmul
+#define ML_VADD         MLVK_vadd
+#define ML_VSUB         MLVK_vsub
+#define ML_VDIV         MLVK_vdiv
+#define ML_VMA          MLVK_vma
+#define ML_VSMA         MLVK_vsma
+#define ML_SVE          MLVK_sve
+#define ML_SVESQ        MLVK_svesq
+#define ML_VGATHRA      MLVK_vgathra
+#define ML_DIST         MLVK_vdist
+#define ML_VGEN         MLVK_vgen
+#define ML_VFRAC        MLVK_vfrac
+#define ML_VFLT32       MLVK_vflt32
+#define ML_VMAXMGV      MLVK_maxmgv
+
+#ifdef ML_USE_CBLAS
+#define ML_GEMM         cblas_sgemm
+#define ML_GEMV         cblas_sgemv
+#define ML_GER          cblas_sger
+#else
+#define ML_GEMM         MLVK_gemm
+#define ML_GEMV         MLVK_gemv
+#define ML_GER          MLVK_ger
+#endif
+
+#define ML_VVEXP        MLVK_vvexp
+#define ML_VVLOG        MLVK_vvlog
+#define ML_VVSQRT       MLVK_vvsqrt
+#define ML_VVSIN        MLVK_vvsin
+#define ML_VVCOS        MLVK_vvcos
+
+#endif // ML_USE_ACCELERATE
+
 #define ML_SQRT         sqrtf
 #define ML_LOG          logf
+#define ML_EXP          expf
 #define ML_COS          cosf
 #define ML_SIN          sinf
 #define ML_MODF         modff
 #define ML_POW          powf
+#define ML_ABS          fabsf
 
 #endif
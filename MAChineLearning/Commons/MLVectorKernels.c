@@ -0,0 +1,432 @@
+//
+//  MLVectorKernels.c
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "MLVectorKernels.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifdef ML_USE_CBLAS
+#include <cblas.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MLVK_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MLVK_NEON 1
+#include <arm_neon.h>
+#endif
+
+
+// Generic float primitives: plain loops, also used for remainders
+
+static float MLVKDotGeneric(const float *a, const float *b, MLVKLength n) {
+    float sum= 0.0f;
+    for (MLVKLength i= 0; i < n; i++)
+        sum += a[i] * b[i];
+    
+    return sum;
+}
+
+static void MLVKAxpyGeneric(float alpha, const float *x, float *y, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+static void MLVKAddGeneric(const float *a, const float *b, float *c, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        c[i]= a[i] + b[i];
+}
+
+static void MLVKMulGeneric(const float *a, const float *b, float *c, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        c[i]= a[i] * b[i];
+}
+
+static void MLVKScaleGeneric(const float *a, float s, float *c, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        c[i]= a[i] * s;
+}
+
+
+#ifdef MLVK_X86
+
+// AVX2 float primitives, with two accumulators to hide FMA latency
+
+__attribute__((target("avx2,fma")))
+static float MLVKDotAVX2(const float *a, const float *b, MLVKLength n) {
+    __m256 acc0= _mm256_setzero_ps();
+    __m256 acc1= _mm256_setzero_ps();
+    
+    MLVKLength i= 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0= _mm256_fmadd_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i]), acc0);
+        acc1= _mm256_fmadd_ps(_mm256_loadu_ps(&a[i + 8]), _mm256_loadu_ps(&b[i + 8]), acc1);
+    }
+    
+    for (; i + 8 <= n; i += 8)
+        acc0= _mm256_fmadd_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i]), acc0);
+    
+    // Horizontal sum of the accumulators
+    acc0= _mm256_add_ps(acc0, acc1);
+    
+    __m128 sum= _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    sum= _mm_hadd_ps(sum, sum);
+    sum= _mm_hadd_ps(sum, sum);
+    
+    return _mm_cvtss_f32(sum) + MLVKDotGeneric(&a[i], &b[i], n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void MLVKAxpyAVX2(float alpha, const float *x, float *y, MLVKLength n) {
+    __m256 va= _mm256_set1_ps(alpha);
+    
+    MLVKLength i= 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(&y[i], _mm256_fmadd_ps(va, _mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&y[i])));
+    
+    MLVKAxpyGeneric(alpha, &x[i], &y[i], n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void MLVKAddAVX2(const float *a, const float *b, float *c, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(&c[i], _mm256_add_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i])));
+    
+    MLVKAddGeneric(&a[i], &b[i], &c[i], n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void MLVKMulAVX2(const float *a, const float *b, float *c, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(&c[i], _mm256_mul_ps(_mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i])));
+    
+    MLVKMulGeneric(&a[i], &b[i], &c[i], n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void MLVKScaleAVX2(const float *a, float s, float *c, MLVKLength n) {
+    __m256 vs= _mm256_set1_ps(s);
+    
+    MLVKLength i= 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(&c[i], _mm256_mul_ps(_mm256_loadu_ps(&a[i]), vs));
+    
+    MLVKScaleGeneric(&a[i], s, &c[i], n - i);
+}
+
+
+// AVX-512 float primitives, remainders use masked loads and stores
+
+static inline __mmask16 MLVKTailMask(MLVKLength remaining) {
+    return (__mmask16) ((1u << remaining) - 1u);
+}
+
+__attribute__((target("avx512f")))
+static float MLVKDotAVX512(const float *a, const float *b, MLVKLength n) {
+    __m512 acc0= _mm512_setzero_ps();
+    __m512 acc1= _mm512_setzero_ps();
+    
+    MLVKLength i= 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0= _mm512_fmadd_ps(_mm512_loadu_ps(&a[i]), _mm512_loadu_ps(&b[i]), acc0);
+        acc1= _mm512_fmadd_ps(_mm512_loadu_ps(&a[i + 16]), _mm512_loadu_ps(&b[i + 16]), acc1);
+    }
+    
+    for (; i + 16 <= n; i += 16)
+        acc0= _mm512_fmadd_ps(_mm512_loadu_ps(&a[i]), _mm512_loadu_ps(&b[i]), acc0);
+    
+    if (i < n) {
+        __mmask16 mask= MLVKTailMask(n - i);
+        acc1= _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, &a[i]), _mm512_maskz_loadu_ps(mask, &b[i]), acc1);
+    }
+    
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+static void MLVKAxpyAVX512(float alpha, const float *x, float *y, MLVKLength n) {
+    __m512 va= _mm512_set1_ps(alpha);
+    
+    MLVKLength i= 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(&y[i], _mm512_fmadd_ps(va, _mm512_loadu_ps(&x[i]), _mm512_loadu_ps(&y[i])));
+    
+    if (i < n) {
+        __mmask16 mask= MLVKTailMask(n - i);
+        _mm512_mask_storeu_ps(&y[i], mask, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(mask, &x[i]), _mm512_maskz_loadu_ps(mask, &y[i])));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void MLVKAddAVX512(const float *a, const float *b, float *c, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(&c[i], _mm512_add_ps(_mm512_loadu_ps(&a[i]), _mm512_loadu_ps(&b[i])));
+    
+    if (i < n) {
+        __mmask16 mask= MLVKTailMask(n - i);
+        _mm512_mask_storeu_ps(&c[i], mask, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, &a[i]), _mm512_maskz_loadu_ps(mask, &b[i])));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void MLVKMulAVX512(const float *a, const float *b, float *c, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(&c[i], _mm512_mul_ps(_mm512_loadu_ps(&a[i]), _mm512_loadu_ps(&b[i])));
+    
+    if (i < n) {
+        __mmask16 mask= MLVKTailMask(n - i);
+        _mm512_mask_storeu_ps(&c[i], mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &a[i]), _mm512_maskz_loadu_ps(mask, &b[i])));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void MLVKScaleAVX512(const float *a, float s, float *c, MLVKLength n) {
+    __m512 vs= _mm512_set1_ps(s);
+    
+    MLVKLength i= 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(&c[i], _mm512_mul_ps(_mm512_loadu_ps(&a[i]), vs));
+    
+    if (i < n) {
+        __mmask16 mask= MLVKTailMask(n - i);
+        _mm512_mask_storeu_ps(&c[i], mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, &a[i]), vs));
+    }
+}
+
+#endif // MLVK_X86
+
+
+#ifdef MLVK_NEON
+
+// NEON float primitives
+
+static float MLVKDotNEON(const float *a, const float *b, MLVKLength n) {
+    float32x4_t acc0= vdupq_n_f32(0.0f);
+    float32x4_t acc1= vdupq_n_f32(0.0f);
+    
+    MLVKLength i= 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0= vfmaq_f32(acc0, vld1q_f32(&a[i]), vld1q_f32(&b[i]));
+        acc1= vfmaq_f32(acc1, vld1q_f32(&a[i + 4]), vld1q_f32(&b[i + 4]));
+    }
+    
+    return vaddvq_f32(vaddq_f32(acc0, acc1)) + MLVKDotGeneric(&a[i], &b[i], n - i);
+}
+
+static void MLVKAxpyNEON(float alpha, const float *x, float *y, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(&y[i], vfmaq_n_f32(vld1q_f32(&y[i]), vld1q_f32(&x[i]), alpha));
+    
+    MLVKAxpyGeneric(alpha, &x[i], &y[i], n - i);
+}
+
+static void MLVKAddNEON(const float *a, const float *b, float *c, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(&c[i], vaddq_f32(vld1q_f32(&a[i]), vld1q_f32(&b[i])));
+    
+    MLVKAddGeneric(&a[i], &b[i], &c[i], n - i);
+}
+
+static void MLVKMulNEON(const float *a, const float *b, float *c, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(&c[i], vmulq_f32(vld1q_f32(&a[i]), vld1q_f32(&b[i])));
+    
+    MLVKMulGeneric(&a[i], &b[i], &c[i], n - i);
+}
+
+static void MLVKScaleNEON(const float *a, float s, float *c, MLVKLength n) {
+    MLVKLength i= 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(&c[i], vmulq_n_f32(vld1q_f32(&a[i]), s));
+    
+    MLVKScaleGeneric(&a[i], s, &c[i], n - i);
+}
+
+#endif // MLVK_NEON
+
+
+// Dispatch of float primitives
+
+typedef struct {
+    const char *name;
+    
+    float (*dot)(const float *a, const float *b, MLVKLength n);
+    void (*axpy)(float alpha, const float *x, float *y, MLVKLength n);
+    void (*add)(const float *a, const float *b, float *c, MLVKLength n);
+    void (*mul)(const float *a, const float *b, float *c, MLVKLength n);
+    void (*scale)(const float *a, float s, float *c, MLVKLength n);
+} MLVKFloatPrimitives;
+
+#if defined(MLVK_NEON)
+static MLVKFloatPrimitives __primitives= { "NEON", MLVKDotNEON, MLVKAxpyNEON, MLVKAddNEON, MLVKMulNEON, MLVKScaleNEON };
+#else
+static MLVKFloatPrimitives __primitives= { "Generic", MLVKDotGeneric, MLVKAxpyGeneric, MLVKAddGeneric, MLVKMulGeneric, MLVKScaleGeneric };
+#endif
+
+#ifdef MLVK_X86
+
+// The instruction set is selected once, when the library is loaded
+__attribute__((constructor))
+static void MLVKSelectPrimitives(void) {
+    __builtin_cpu_init();
+    
+    if (__builtin_cpu_supports("avx512f")) {
+        MLVKFloatPrimitives primitives= { "AVX-512", MLVKDotAVX512, MLVKAxpyAVX512, MLVKAddAVX512, MLVKMulAVX512, MLVKScaleAVX512 };
+        __primitives= primitives;
+        
+    } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        MLVKFloatPrimitives primitives= { "AVX2", MLVKDotAVX2, MLVKAxpyAVX2, MLVKAddAVX2, MLVKMulAVX2, MLVKScaleAVX2 };
+        __primitives= primitives;
+    }
+}
+
+#endif // MLVK_X86
+
+const char *MLVKInstructionSet(void) {
+    return __primitives.name;
+}
+
+static inline float MLVKFloatDot(const float *a, const float *b, MLVKLength n) {
+#ifdef ML_USE_CBLAS
+    return cblas_sdot((int) n, a, 1, b, 1);
+#else
+    return __primitives.dot(a, b, n);
+#endif
+}
+
+static inline void MLVKFloatAxpy(float alpha, const float *x, float *y, MLVKLength n) {
+    __primitives.axpy(alpha, x, y, n);
+}
+
+static inline void MLVKFloatAdd(const float *a, const float *b, float *c, MLVKLength n) {
+    __primitives.add(a, b, c, n);
+}
+
+static inline void MLVKFloatMul(const float *a, const float *b, float *c, MLVKLength n) {
+    __primitives.mul(a, b, c, n);
+}
+
+static inline void MLVKFloatScale(const float *a, float s, float *c, MLVKLength n) {
+    __primitives.scale(a, s, c, n);
+}
+
+
+// Double primitives: plain loops, left to the compiler's vectorizer
+
+static inline double MLVKDoubleDot(const double *a, const double *b, MLVKLength n) {
+#ifdef ML_USE_CBLAS
+    return cblas_ddot((int) n, a, 1, b, 1);
+#else
+    double sum= 0.0;
+    for (MLVKLength i= 0; i < n; i++)
+        sum += a[i] * b[i];
+    
+    return sum;
+#endif
+}
+
+static inline void MLVKDoubleAxpy(double alpha, const double *x, double *y, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        y[i] += alpha * x[i];
+}
+
+static inline void MLVKDoubleAdd(const double *a, const double *b, double *c, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        c[i]= a[i] + b[i];
+}
+
+static inline void MLVKDoubleMul(const double *a, const double *b, double *c, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        c[i]= a[i] * b[i];
+}
+
+static inline void MLVKDoubleScale(const double *a, double s, double *c, MLVKLength n) {
+    for (MLVKLength i= 0; i < n; i++)
+        c[i]= a[i] * s;
+}
+
+
+// Single precision kernels
+
+#define R               float
+#define K(name)         MLVK_ ## name
+#define P(name)         MLVKFloat ## name
+#define M(name)         name ## f
+
+#include "MLVectorKernelsTemplate.h"
+
+#undef R
+#undef K
+#undef P
+#undef M
+
+
+// Double precision kernels
+
+#define R               double
+#define K(name)         MLVK_ ## name ## D
+#define P(name)         MLVKDouble ## name
+#define M(name)         name
+
+#include "MLVectorKernelsTemplate.h"
+
+#undef R
+#undef K
+#undef P
+#undef M
+
+
+// Integer kernels
+
+void MLVK_vabsi(const int *A, MLVKStride IA, int *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++) {
+        int a= A[n * IA];
+        C[n * IC]= (a < 0) ? -a : a;
+    }
+}
+
+void MLVK_vsdivi(const int *A, MLVKStride IA, const int *B, int *C, MLVKStride IC, MLVKLength N) {
+    int b= *B;
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= A[n * IA] / b;
+}
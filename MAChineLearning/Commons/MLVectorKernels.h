@@ -0,0 +1,173 @@
+//
+//  MLVectorKernels.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MAChineLearning_MLVectorKernels_h
+#define MAChineLearning_MLVectorKernels_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Nullability qualifiers are supported by clang only
+#if !defined(__clang__) && !defined(_Nonnull)
+#define _Nonnull
+#endif
+
+// Portable vector kernels, used by MLReal.h where Accelerate is not
+// available (or when ML_PORTABLE_KERNELS is defined). Each kernel has the
+// same arguments and semantics of its Accelerate counterpart, e.g.
+// MLVK_vadd() behaves as vDSP_vadd() and MLVK_vaddD() as vDSP_vaddD().
+// Float kernels are hand-vectorized: AVX-512 or AVX2 is selected at
+// runtime on x86-64, NEON is used on arm64, plain loops elsewhere.
+// Define ML_USE_CBLAS to compute dot products with the system CBLAS.
+
+typedef long MLVKStride;
+typedef unsigned long MLVKLength;
+
+// CBLAS values for order and transpose arguments
+enum {
+    MLVKRowMajor= 101,
+    MLVKColMajor= 102
+};
+
+enum {
+    MLVKNoTrans= 111,
+    MLVKTrans= 112,
+    MLVKConjTrans= 113
+};
+
+
+// Single precision kernels
+
+// vDSP counterparts
+void MLVK_vclr(float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vfill(const float * _Nonnull A, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vclip(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, const float * _Nonnull C, float * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_viclip(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, const float * _Nonnull C, float * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_vthr(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vthrsc(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, const float * _Nonnull C, float * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_vthres(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vabs(const float * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsmul(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsdiv(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_svdiv(const float * _Nonnull A, const float * _Nonnull B, MLVKStride IB, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsadd(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_dotpr(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, MLVKStride IB, float * _Nonnull C, MLVKLength N);
+void MLVK_vsq(const float * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vmul(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, MLVKStride IB, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vadd(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, MLVKStride IB, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsub(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, MLVKStride IB, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vdiv(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, MLVKStride IB, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vma(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, MLVKStride IB, const float * _Nonnull C, MLVKStride IC, float * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_vsma(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, const float * _Nonnull C, MLVKStride IC, float * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_sve(const float * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKLength N);
+void MLVK_svesq(const float * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKLength N);
+void MLVK_maxmgv(const float * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKLength N);
+void MLVK_vgathra(const float * _Nonnull * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vdist(const float * _Nonnull A, MLVKStride IA, const float * _Nonnull B, MLVKStride IB, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vgen(const float * _Nonnull A, const float * _Nonnull B, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vfrac(const float * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vflt32(const int * _Nonnull A, MLVKStride IA, float * _Nonnull C, MLVKStride IC, MLVKLength N);
+
+// CBLAS counterparts
+void MLVK_gemm(int order, int transA, int transB, int M, int N, int K, float alpha, const float * _Nonnull A, int lda, const float * _Nonnull B, int ldb, float beta, float * _Nonnull C, int ldc);
+void MLVK_gemv(int order, int trans, int M, int N, float alpha, const float * _Nonnull A, int lda, const float * _Nonnull X, int incX, float beta, float * _Nonnull Y, int incY);
+void MLVK_ger(int order, int M, int N, float alpha, const float * _Nonnull X, int incX, const float * _Nonnull Y, int incY, float * _Nonnull A, int lda);
+
+// vForce counterparts
+void MLVK_vvexp(float * _Nonnull Y, const float * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvlog(float * _Nonnull Y, const float * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvsqrt(float * _Nonnull Y, const float * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvsin(float * _Nonnull Y, const float * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvcos(float * _Nonnull Y, const float * _Nonnull X, const int * _Nonnull N);
+
+// Integer kernels
+void MLVK_vabsi(const int * _Nonnull A, MLVKStride IA, int * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsdivi(const int * _Nonnull A, MLVKStride IA, const int * _Nonnull B, int * _Nonnull C, MLVKStride IC, MLVKLength N);
+
+
+// Double precision kernels
+
+// vDSP counterparts
+void MLVK_vclrD(double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vfillD(const double * _Nonnull A, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vclipD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, const double * _Nonnull C, double * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_viclipD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, const double * _Nonnull C, double * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_vthrD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vthrscD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, const double * _Nonnull C, double * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_vthresD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vabsD(const double * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsmulD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsdivD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_svdivD(const double * _Nonnull A, const double * _Nonnull B, MLVKStride IB, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsaddD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_dotprD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, MLVKStride IB, double * _Nonnull C, MLVKLength N);
+void MLVK_vsqD(const double * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vmulD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, MLVKStride IB, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vaddD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, MLVKStride IB, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vsubD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, MLVKStride IB, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vdivD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, MLVKStride IB, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vmaD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, MLVKStride IB, const double * _Nonnull C, MLVKStride IC, double * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_vsmaD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, const double * _Nonnull C, MLVKStride IC, double * _Nonnull D, MLVKStride ID, MLVKLength N);
+void MLVK_sveD(const double * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKLength N);
+void MLVK_svesqD(const double * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKLength N);
+void MLVK_maxmgvD(const double * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKLength N);
+void MLVK_vgathraD(const double * _Nonnull * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vdistD(const double * _Nonnull A, MLVKStride IA, const double * _Nonnull B, MLVKStride IB, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vgenD(const double * _Nonnull A, const double * _Nonnull B, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vfracD(const double * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+void MLVK_vflt32D(const int * _Nonnull A, MLVKStride IA, double * _Nonnull C, MLVKStride IC, MLVKLength N);
+
+// CBLAS counterparts
+void MLVK_gemmD(int order, int transA, int transB, int M, int N, int K, double alpha, const double * _Nonnull A, int lda, const double * _Nonnull B, int ldb, double beta, double * _Nonnull C, int ldc);
+void MLVK_gemvD(int order, int trans, int M, int N, double alpha, const double * _Nonnull A, int lda, const double * _Nonnull X, int incX, double beta, double * _Nonnull Y, int incY);
+void MLVK_gerD(int order, int M, int N, double alpha, const double * _Nonnull X, int incX, const double * _Nonnull Y, int incY, double * _Nonnull A, int lda);
+
+// vForce counterparts
+void MLVK_vvexpD(double * _Nonnull Y, const double * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvlogD(double * _Nonnull Y, const double * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvsqrtD(double * _Nonnull Y, const double * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvsinD(double * _Nonnull Y, const double * _Nonnull X, const int * _Nonnull N);
+void MLVK_vvcosD(double * _Nonnull Y, const double * _Nonnull X, const int * _Nonnull N);
+
+
+// Name of the instruction set selected for float
+// kernels: "AVX-512", "AVX2", "NEON" or "Generic"
+const char * _Nonnull MLVKInstructionSet(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,435 @@
+//
+//  MLVectorKernelsTemplate.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+// Template of the portable kernels, included by MLVectorKernels.c
+// once for each precision with the following macros defined:
+// - R: the real type;
+// - K(name): the public name of a kernel;
+// - P(name): the name of a contiguous primitive (Dot, Axpy, Add, Mul, Scale);
+// - M(name): the name of a math library function for the real type.
+//
+// Strides follow vDSP: element n of A is A[n * IA], with any sign.
+
+
+// vDSP counterparts
+
+void K(vclr)(R *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= 0;
+}
+
+void K(vfill)(const R *A, R *C, MLVKStride IC, MLVKLength N) {
+    R a= *A;
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= a;
+}
+
+void K(vclip)(const R *A, MLVKStride IA, const R *B, const R *C, R *D, MLVKStride ID, MLVKLength N) {
+    R low= *B;
+    R high= *C;
+    
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= A[n * IA];
+        D[n * ID]= (a < low) ? low : ((a > high) ? high : a);
+    }
+}
+
+void K(viclip)(const R *A, MLVKStride IA, const R *B, const R *C, R *D, MLVKStride ID, MLVKLength N) {
+    R low= *B;
+    R high= *C;
+    
+    // Values inside the range are pushed to its nearest end
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= A[n * IA];
+        D[n * ID]= ((a <= low) || (a >= high)) ? a : ((a < 0) ? low : high);
+    }
+}
+
+void K(vthr)(const R *A, MLVKStride IA, const R *B, R *C, MLVKStride IC, MLVKLength N) {
+    R threshold= *B;
+    
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= A[n * IA];
+        C[n * IC]= (a >= threshold) ? a : threshold;
+    }
+}
+
+void K(vthrsc)(const R *A, MLVKStride IA, const R *B, const R *C, R *D, MLVKStride ID, MLVKLength N) {
+    R threshold= *B;
+    R c= *C;
+    
+    for (MLVKLength n= 0; n < N; n++)
+        D[n * ID]= (A[n * IA] >= threshold) ? c : -c;
+}
+
+void K(vthres)(const R *A, MLVKStride IA, const R *B, R *C, MLVKStride IC, MLVKLength N) {
+    R threshold= *B;
+    
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= A[n * IA];
+        C[n * IC]= (a >= threshold) ? a : 0;
+    }
+}
+
+void K(vabs)(const R *A, MLVKStride IA, R *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= M(fabs)(A[n * IA]);
+}
+
+void K(vsmul)(const R *A, MLVKStride IA, const R *B, R *C, MLVKStride IC, MLVKLength N) {
+    R b= *B;
+    
+    if ((IA == 1) && (IC == 1)) {
+        P(Scale)(A, b, C, N);
+        return;
+    }
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= A[n * IA] * b;
+}
+
+void K(vsdiv)(const R *A, MLVKStride IA, const R *B, R *C, MLVKStride IC, MLVKLength N) {
+    R b= *B;
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= A[n * IA] / b;
+}
+
+void K(svdiv)(const R *A, const R *B, MLVKStride IB, R *C, MLVKStride IC, MLVKLength N) {
+    R a= *A;
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= a / B[n * IB];
+}
+
+void K(vsadd)(const R *A, MLVKStride IA, const R *B, R *C, MLVKStride IC, MLVKLength N) {
+    R b= *B;
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= A[n * IA] + b;
+}
+
+void K(dotpr)(const R *A, MLVKStride IA, const R *B, MLVKStride IB, R *C, MLVKLength N) {
+    if ((IA == 1) && (IB == 1)) {
+        *C= P(Dot)(A, B, N);
+        return;
+    }
+    
+    R sum= 0;
+    for (MLVKLength n= 0; n < N; n++)
+        sum += A[n * IA] * B[n * IB];
+    
+    *C= sum;
+}
+
+void K(vsq)(const R *A, MLVKStride IA, R *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= A[n * IA];
+        C[n * IC]= a * a;
+    }
+}
+
+void K(vmul)(const R *A, MLVKStride IA, const R *B, MLVKStride IB, R *C, MLVKStride IC, MLVKLength N) {
+    if ((IA == 1) && (IB == 1) && (IC == 1)) {
+        P(Mul)(A, B, C, N);
+        return;
+    }
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= A[n * IA] * B[n * IB];
+}
+
+void K(vadd)(const R *A, MLVKStride IA, const R *B, MLVKStride IB, R *C, MLVKStride IC, MLVKLength N) {
+    if ((IA == 1) && (IB == 1) && (IC == 1)) {
+        P(Add)(A, B, C, N);
+        return;
+    }
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= A[n * IA] + B[n * IB];
+}
+
+void K(vsub)(const R *A, MLVKStride IA, const R *B, MLVKStride IB, R *C, MLVKStride IC, MLVKLength N) {
+    
+    // As in vDSP, A is subtracted from B
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= B[n * IB] - A[n * IA];
+}
+
+void K(vdiv)(const R *A, MLVKStride IA, const R *B, MLVKStride IB, R *C, MLVKStride IC, MLVKLength N) {
+    
+    // As in vDSP, B is divided by A
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= B[n * IB] / A[n * IA];
+}
+
+void K(vma)(const R *A, MLVKStride IA, const R *B, MLVKStride IB, const R *C, MLVKStride IC, R *D, MLVKStride ID, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++)
+        D[n * ID]= (A[n * IA] * B[n * IB]) + C[n * IC];
+}
+
+void K(vsma)(const R *A, MLVKStride IA, const R *B, const R *C, MLVKStride IC, R *D, MLVKStride ID, MLVKLength N) {
+    R b= *B;
+    
+    if ((IA == 1) && (IC == 1) && (ID == 1) && (C == D)) {
+        P(Axpy)(b, A, D, N);
+        return;
+    }
+    
+    for (MLVKLength n= 0; n < N; n++)
+        D[n * ID]= (A[n * IA] * b) + C[n * IC];
+}
+
+void K(sve)(const R *A, MLVKStride IA, R *C, MLVKLength N) {
+    R sum= 0;
+    for (MLVKLength n= 0; n < N; n++)
+        sum += A[n * IA];
+    
+    *C= sum;
+}
+
+void K(svesq)(const R *A, MLVKStride IA, R *C, MLVKLength N) {
+    if (IA == 1) {
+        *C= P(Dot)(A, A, N);
+        return;
+    }
+    
+    R sum= 0;
+    for (MLVKLength n= 0; n < N; n++)
+        sum += A[n * IA] * A[n * IA];
+    
+    *C= sum;
+}
+
+void K(maxmgv)(const R *A, MLVKStride IA, R *C, MLVKLength N) {
+    R max= 0;
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= M(fabs)(A[n * IA]);
+        max= (a > max) ? a : max;
+    }
+    
+    *C= max;
+}
+
+void K(vgathra)(const R **A, MLVKStride IA, R *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= *A[n * IA];
+}
+
+void K(vdist)(const R *A, MLVKStride IA, const R *B, MLVKStride IB, R *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= A[n * IA];
+        R b= B[n * IB];
+        C[n * IC]= M(sqrt)((a * a) + (b * b));
+    }
+}
+
+void K(vgen)(const R *A, const R *B, R *C, MLVKStride IC, MLVKLength N) {
+    R a= *A;
+    R step= (N > 1) ? ((*B - a) / (R) (N -1)) : 0;
+    
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= a + (step * (R) n);
+}
+
+void K(vfrac)(const R *A, MLVKStride IA, R *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++) {
+        R a= A[n * IA];
+        C[n * IC]= a - M(trunc)(a);
+    }
+}
+
+void K(vflt32)(const int *A, MLVKStride IA, R *C, MLVKStride IC, MLVKLength N) {
+    for (MLVKLength n= 0; n < N; n++)
+        C[n * IC]= (R) A[n * IA];
+}
+
+
+// CBLAS counterparts
+
+void K(gemm)(int order, int transA, int transB, int M, int N, int K, R alpha, const R *A, int lda, const R *B, int ldb, R beta, R *C, int ldc) {
+    
+    // Column-major is computed as row-major on the transposed result:
+    // C^T = op(B)^T x op(A)^T
+    if (order == MLVKColMajor) {
+        K(gemm)(MLVKRowMajor, transB, transA, N, M, K, alpha, B, ldb, A, lda, beta, C, ldc);
+        return;
+    }
+    
+    int tA= (transA != MLVKNoTrans);
+    int tB= (transB != MLVKNoTrans);
+    
+    for (int i= 0; i < M; i++) {
+        R *rowC= &C[i * ldc];
+        
+        // First step: scale C by beta (with beta 0 C is not read)
+        if (beta == 0) {
+            for (int j= 0; j < N; j++)
+                rowC[j]= 0;
+            
+        } else if (beta != 1)
+            P(Scale)(rowC, beta, rowC, N);
+        
+        // Second step: accumulate alpha * op(A) x op(B) on row i,
+        // choosing the loop order that keeps memory access contiguous
+        if (!tB) {
+            
+            // Rows of B are contiguous: axpy each of them
+            for (int k= 0; k < K; k++) {
+                R a= tA ? A[k * lda + i] : A[i * lda + k];
+                
+                P(Axpy)(alpha * a, &B[k * ldb], rowC, N);
+            }
+            
+        } else if (!tA) {
+            
+            // Both row i of A and rows of B^T are contiguous: dot them
+            for (int j= 0; j < N; j++)
+                rowC[j] += alpha * P(Dot)(&A[i * lda], &B[j * ldb], K);
+            
+        } else {
+            for (int j= 0; j < N; j++) {
+                R sum= 0;
+                for (int k= 0; k < K; k++)
+                    sum += A[k * lda + i] * B[j * ldb + k];
+                
+                rowC[j] += alpha * sum;
+            }
+        }
+    }
+}
+
+void K(gemv)(int order, int trans, int M, int N, R alpha, const R *A, int lda, const R *X, int incX, R beta, R *Y, int incY) {
+    
+    // Column-major is the transpose of row-major
+    if (order == MLVKColMajor) {
+        K(gemv)(MLVKRowMajor, (trans == MLVKNoTrans) ? MLVKTrans : MLVKNoTrans, N, M, alpha, A, lda, X, incX, beta, Y, incY);
+        return;
+    }
+    
+    int t= (trans != MLVKNoTrans);
+    int sizeY= t ? N : M;
+    int sizeX= t ? M : N;
+    
+    // First step: scale Y by beta (with beta 0 Y is not read)
+    for (int i= 0; i < sizeY; i++)
+        Y[i * incY]= (beta == 0) ? 0 : (beta * Y[i * incY]);
+    
+    // Second step: accumulate alpha * op(A) x X
+    if (!t) {
+        
+        // Y[i] += alpha * dot(row i, X)
+        for (int i= 0; i < M; i++) {
+            const R *row= &A[i * lda];
+            
+            R dot= 0;
+            if (incX == 1) {
+                dot= P(Dot)(row, X, N);
+                
+            } else {
+                for (int j= 0; j < N; j++)
+                    dot += row[j] * X[j * incX];
+            }
+            
+            Y[i * incY] += alpha * dot;
+        }
+        
+    } else {
+        
+        // Y += alpha * X[i] * row i
+        for (int i= 0; i < sizeX; i++) {
+            const R *row= &A[i * lda];
+            R a= alpha * X[i * incX];
+            
+            if (incY == 1) {
+                P(Axpy)(a, row, Y, N);
+                
+            } else {
+                for (int j= 0; j < N; j++)
+                    Y[j * incY] += a * row[j];
+            }
+        }
+    }
+}
+
+void K(ger)(int order, int M, int N, R alpha, const R *X, int incX, const R *Y, int incY, R *A, int lda) {
+    
+    // Column-major is the transpose of row-major
+    if (order == MLVKColMajor) {
+        K(ger)(MLVKRowMajor, N, M, alpha, Y, incY, X, incX, A, lda);
+        return;
+    }
+    
+    // Row i of A += alpha * X[i] * Y
+    for (int i= 0; i < M; i++) {
+        R *row= &A[i * lda];
+        R a= alpha * X[i * incX];
+        
+        if (incY == 1) {
+            P(Axpy)(a, Y, row, N);
+            
+        } else {
+            for (int j= 0; j < N; j++)
+                row[j] += a * Y[j * incY];
+        }
+    }
+}
+
+
+// vForce counterparts
+
+void K(vvexp)(R *Y, const R *X, const int *N) {
+    for (int n= 0; n < *N; n++)
+        Y[n]= M(exp)(X[n]);
+}
+
+void K(vvlog)(R *Y, const R *X, const int *N) {
+    for (int n= 0; n < *N; n++)
+        Y[n]= M(log)(X[n]);
+}
+
+void K(vvsqrt)(R *Y, const R *X, const int *N) {
+    for (int n= 0; n < *N; n++)
+        Y[n]= M(sqrt)(X[n]);
+}
+
+void K(vvsin)(R *Y, const R *X, const int *N) {
+    for (int n= 0; n < *N; n++)
+        Y[n]= M(sin)(X[n]);
+}
+
+void K(vvcos)(R *Y, const R *X, const int *N) {
+    for (int n= 0; n < *N; n++)
+        Y[n]= M(cos)(X[n]);
+}
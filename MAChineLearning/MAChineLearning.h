@@ -16,18 +16,30 @@ FOUNDATION_EXPORT const unsigned char MAChineLearningVersionString[];
 
 #import <MAChineLearning/MLReal.h>
 #import <MAChineLearning/MLAlloc.h>
+#import <MAChineLearning/MLVectorKernels.h>
 #import <MAChineLearning/MLNeuralNetwork.h>
 #import <MAChineLearning/MLNeuralNetwork.h>
+#import <MAChineLearning/MLNeuralNetworkContext.h>
+#import <MAChineLearning/MLQuantizedNeuralNetwork.h>
+#import <MAChineLearning/MLInferencePlan.h>
 #import <MAChineLearning/MLNeuralNetworkStatus.h>
 #import <MAChineLearning/MLActivationFunctionType.h>
 #import <MAChineLearning/MLBackPropagationType.h>
+#import <MAChineLearning/MLWeightsStorageType.h>
 #import <MAChineLearning/MLCostFunctionType.h>
+#import <MAChineLearning/MLSoftmaxTrainingType.h>
 #import <MAChineLearning/MLLayer.h>
 #import <MAChineLearning/MLInputLayer.h>
+#import <MAChineLearning/MLEmbeddingLayer.h>
+#import <MAChineLearning/MLEmbeddingPoolingType.h>
 #import <MAChineLearning/MLNeuronLayer.h>
 #import <MAChineLearning/MLNeuron.h>
 #import <MAChineLearning/MLBiasNeuron.h>
 #import <MAChineLearning/MLNeuralNetworkException.h>
+#import <MAChineLearning/MLParallelTrainer.h>
+#import <MAChineLearning/MLTrainer.h>
+#import <MAChineLearning/MLNeuralNetworkProfile.h>
+#import <MAChineLearning/MLProfilePhase.h>
 #import <MAChineLearning/MLBagOfWords.h>
 #import <MAChineLearning/MLBagOfWordsException.h>
 #import <MAChineLearning/MLWordExtractorType.h>
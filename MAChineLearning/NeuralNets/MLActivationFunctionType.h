@@ -40,7 +40,8 @@ typedef NS_ENUM(NSUInteger, MLActivationFunctionType) {
     MLActivationFunctionTypeRectifiedLinear,
 	MLActivationFunctionTypeStep,
 	MLActivationFunctionTypeSigmoid,
-	MLActivationFunctionTypeTanH
+	MLActivationFunctionTypeTanH,
+	MLActivationFunctionTypeSoftmax
 };
 
 
@@ -0,0 +1,58 @@
+//
+//  MLActivationKernels.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+#import "MLActivationFunctionType.h"
+
+
+// Activation kernels: each applies the function in place with a single
+// pass over the buffer; with fast set, exp is replaced by a polynomial
+// approximation (relative error below 1e-5)
+void MLActivateStep(MLReal * _Nonnull buffer, NSUInteger size);
+void MLActivateSigmoid(MLReal * _Nonnull buffer, NSUInteger size, BOOL fast);
+void MLActivateTanH(MLReal * _Nonnull buffer, NSUInteger size, BOOL fast);
+
+// Softmax kernel: the whole buffer is a single vector, whose
+// values are normalized to probabilities
+void MLActivateSoftmax(MLReal * _Nonnull buffer, NSUInteger size, BOOL fast);
+
+// Applies the kernel of the specified activation function
+void MLActivate(MLActivationFunctionType funcType, MLReal * _Nonnull buffer, NSUInteger size, BOOL fast);
+
+// Derivative kernels: each computes delta = f'(output) * error
+// with a single pass over the buffers
+void MLDeltaRectifiedLinear(const MLReal * _Nonnull outputBuffer, const MLReal * _Nonnull errorBuffer, MLReal * _Nonnull deltaBuffer, NSUInteger size);
+void MLDeltaSigmoid(const MLReal * _Nonnull outputBuffer, const MLReal * _Nonnull errorBuffer, MLReal * _Nonnull deltaBuffer, NSUInteger size);
+void MLDeltaTanH(const MLReal * _Nonnull outputBuffer, const MLReal * _Nonnull errorBuffer, MLReal * _Nonnull deltaBuffer, NSUInteger size);
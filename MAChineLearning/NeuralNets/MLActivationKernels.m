@@ -0,0 +1,270 @@
+//
+//  MLActivationKernels.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLActivationKernels.h"
+
+#define KERNEL_BLOCK_SIZE                (256)
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __minusFourty= -40.0;
+static const MLReal __minusTwo=     -2.0;
+static const MLReal __zero=          0.0;
+static const MLReal __half=          0.5;
+static const MLReal __one=           1.0;
+static const MLReal __fourty=       40.0;
+
+static const MLReal __log2e=         1.4426950408889634;
+static const MLReal __ln2=           0.6931471805599453;
+
+
+#pragma mark -
+#pragma mark Internals
+
+static inline MLReal MLClip(MLReal x) {
+    
+    // Clipping avoids NaNs and keeps the fast exp in range
+    return (x < __minusFourty) ? __minusFourty : ((x > __fourty) ? __fourty : x);
+}
+
+static inline MLReal MLExp2i(int n) {
+    
+    // Build 2^n directly in the exponent bits, the
+    // branch is resolved at compile time
+    if (sizeof(MLReal) == sizeof(float)) {
+        union { float f; int32_t i; } value;
+        value.i= ((int32_t) (n + 127)) << 23;
+        return (MLReal) value.f;
+        
+    } else {
+        union { double d; int64_t i; } value;
+        value.i= ((int64_t) (n + 1023)) << 52;
+        return (MLReal) value.d;
+    }
+}
+
+static inline MLReal MLFastExp(MLReal x) {
+    
+    // Range reduction: exp(x) = 2^n * exp(f), with n integer and |f| <= ln(2) / 2
+    MLReal t= x * __log2e;
+    int n= (int) (t + ((t < __zero) ? -__half : __half));
+    MLReal f= (t - (MLReal) n) * __ln2;
+    
+    // Polynomial approximation of exp(f)
+    MLReal p= __one + f * (__one + f * (0.5 + f * (0.16666666666666666 + f * (0.041666666666666664 + f * 0.008333333333333333))));
+    
+    return p * MLExp2i(n);
+}
+
+
+#pragma mark -
+#pragma mark Activation kernels
+
+void MLActivateStep(MLReal *buffer, NSUInteger size) {
+    
+    // Apply formula: output[i] = (output[i] < 0.5 ? 0.0 : 1.0)
+    for (NSUInteger i= 0; i < size; i++)
+        buffer[i]= (buffer[i] < __half) ? __zero : __one;
+}
+
+void MLActivateSigmoid(MLReal *buffer, NSUInteger size, BOOL fast) {
+    if (fast) {
+        
+        // Apply formula: output[i] = 1 / (1 + exp(-output[i])
+        for (NSUInteger i= 0; i < size; i++)
+            buffer[i]= __one / (__one + MLFastExp(-MLClip(buffer[i])));
+        
+        return;
+    }
+    
+    // Exact exp is computed with vvexp on blocks that fit
+    // in L1 cache, so the buffer is read and written only once
+    MLReal block[KERNEL_BLOCK_SIZE];
+    
+    for (NSUInteger offset= 0; offset < size; offset += KERNEL_BLOCK_SIZE) {
+        MLReal *output= &buffer[offset];
+        int blockSize= (int) MIN(KERNEL_BLOCK_SIZE, size - offset);
+        
+        for (int i= 0; i < blockSize; i++)
+            block[i]= -MLClip(output[i]);
+        
+        ML_VVEXP(block, block, &blockSize);
+        
+        // Apply formula: output[i] = 1 / (1 + exp(-output[i])
+        for (int i= 0; i < blockSize; i++)
+            output[i]= __one / (__one + block[i]);
+    }
+}
+
+void MLActivateTanH(MLReal *buffer, NSUInteger size, BOOL fast) {
+    if (fast) {
+        
+        // Apply formula: output[i] = (1 - exp(-2 * output[i])) / (1 + exp(-2 * output[i]))
+        for (NSUInteger i= 0; i < size; i++) {
+            MLReal expValue= MLFastExp(__minusTwo * MLClip(buffer[i]));
+            buffer[i]= (__one - expValue) / (__one + expValue);
+        }
+        
+        return;
+    }
+    
+    // Exact exp is computed with vvexp on blocks that fit
+    // in L1 cache, so the buffer is read and written only once
+    MLReal block[KERNEL_BLOCK_SIZE];
+    
+    for (NSUInteger offset= 0; offset < size; offset += KERNEL_BLOCK_SIZE) {
+        MLReal *output= &buffer[offset];
+        int blockSize= (int) MIN(KERNEL_BLOCK_SIZE, size - offset);
+        
+        for (int i= 0; i < blockSize; i++)
+            block[i]= __minusTwo * MLClip(output[i]);
+        
+        ML_VVEXP(block, block, &blockSize);
+        
+        // Apply formula: output[i] = (1 - exp(-2 * output[i])) / (1 + exp(-2 * output[i]))
+        for (int i= 0; i < blockSize; i++)
+            output[i]= (__one - block[i]) / (__one + block[i]);
+    }
+}
+
+void MLActivateSoftmax(MLReal *buffer, NSUInteger size, BOOL fast) {
+    
+    // Subtract the maximum first, so that exp never overflows
+    MLReal max= buffer[0];
+    for (NSUInteger i= 1; i < size; i++)
+        max= (buffer[i] > max) ? buffer[i] : max;
+    
+    MLReal sum= __zero;
+    
+    if (fast) {
+        
+        // Apply formula: output[i] = exp(output[i] - max)
+        for (NSUInteger i= 0; i < size; i++) {
+            buffer[i]= MLFastExp(MLClip(buffer[i] - max));
+            sum += buffer[i];
+        }
+        
+    } else {
+        
+        // Exact exp is computed with vvexp on blocks that fit
+        // in L1 cache, as for the other activation functions
+        for (NSUInteger offset= 0; offset < size; offset += KERNEL_BLOCK_SIZE) {
+            MLReal *output= &buffer[offset];
+            int blockSize= (int) MIN(KERNEL_BLOCK_SIZE, size - offset);
+            
+            for (int i= 0; i < blockSize; i++)
+                output[i]= MLClip(output[i] - max);
+            
+            ML_VVEXP(output, output, &blockSize);
+            
+            for (int i= 0; i < blockSize; i++)
+                sum += output[i];
+        }
+    }
+    
+    // Apply formula: output[i] = output[i] / Sum(output[j])
+    MLReal scale= __one / sum;
+    
+    ML_VSMUL(buffer, 1, &scale, buffer, 1, size);
+}
+
+void MLActivate(MLActivationFunctionType funcType, MLReal *buffer, NSUInteger size, BOOL fast) {
+    switch (funcType) {
+        case MLActivationFunctionTypeLinear: {
+            
+            // Apply formula: output[i] = output[i]
+            break;
+        }
+            
+        case MLActivationFunctionTypeRectifiedLinear: {
+            
+            // Apply formula: output[i] = (output[i] < 0.0 ? 0.0 : output[i])
+            ML_VTHRES(buffer, 1, &__zero, buffer, 1, size);
+            break;
+        }
+
+        case MLActivationFunctionTypeStep: {
+            
+            // Apply formula: output[i] = (output[i] < 0.5 ? 0.0 : 1.0)
+            MLActivateStep(buffer, size);
+            break;
+        }
+            
+        case MLActivationFunctionTypeSigmoid: {
+            
+            // Apply formula: output[i] = 1 / (1 + exp(-output[i])
+            MLActivateSigmoid(buffer, size, fast);
+            break;
+        }
+            
+        case MLActivationFunctionTypeTanH: {
+            
+            // Apply formula: output[i] = tanh(output[i])
+            MLActivateTanH(buffer, size, fast);
+            break;
+        }
+            
+        case MLActivationFunctionTypeSoftmax: {
+            
+            // Apply formula: output[i] = exp(output[i]) / Sum(exp(output[j]))
+            MLActivateSoftmax(buffer, size, fast);
+            break;
+        }
+    }
+}
+
+#pragma mark -
+#pragma mark Derivative kernels
+
+void MLDeltaRectifiedLinear(const MLReal *outputBuffer, const MLReal *errorBuffer, MLReal *deltaBuffer, NSUInteger size) {
+    
+    // Apply formula: delta[i] = (output[i] > 0.0 ? error[i] : 0.0)
+    for (NSUInteger i= 0; i < size; i++)
+        deltaBuffer[i]= (outputBuffer[i] > __zero) ? errorBuffer[i] : __zero;
+}
+
+void MLDeltaSigmoid(const MLReal *outputBuffer, const MLReal *errorBuffer, MLReal *deltaBuffer, NSUInteger size) {
+    
+    // Apply formula: delta[i] = output[i] * (1 - output[i]) * error[i]
+    for (NSUInteger i= 0; i < size; i++)
+        deltaBuffer[i]= outputBuffer[i] * (__one - outputBuffer[i]) * errorBuffer[i];
+}
+
+void MLDeltaTanH(const MLReal *outputBuffer, const MLReal *errorBuffer, MLReal *deltaBuffer, NSUInteger size) {
+    
+    // Apply formula: delta[i] = (1 - (output[i] * output[i])) * error[i]
+    for (NSUInteger i= 0; i < size; i++)
+        deltaBuffer[i]= (__one - (outputBuffer[i] * outputBuffer[i])) * errorBuffer[i];
+}
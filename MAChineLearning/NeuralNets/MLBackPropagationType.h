@@ -37,7 +37,12 @@
 
 typedef NS_ENUM(NSUInteger, MLBackPropagationType) {
 	MLBackPropagationTypeStandard= 0,
-	MLBackPropagationTypeResilient
+	MLBackPropagationTypeResilient,
+	MLBackPropagationTypeMomentum,
+	MLBackPropagationTypeNesterov,
+	MLBackPropagationTypeRMSProp,
+	MLBackPropagationTypeAdam,
+	MLBackPropagationTypeImprovedResilient
 };
 
 
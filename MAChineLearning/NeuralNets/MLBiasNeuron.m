@@ -62,12 +62,6 @@ static const MLReal __one=                    1.0;
 #pragma mark -
 #pragma mark Setup and randomization
 
-- (void) setUpForBackpropagationWithAlgorithm:(MLBackPropagationType)backPropType {
-    
-    // Use setup for basic backpropagation, to avoid wasting buffers for RPROP
-    [super setUpForBackpropagationWithAlgorithm:MLBackPropagationTypeStandard];
-}
-
 - (void) randomizeWeights {
     
     // Nothing to do, weights remain 0
@@ -88,6 +82,11 @@ static const MLReal __one=                    1.0;
     // Nothing to do, weights remain 0
 }
 
+- (void) backPropagateWithAlgorithm:(MLBackPropagationType)backPropType learningRate:(MLReal)learningRate gradient:(MLReal *)gradient {
+    
+    // Nothing to do, weights remain 0
+}
+
 - (void) updateWeights {
     
     // Nothing to do, weights remain 0
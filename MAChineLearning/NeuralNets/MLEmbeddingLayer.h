@@ -0,0 +1,101 @@
+//
+//  MLEmbeddingLayer.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+
+#import "MLInputLayer.h"
+#import "MLBackPropagationType.h"
+#import "MLEmbeddingPoolingType.h"
+
+
+@class MLWordDictionary;
+@class MLWordVectorDictionary;
+
+@interface MLEmbeddingLayer : MLInputLayer
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (nonnull instancetype) initWithIndex:(NSUInteger)index
+                                  size:(NSUInteger)size
+                                       NS_UNAVAILABLE;
+
+- (nonnull instancetype) initWithIndex:(NSUInteger)index
+                                  size:(NSUInteger)size
+                        vocabularySize:(NSUInteger)vocabularySize
+                           poolingType:(MLEmbeddingPoolingType)poolingType
+                                       NS_DESIGNATED_INITIALIZER;
+
+
+#pragma mark -
+#pragma mark Setup and randomization
+
+- (void) randomizeEmbeddings;
+
+- (NSUInteger) loadEmbeddingsFromWordVectorDictionary:(nonnull MLWordVectorDictionary *)vectorDictionary
+                                        wordDictionary:(nonnull MLWordDictionary *)wordDictionary;
+
+
+#pragma mark -
+#pragma mark Operations
+
+- (void) feedWordPositions:(nonnull const int *)positions
+                     count:(NSUInteger)count;
+
+- (void) poolWordPositions:(nonnull const int *)positions
+                     count:(NSUInteger)count
+              outputBuffer:(nonnull MLReal *)outputBuffer;
+
+- (void) clearWordPositions;
+
+- (void) backPropagateWithAlgorithm:(MLBackPropagationType)backPropType
+                       learningRate:(MLReal)learningRate;
+
+- (void) updateEmbeddings;
+
+
+#pragma mark -
+#pragma mark Properties
+
+@property (nonatomic, readonly) NSUInteger vocabularySize;
+@property (nonatomic, readonly) MLEmbeddingPoolingType poolingType;
+@property (nonatomic, assign) BOOL trainable;
+
+@property (nonatomic, readonly, nonnull) MLReal *embeddings;
+@property (nonatomic, readonly) NSUInteger wordCount;
+
+
+@end
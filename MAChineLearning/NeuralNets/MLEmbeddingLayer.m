@@ -0,0 +1,296 @@
+//
+//  MLEmbeddingLayer.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLEmbeddingLayer.h"
+#import "MLNeuronLayer.h"
+#import "MLNeuralNetworkException.h"
+#import "MLWordDictionary.h"
+#import "MLWordInfo.h"
+#import "MLWordVectorDictionary.h"
+#import "MLWordVector.h"
+
+#import "MLAlloc.h"
+#import "MLRandom.h"
+
+#define INITIAL_POSITIONS_CAPACITY          (64)
+
+
+#pragma mark -
+#pragma mark EmbeddingLayer extension
+
+@interface MLEmbeddingLayer () {
+    NSUInteger _vocabularySize;
+    MLEmbeddingPoolingType _poolingType;
+    BOOL _trainable;
+    
+    MLReal *_embeddings;
+    
+    NSUInteger _wordCount;
+    NSUInteger _positionsCapacity;
+    int *_positions;
+    
+    MLReal *_errorBuffer;
+    BOOL _updatePending;
+}
+
+
+@end
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __one=                1.0;
+
+
+#pragma mark -
+#pragma mark EmbeddingLayer implementation
+
+@implementation MLEmbeddingLayer
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (nonnull instancetype) initWithIndex:(NSUInteger)index size:(NSUInteger)size {
+    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"MLEmbeddingLayer class must be initialized properly"
+                                                             userInfo:nil];
+}
+
+- (instancetype) initWithIndex:(NSUInteger)index size:(NSUInteger)size vocabularySize:(NSUInteger)vocabularySize poolingType:(MLEmbeddingPoolingType)poolingType {
+    if ((self = [super initWithIndex:index size:size])) {
+        
+        // Initialization
+        _vocabularySize= vocabularySize;
+        _poolingType= poolingType;
+        _trainable= YES;
+    }
+    
+    return self;
+}
+
+- (void) dealloc {
+    
+    // Deallocate the embedding matrix
+    MLFreeRealBuffer(_embeddings);
+    _embeddings= NULL;
+    
+    // Deallocate buffers
+    MLFreeIntBuffer(_positions);
+    _positions= NULL;
+    
+    MLFreeRealBuffer(_errorBuffer);
+    _errorBuffer= NULL;
+}
+
+
+#pragma mark -
+#pragma mark Setup and randomization
+
+- (void) setUp {
+    [super setUp];
+    
+    // Allocate the embedding matrix: one row per word of the vocabulary
+    _embeddings= MLAllocRealBuffer(_vocabularySize * _size);
+    
+    ML_VCLR(_embeddings, 1, _vocabularySize * _size);
+    
+    // Allocate buffers, positions grow with the longest document
+    _positionsCapacity= INITIAL_POSITIONS_CAPACITY;
+    _positions= MLAllocIntBuffer(_positionsCapacity);
+    
+    _errorBuffer= MLAllocRealBuffer(_size);
+    
+    ML_VCLR(_errorBuffer, 1, _size);
+}
+
+- (void) randomizeEmbeddings {
+    if (!_embeddings)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Embedding layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Small values, as in word2vec, so that pooling
+    // many of them doesn't saturate the next layer
+    MLReal range= 0.5 / ((MLReal) _size);
+    
+    [MLRandom fillVector:_embeddings size:_vocabularySize * _size ofUniformRealsWithMin:-range max:range];
+}
+
+- (NSUInteger) loadEmbeddingsFromWordVectorDictionary:(MLWordVectorDictionary *)vectorDictionary wordDictionary:(MLWordDictionary *)wordDictionary {
+    if (!_embeddings)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Embedding layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (vectorDictionary.vectorSize != _size)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Word vectors size differs from the embedding size"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"vectorSize": @(vectorDictionary.vectorSize),
+                                                                            @"size": @(_size)}];
+    
+    // Rows of words without a vector are left as they are
+    NSUInteger loaded= 0;
+    for (MLWordInfo *wordInfo in wordDictionary.wordInfos) {
+        if (wordInfo.position >= _vocabularySize)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Word position exceeds the vocabulary size"
+                                                                     userInfo:@{@"layer": @(self.index),
+                                                                                @"word": wordInfo.word,
+                                                                                @"position": @(wordInfo.position)}];
+        
+        MLWordVector *vector= [vectorDictionary vectorForWord:wordInfo.word];
+        if (!vector)
+            continue;
+        
+        ML_VSMUL(vector.vector, 1, &__one, &_embeddings[wordInfo.position * _size], 1, _size);
+        loaded++;
+    }
+    
+    return loaded;
+}
+
+
+#pragma mark -
+#pragma mark Operations
+
+- (void) feedWordPositions:(const int *)positions count:(NSUInteger)count {
+    if (!_embeddings)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Embedding layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Enlarge the positions buffer if needed, doubling its capacity
+    if (count > _positionsCapacity) {
+        while (_positionsCapacity < count)
+            _positionsCapacity *= 2;
+        
+        MLFreeIntBuffer(_positions);
+        _positions= MLAllocIntBuffer(_positionsCapacity);
+    }
+    
+    // Keep a copy of the positions for backpropagation,
+    // a previous update is discarded if not yet applied
+    memcpy(_positions, positions, count * sizeof(int));
+    
+    _wordCount= 0;
+    _updatePending= NO;
+    
+    [self poolWordPositions:_positions count:count outputBuffer:self.inputBuffer];
+    
+    // Positions are valid, otherwise pooling would have thrown
+    _wordCount= count;
+}
+
+- (void) poolWordPositions:(const int *)positions count:(NSUInteger)count outputBuffer:(MLReal *)outputBuffer {
+    if (!_embeddings)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Embedding layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // This method reads only the embeddings and the passed buffers,
+    // hence it may be called concurrently on different buffers
+    ML_VCLR(outputBuffer, 1, _size);
+    
+    // Apply formula: output = Sum(embeddings[positions[i]])
+    for (NSUInteger i= 0; i < count; i++) {
+        if ((positions[i] < 0) || (positions[i] >= _vocabularySize))
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Word position out of range"
+                                                                     userInfo:@{@"layer": @(self.index),
+                                                                                @"position": @(positions[i])}];
+        
+        ML_VADD(&_embeddings[positions[i] * _size], 1, outputBuffer, 1, outputBuffer, 1, _size);
+    }
+    
+    // Apply formula: output = output / count
+    if ((_poolingType == MLEmbeddingPoolingTypeMean) && (count > 1)) {
+        MLReal scale= __one / ((MLReal) count);
+        
+        ML_VSMUL(outputBuffer, 1, &scale, outputBuffer, 1, _size);
+    }
+}
+
+- (void) clearWordPositions {
+    _wordCount= 0;
+    _updatePending= NO;
+}
+
+- (void) backPropagateWithAlgorithm:(MLBackPropagationType)backPropType learningRate:(MLReal)learningRate {
+    if ((!_trainable) || (_wordCount == 0))
+        return;
+    
+    if (backPropType != MLBackPropagationTypeStandard)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Embeddings can be trained only with standard backpropagation, set trainable to NO to freeze them"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"backPropagationType": @(backPropType)}];
+    
+    MLNeuronLayer *nextLayer= (MLNeuronLayer *) self.nextLayer;
+    
+    // Compute the error at the input as the next layer sees it,
+    // weights delta included as for neuron layers
+    [nextLayer propagateErrorToBuffer:_errorBuffer];
+    
+    // Each pooled row gets the same delta: fold in the
+    // learning rate and, if averaged, the word count
+    MLReal scale= learningRate;
+    if (_poolingType == MLEmbeddingPoolingTypeMean)
+        scale /= (MLReal) _wordCount;
+    
+    ML_VSMUL(_errorBuffer, 1, &scale, _errorBuffer, 1, _size);
+    
+    _updatePending= YES;
+}
+
+- (void) updateEmbeddings {
+    if (!_updatePending)
+        return;
+    
+    // Only the rows of fed words change, a word fed more than once
+    // gets the delta once per occurrence, as its gradient does
+    for (NSUInteger i= 0; i < _wordCount; i++) {
+        MLReal *row= &_embeddings[_positions[i] * _size];
+        
+        ML_VADD(_errorBuffer, 1, row, 1, row, 1, _size);
+    }
+    
+    _updatePending= NO;
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+@synthesize vocabularySize= _vocabularySize;
+@synthesize poolingType= _poolingType;
+@synthesize trainable= _trainable;
+
+@synthesize embeddings= _embeddings;
+@synthesize wordCount= _wordCount;
+
+
+@end
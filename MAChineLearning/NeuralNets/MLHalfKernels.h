@@ -0,0 +1,52 @@
+//
+//  MLHalfKernels.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+#import "MLWeightsStorageType.h"
+
+
+// Half-precision values (IEEE fp16 or bfloat16) are stored as raw 16-bit words
+typedef uint16_t MLHalf;
+
+// Conversion kernels: from real to half with round to nearest even, and back;
+// storageType must be either MLWeightsStorageTypeHalf or MLWeightsStorageTypeBFloat16
+void MLConvertRealToHalf(MLWeightsStorageType storageType, const MLReal * _Nonnull source, NSUInteger sourceStride, MLHalf * _Nonnull destination, NSUInteger destinationStride, NSUInteger size);
+void MLConvertHalfToReal(MLWeightsStorageType storageType, const MLHalf * _Nonnull source, MLReal * _Nonnull destination, NSUInteger size);
+
+// Matrix product with half-precision weights converted on load and real
+// accumulation: output[b][i] = sum_j(weights[i][j] * input[b][j]), with
+// weights of rows x columns, input of batchSize x columns and output
+// of batchSize x rows, all row-major
+void MLHalfMatrixProduct(MLWeightsStorageType storageType, const MLHalf * _Nonnull weights, const MLReal * _Nonnull input, MLReal * _Nonnull output, NSUInteger batchSize, NSUInteger rows, NSUInteger columns);
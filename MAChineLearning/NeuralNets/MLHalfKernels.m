@@ -0,0 +1,205 @@
+//
+//  MLHalfKernels.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLHalfKernels.h"
+
+#define KERNEL_SAMPLE_BLOCK_SIZE         (4)
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __zero= 0.0;
+
+
+#pragma mark -
+#pragma mark Static functions
+
+typedef union {
+    uint32_t u;
+    float f;
+} MLFloatBits;
+
+static inline float MLHalfToFloat(MLHalf h, BOOL bfloat) {
+    MLFloatBits o;
+    
+    // bfloat16 is the upper half of a float
+    if (bfloat) {
+        o.u= ((uint32_t) h) << 16;
+        return o.f;
+    }
+    
+    // Move exponent and mantissa in place, then rebias the exponent
+    // and fix up Inf/NaN and zero/denormals with a magic subtraction
+    static const MLFloatBits magic= { 113 << 23 };
+    const uint32_t shiftedExp= 0x7c00 << 13;
+    
+    o.u= ((uint32_t) (h & 0x7fff)) << 13;
+    uint32_t exp= shiftedExp & o.u;
+    o.u += (127 - 15) << 23;
+    
+    if (exp == shiftedExp) {
+        o.u += (128 - 16) << 23;
+        
+    } else if (exp == 0) {
+        o.u += 1 << 23;
+        o.f -= magic.f;
+    }
+    
+    o.u |= ((uint32_t) (h & 0x8000)) << 16;
+    return o.f;
+}
+
+static inline MLHalf MLFloatToHalf(float value, BOOL bfloat) {
+    MLFloatBits f;
+    f.f= value;
+    
+    if (bfloat) {
+        
+        // Keep NaNs quiet, otherwise round to nearest even
+        if ((f.u & 0x7fffffff) > 0x7f800000)
+            return (MLHalf) ((f.u >> 16) | 0x40);
+        
+        return (MLHalf) ((f.u + 0x7fff + ((f.u >> 16) & 1)) >> 16);
+    }
+    
+    static const MLFloatBits infinity= { 255 << 23 };
+    static const MLFloatBits halfMax= { (127 + 16) << 23 };
+    static const MLFloatBits denormMagic= { ((127 - 15) + (23 - 10) + 1) << 23 };
+    
+    uint32_t sign= f.u & 0x80000000u;
+    f.u ^= sign;
+    
+    MLHalf o;
+    if (f.u >= halfMax.u) {
+        
+        // Overflow to Inf, NaN stays NaN
+        o= (f.u > infinity.u) ? 0x7e00 : 0x7c00;
+        
+    } else if (f.u < (113 << 23)) {
+        
+        // Denormal or zero: align the mantissa with a magic
+        // addition, rounding is done by the FPU
+        f.f += denormMagic.f;
+        o= (MLHalf) (f.u - denormMagic.u);
+        
+    } else {
+        
+        // Normal: rebias the exponent and round to nearest even
+        uint32_t mantissaOdd= (f.u >> 13) & 1;
+        
+        f.u += ((uint32_t) (15 - 127) << 23) + 0xfff;
+        f.u += mantissaOdd;
+        o= (MLHalf) (f.u >> 13);
+    }
+    
+    return o | (MLHalf) (sign >> 16);
+}
+
+static inline void MLHalfMatrixProductOfType(BOOL bfloat, const MLHalf *weights, const MLReal *input, MLReal *output, NSUInteger batchSize, NSUInteger rows, NSUInteger columns) {
+    NSUInteger b= 0;
+    
+    // Blocks of samples: each weight is loaded and converted
+    // once and used for all the samples of the block
+    for (; b + KERNEL_SAMPLE_BLOCK_SIZE <= batchSize; b += KERNEL_SAMPLE_BLOCK_SIZE) {
+        const MLReal *x0= &input[b * columns];
+        const MLReal *x1= x0 + columns;
+        const MLReal *x2= x1 + columns;
+        const MLReal *x3= x2 + columns;
+        
+        for (NSUInteger i= 0; i < rows; i++) {
+            const MLHalf *w= &weights[i * columns];
+            MLReal sum0= __zero, sum1= __zero, sum2= __zero, sum3= __zero;
+            
+            for (NSUInteger j= 0; j < columns; j++) {
+                MLReal weight= MLHalfToFloat(w[j], bfloat);
+                
+                sum0 += weight * x0[j];
+                sum1 += weight * x1[j];
+                sum2 += weight * x2[j];
+                sum3 += weight * x3[j];
+            }
+            
+            output[b * rows + i]= sum0;
+            output[(b +1) * rows + i]= sum1;
+            output[(b +2) * rows + i]= sum2;
+            output[(b +3) * rows + i]= sum3;
+        }
+    }
+    
+    // Remaining samples, one at a time
+    for (; b < batchSize; b++) {
+        const MLReal *x= &input[b * columns];
+        
+        for (NSUInteger i= 0; i < rows; i++) {
+            const MLHalf *w= &weights[i * columns];
+            MLReal sum= __zero;
+            
+            for (NSUInteger j= 0; j < columns; j++)
+                sum += MLHalfToFloat(w[j], bfloat) * x[j];
+            
+            output[b * rows + i]= sum;
+        }
+    }
+}
+
+
+#pragma mark -
+#pragma mark Conversion kernels
+
+void MLConvertRealToHalf(MLWeightsStorageType storageType, const MLReal *source, NSUInteger sourceStride, MLHalf *destination, NSUInteger destinationStride, NSUInteger size) {
+    BOOL bfloat= (storageType == MLWeightsStorageTypeBFloat16);
+    
+    for (NSUInteger i= 0; i < size; i++)
+        destination[i * destinationStride]= MLFloatToHalf((float) source[i * sourceStride], bfloat);
+}
+
+void MLConvertHalfToReal(MLWeightsStorageType storageType, const MLHalf *source, MLReal *destination, NSUInteger size) {
+    BOOL bfloat= (storageType == MLWeightsStorageTypeBFloat16);
+    
+    for (NSUInteger i= 0; i < size; i++)
+        destination[i]= MLHalfToFloat(source[i], bfloat);
+}
+
+
+#pragma mark -
+#pragma mark Matrix product kernel
+
+void MLHalfMatrixProduct(MLWeightsStorageType storageType, const MLHalf *weights, const MLReal *input, MLReal *output, NSUInteger batchSize, NSUInteger rows, NSUInteger columns) {
+    
+    // Branch once, so that the conversion is inlined in the loops
+    if (storageType == MLWeightsStorageTypeBFloat16)
+        MLHalfMatrixProductOfType(YES, weights, input, output, batchSize, rows, columns);
+    else
+        MLHalfMatrixProductOfType(NO, weights, input, output, batchSize, rows, columns);
+}
@@ -0,0 +1,75 @@
+//
+//  MLInferencePlan.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+
+
+@class MLNeuralNetwork;
+
+// A frozen, read-only copy of a network for inference: weights are
+// contiguous, kernels are resolved once per layer and activations are
+// preallocated, so computing an output involves no message dispatch.
+// A plan holds its own activations: use one plan per thread
+typedef struct MLInferencePlan MLInferencePlan;
+
+
+#pragma mark -
+#pragma mark Creation
+
+// Freezes the network with its current weights and activation setting
+// (see fastApproximateActivation); later changes are not reflected
+MLInferencePlan * _Nonnull MLInferencePlanCreate(MLNeuralNetwork * _Nonnull network);
+void MLInferencePlanFree(MLInferencePlan * _Nullable plan);
+
+
+#pragma mark -
+#pragma mark Operations
+
+// Computes the output of the input buffer of the plan into its output buffer
+void MLInferencePlanFeedForward(MLInferencePlan * _Nonnull plan);
+
+// Computes the output of the specified input directly into the
+// specified output, sized as the input and output of the network
+void MLInferencePlanPredict(MLInferencePlan * _Nonnull plan, const MLReal * _Nonnull input, MLReal * _Nonnull output);
+
+
+#pragma mark -
+#pragma mark Properties
+
+NSUInteger MLInferencePlanInputSize(const MLInferencePlan * _Nonnull plan);
+MLReal * _Nonnull MLInferencePlanInputBuffer(MLInferencePlan * _Nonnull plan);
+
+NSUInteger MLInferencePlanOutputSize(const MLInferencePlan * _Nonnull plan);
+MLReal * _Nonnull MLInferencePlanOutputBuffer(MLInferencePlan * _Nonnull plan);
@@ -0,0 +1,328 @@
+//
+//  MLInferencePlan.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLInferencePlan.h"
+#import "MLNeuralNetwork.h"
+#import "MLInputLayer.h"
+#import "MLNeuronLayer.h"
+#import "MLNeuralNetworkException.h"
+
+#import "MLAlloc.h"
+#import "MLActivationKernels.h"
+
+// Layers with up to this number of weights are computed with an inline
+// loop, where the call overhead of BLAS would dominate the math
+#define PLAN_SMALL_LAYER_WEIGHTS             (1024)
+
+
+#pragma mark -
+#pragma mark Plan structures
+
+typedef struct MLInferencePlanLayer MLInferencePlanLayer;
+
+typedef void (*MLInferencePlanProduct)(const MLInferencePlanLayer *layer, const MLReal *input, MLReal *output);
+typedef void (*MLInferencePlanActivation)(MLReal *buffer, NSUInteger size);
+
+struct MLInferencePlanLayer {
+    NSUInteger inputSize;
+    NSUInteger rows;
+    const MLReal *weights;
+    
+    BOOL usingBias;
+    MLReal biasOutput;
+    
+    MLReal *outputBuffer;
+    
+    MLInferencePlanProduct product;
+    MLInferencePlanActivation activation;
+};
+
+struct MLInferencePlan {
+    NSUInteger layerCount;
+    MLInferencePlanLayer *layers;
+    
+    MLReal *weights;
+    MLReal *activations;
+    
+    NSUInteger inputSize;
+    MLReal *inputBuffer;
+    
+    NSUInteger outputSize;
+    MLReal *outputBuffer;
+};
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __zero= 0.0;
+static const MLReal __one=  1.0;
+
+
+#pragma mark -
+#pragma mark Product kernels
+
+static void MLInferencePlanProductGEMV(const MLInferencePlanLayer *layer, const MLReal *input, MLReal *output) {
+    ML_GEMV(CblasRowMajor, CblasNoTrans,
+            (int) layer->rows, (int) layer->inputSize,
+            __one, layer->weights, (int) layer->inputSize,
+            input, 1,
+            __zero, output, 1);
+}
+
+static void MLInferencePlanProductSmall(const MLInferencePlanLayer *layer, const MLReal *input, MLReal *output) {
+    const MLReal *weights= layer->weights;
+    
+    for (NSUInteger i= 0; i < layer->rows; i++, weights += layer->inputSize) {
+        MLReal dot= __zero;
+        for (NSUInteger j= 0; j < layer->inputSize; j++)
+            dot += weights[j] * input[j];
+        
+        output[i]= dot;
+    }
+}
+
+static void MLInferencePlanProductSmallRectified(const MLInferencePlanLayer *layer, const MLReal *input, MLReal *output) {
+    const MLReal *weights= layer->weights;
+    
+    // Rectified linear activation is fused with the dot product
+    for (NSUInteger i= 0; i < layer->rows; i++, weights += layer->inputSize) {
+        MLReal dot= __zero;
+        for (NSUInteger j= 0; j < layer->inputSize; j++)
+            dot += weights[j] * input[j];
+        
+        output[i]= (dot < __zero) ? __zero : dot;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Activation kernels
+
+static void MLInferencePlanActivateRectifiedLinear(MLReal *buffer, NSUInteger size) {
+    ML_VTHRES(buffer, 1, &__zero, buffer, 1, size);
+}
+
+static void MLInferencePlanActivateSigmoid(MLReal *buffer, NSUInteger size) {
+    MLActivateSigmoid(buffer, size, NO);
+}
+
+static void MLInferencePlanActivateSigmoidFast(MLReal *buffer, NSUInteger size) {
+    MLActivateSigmoid(buffer, size, YES);
+}
+
+static void MLInferencePlanActivateTanH(MLReal *buffer, NSUInteger size) {
+    MLActivateTanH(buffer, size, NO);
+}
+
+static void MLInferencePlanActivateTanHFast(MLReal *buffer, NSUInteger size) {
+    MLActivateTanH(buffer, size, YES);
+}
+
+static void MLInferencePlanActivateSoftmax(MLReal *buffer, NSUInteger size) {
+    MLActivateSoftmax(buffer, size, NO);
+}
+
+static void MLInferencePlanActivateSoftmaxFast(MLReal *buffer, NSUInteger size) {
+    MLActivateSoftmax(buffer, size, YES);
+}
+
+
+#pragma mark -
+#pragma mark Creation
+
+MLInferencePlan *MLInferencePlanCreate(MLNeuralNetwork *network) {
+    NSArray<MLLayer *> *layers= network.layers;
+    BOOL fast= network.fastApproximateActivation;
+    
+    // Outputs of hierarchical softmax are computed along the tree
+    if (network.softmaxTrainingType == MLSoftmaxTrainingTypeHierarchical)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Inference plans don't support hierarchical softmax"
+                                                                 userInfo:nil];
+    
+    MLInferencePlan *plan= calloc(1, sizeof(MLInferencePlan));
+    if (!plan)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while allocating inference plan"
+                                                                 userInfo:nil];
+    
+    plan->layerCount= layers.count -1;
+    plan->layers= calloc(plan->layerCount, sizeof(MLInferencePlanLayer));
+    if (!plan->layers) {
+        free(plan);
+        
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while allocating inference plan"
+                                                                 userInfo:nil];
+    }
+    
+    // Size a single buffer for all weights and one for all activations,
+    // input included; rows of bias neurons are not copied
+    NSUInteger weightsSize= 0;
+    NSUInteger activationsSize= network.inputSize;
+    for (NSUInteger i= 1; i < layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) layers[i];
+        NSUInteger rows= layer.usingBias ? (layer.size -1) : layer.size;
+        
+        weightsSize += rows * layers[i -1].size;
+        activationsSize += layer.size;
+    }
+    
+    plan->weights= MLAllocRealBuffer(weightsSize);
+    plan->activations= MLAllocRealBuffer(activationsSize);
+    ML_VCLR(plan->activations, 1, activationsSize);
+    
+    plan->inputSize= network.inputSize;
+    plan->inputBuffer= plan->activations;
+    
+    MLReal *weights= plan->weights;
+    MLReal *activations= plan->activations + network.inputSize;
+    
+    for (NSUInteger i= 1; i < layers.count; i++) {
+        MLNeuronLayer *neuronLayer= (MLNeuronLayer *) layers[i];
+        MLInferencePlanLayer *layer= &plan->layers[i -1];
+        
+        layer->inputSize= layers[i -1].size;
+        layer->rows= neuronLayer.usingBias ? (neuronLayer.size -1) : neuronLayer.size;
+        layer->usingBias= neuronLayer.usingBias;
+        layer->outputBuffer= activations;
+        
+        memcpy(weights, neuronLayer.weights, layer->rows * layer->inputSize * sizeof(MLReal));
+        layer->weights= weights;
+        
+        weights += layer->rows * layer->inputSize;
+        activations += neuronLayer.size;
+        
+        // The bias neuron is activated like the others, its
+        // output is then constant and can be computed once
+        if (layer->usingBias) {
+            layer->biasOutput= __one;
+            MLActivate(neuronLayer.funcType, &layer->biasOutput, 1, fast);
+        }
+        
+        // Resolve the kernels of the layer
+        BOOL small= (layer->rows * layer->inputSize <= PLAN_SMALL_LAYER_WEIGHTS);
+        layer->product= small ? MLInferencePlanProductSmall : MLInferencePlanProductGEMV;
+        
+        switch (neuronLayer.funcType) {
+            case MLActivationFunctionTypeLinear:
+                layer->activation= NULL;
+                break;
+                
+            case MLActivationFunctionTypeRectifiedLinear:
+                if (small)
+                    layer->product= MLInferencePlanProductSmallRectified;
+                else
+                    layer->activation= MLInferencePlanActivateRectifiedLinear;
+                break;
+                
+            case MLActivationFunctionTypeStep:
+                layer->activation= MLActivateStep;
+                break;
+                
+            case MLActivationFunctionTypeSigmoid:
+                layer->activation= fast ? MLInferencePlanActivateSigmoidFast : MLInferencePlanActivateSigmoid;
+                break;
+                
+            case MLActivationFunctionTypeTanH:
+                layer->activation= fast ? MLInferencePlanActivateTanHFast : MLInferencePlanActivateTanH;
+                break;
+                
+            case MLActivationFunctionTypeSoftmax:
+                layer->activation= fast ? MLInferencePlanActivateSoftmaxFast : MLInferencePlanActivateSoftmax;
+                break;
+        }
+    }
+    
+    plan->outputSize= network.outputSize;
+    plan->outputBuffer= plan->layers[plan->layerCount -1].outputBuffer;
+    
+    return plan;
+}
+
+void MLInferencePlanFree(MLInferencePlan *plan) {
+    if (!plan)
+        return;
+    
+    MLFreeRealBuffer(plan->weights);
+    MLFreeRealBuffer(plan->activations);
+    
+    free(plan->layers);
+    free(plan);
+}
+
+
+#pragma mark -
+#pragma mark Operations
+
+void MLInferencePlanFeedForward(MLInferencePlan *plan) {
+    MLInferencePlanPredict(plan, plan->inputBuffer, plan->outputBuffer);
+}
+
+void MLInferencePlanPredict(MLInferencePlan *plan, const MLReal *input, MLReal *output) {
+    const MLReal *layerInput= input;
+    NSUInteger last= plan->layerCount -1;
+    
+    for (NSUInteger i= 0; i <= last; i++) {
+        const MLInferencePlanLayer *layer= &plan->layers[i];
+        MLReal *layerOutput= (i == last) ? output : layer->outputBuffer;
+        
+        layer->product(layer, layerInput, layerOutput);
+        
+        if (layer->activation)
+            layer->activation(layerOutput, layer->rows);
+        
+        if (layer->usingBias)
+            layerOutput[layer->rows]= layer->biasOutput;
+        
+        layerInput= layerOutput;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+NSUInteger MLInferencePlanInputSize(const MLInferencePlan *plan) {
+    return plan->inputSize;
+}
+
+MLReal *MLInferencePlanInputBuffer(MLInferencePlan *plan) {
+    return plan->inputBuffer;
+}
+
+NSUInteger MLInferencePlanOutputSize(const MLInferencePlan *plan) {
+    return plan->outputSize;
+}
+
+MLReal *MLInferencePlanOutputBuffer(MLInferencePlan *plan) {
+    return plan->outputBuffer;
+}
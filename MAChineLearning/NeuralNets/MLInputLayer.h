@@ -53,6 +53,7 @@
 #pragma mark Properties
 
 @property (nonatomic, readonly, nonnull) MLReal *inputBuffer;
+@property (nonatomic, readonly, nullable) MLReal *batchInputBuffer;
 
 
 @end
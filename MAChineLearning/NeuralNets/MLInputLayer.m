@@ -42,6 +42,7 @@
 
 @interface MLInputLayer () {
     MLReal *_inputBuffer;
+    MLReal *_batchInputBuffer;
 }
 
 
@@ -71,6 +72,9 @@
     // Deallocate the input buffer
     MLFreeRealBuffer(_inputBuffer);
     _inputBuffer= NULL;
+    
+    MLFreeRealBuffer(_batchInputBuffer);
+    _batchInputBuffer= NULL;
 }
 
 
@@ -86,11 +90,24 @@
     ML_VCLR(_inputBuffer, 1, self.size);
 }
 
+- (void) setUpBatchOfSize:(NSUInteger)batchSize {
+    [super setUpBatchOfSize:batchSize];
+    
+    // Release previous batch buffer, if any
+    MLFreeRealBuffer(_batchInputBuffer);
+    
+    // Allocate the batch buffer: one row per sample
+    _batchInputBuffer= MLAllocRealBuffer(batchSize * self.size);
+    
+    ML_VCLR(_batchInputBuffer, 1, batchSize * self.size);
+}
+
 
 #pragma mark -
 #pragma mark Properties
 
 @synthesize inputBuffer= _inputBuffer;
+@synthesize batchInputBuffer= _batchInputBuffer;
 
 
 @end
@@ -39,6 +39,7 @@
 @protected
     NSUInteger _index;
     NSUInteger _size;
+    NSUInteger _batchSize;
 }
 
 
@@ -56,6 +57,7 @@
 #pragma mark Setup
 
 - (void) setUp;
+- (void) setUpBatchOfSize:(NSUInteger)batchSize;
 
 
 #pragma mark -
@@ -63,6 +65,7 @@
 
 @property (nonatomic, readonly) NSUInteger index;
 @property (nonatomic, readonly) NSUInteger size;
+@property (nonatomic, readonly) NSUInteger batchSize;
 
 @property (nonatomic, weak, nullable) MLLayer *previousLayer;
 @property (nonatomic, weak, nullable) MLLayer *nextLayer;
@@ -82,12 +82,21 @@
     // Nothing to do
 }
 
+- (void) setUpBatchOfSize:(NSUInteger)batchSize {
+    if (batchSize == 0)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid batch size: must be at least 1"
+                                                                 userInfo:@{@"layer": @(_index)}];
+    
+    _batchSize= batchSize;
+}
+
 
 #pragma mark -
 #pragma mark Properties
 
 @synthesize index= _index;
 @synthesize size= _size;
+@synthesize batchSize= _batchSize;
 
 @synthesize previousLayer= _previousLayer;
 @synthesize nextLayer= _nextLayer;
@@ -0,0 +1,141 @@
+//
+//  MLLowRankKernels.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLLowRankKernels.h"
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __zero=               0.0;
+static const MLReal __one=                1.0;
+
+// Rows are orthogonal when their cosine is below the tolerance,
+// which must be above the resolution of the precision in use
+static const MLReal __tolerance=          (sizeof(MLReal) == sizeof(double)) ? 1.0e-12 : 1.0e-6;
+static const NSUInteger __maxSweeps=      60;
+
+
+#pragma mark -
+#pragma mark Static functions
+
+static inline void MLRotateRows(MLReal *p, MLReal *q, MLReal c, MLReal s, NSUInteger size) {
+    
+    // Apply formula: (p[j], q[j]) = (c * p[j] - s * q[j], s * p[j] + c * q[j])
+    for (NSUInteger j= 0; j < size; j++) {
+        MLReal x= p[j];
+        MLReal y= q[j];
+        
+        p[j]= c * x - s * y;
+        q[j]= s * x + c * y;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Decomposition kernels
+
+void MLJacobiSingularValueDecomposition(MLReal *matrix, MLReal *rotations, MLReal *singularValues, NSUInteger rows, NSUInteger columns) {
+    
+    // Rotations start from the identity
+    for (NSUInteger i= 0; i < rows * rows; i++)
+        rotations[i]= __zero;
+    
+    for (NSUInteger i= 0; i < rows; i++)
+        rotations[i * rows + i]= __one;
+    
+    for (NSUInteger sweep= 0; sweep < __maxSweeps; sweep++) {
+        BOOL rotated= NO;
+        
+        for (NSUInteger p= 0; p < rows; p++) {
+            MLReal *rowP= &matrix[p * columns];
+            
+            for (NSUInteger q= p +1; q < rows; q++) {
+                MLReal *rowQ= &matrix[q * columns];
+                
+                // Squared norms and dot product of the two rows
+                MLReal alpha= __zero, beta= __zero, gamma= __zero;
+                for (NSUInteger j= 0; j < columns; j++) {
+                    alpha += rowP[j] * rowP[j];
+                    beta += rowQ[j] * rowQ[j];
+                    gamma += rowP[j] * rowQ[j];
+                }
+                
+                if ((gamma == __zero) || (ML_ABS(gamma) <= __tolerance * ML_SQRT(alpha * beta)))
+                    continue;
+                
+                // Rotation that makes the two rows orthogonal, the
+                // smaller of the two possible angles is chosen
+                MLReal zeta= (beta - alpha) / (2.0 * gamma);
+                MLReal t= ((zeta >= __zero) ? __one : -__one) / (ML_ABS(zeta) + ML_SQRT(__one + zeta * zeta));
+                MLReal c= __one / ML_SQRT(__one + t * t);
+                MLReal s= c * t;
+                
+                MLRotateRows(rowP, rowQ, c, s, columns);
+                MLRotateRows(&rotations[p * rows], &rotations[q * rows], c, s, rows);
+                
+                rotated= YES;
+            }
+        }
+        
+        if (!rotated)
+            break;
+    }
+    
+    // Singular values are the norms of the rotated rows
+    for (NSUInteger i= 0; i < rows; i++) {
+        MLReal *row= &matrix[i * columns];
+        
+        MLReal sum= __zero;
+        for (NSUInteger j= 0; j < columns; j++)
+            sum += row[j] * row[j];
+        
+        singularValues[i]= ML_SQRT(sum);
+    }
+}
+
+void MLSortSingularValues(const MLReal *singularValues, int *indices, NSUInteger size) {
+    for (NSUInteger i= 0; i < size; i++)
+        indices[i]= (int) i;
+    
+    // Insertion sort, sizes are those of a layer
+    for (NSUInteger i= 1; i < size; i++) {
+        int index= indices[i];
+        
+        NSUInteger j= i;
+        for (; (j > 0) && (singularValues[indices[j -1]] < singularValues[index]); j--)
+            indices[j]= indices[j -1];
+        
+        indices[j]= index;
+    }
+}
@@ -39,9 +39,14 @@
 #import "MLActivationFunctionType.h"
 #import "MLBackPropagationType.h"
 #import "MLCostFunctionType.h"
+#import "MLWeightsStorageType.h"
+#import "MLEmbeddingPoolingType.h"
+#import "MLSoftmaxTrainingType.h"
 
 
 @class MLLayer;
+@class MLEmbeddingLayer;
+@class MLNeuralNetworkProfile;
 
 @interface MLNeuralNetwork : NSObject
 
@@ -51,6 +56,9 @@
 
 + (nonnull MLNeuralNetwork *) createNetworkFromConfigurationDictionary:(nonnull NSDictionary<NSString *, id> *)config;
 
++ (nonnull MLNeuralNetwork *) createNetworkFromModelFile:(nonnull NSString *)path;
++ (nonnull MLNeuralNetwork *) createNetworkByMappingModelFile:(nonnull NSString *)path;
+
 + (nonnull MLNeuralNetwork *) createNetworkWithLayerSizes:(nonnull NSArray<NSNumber *> *)sizes
                                        outputFunctionType:(MLActivationFunctionType)funcType;
 
@@ -85,34 +93,103 @@
                          hiddenFunctionType:(MLActivationFunctionType)hiddenFuncType
                          outputFunctionType:(MLActivationFunctionType)funcType;
 
+- (nonnull instancetype) initWithVocabularySize:(NSUInteger)vocabularySize
+                           embeddingPoolingType:(MLEmbeddingPoolingType)poolingType
+                                     layerSizes:(nonnull NSArray<NSNumber *> *)sizes
+                                        useBias:(BOOL)useBias
+                               costFunctionType:(MLCostFunctionType)costType
+                            backPropagationType:(MLBackPropagationType)backPropType
+                             hiddenFunctionType:(MLActivationFunctionType)hiddenFuncType
+                             outputFunctionType:(MLActivationFunctionType)funcType;
+
 
 #pragma mark -
 #pragma mark Randomization
 
 - (void) randomizeWeights;
+- (void) updateWeightsStorage;
+
+
+#pragma mark -
+#pragma mark Pruning
+
+- (void) pruneWithSparsity:(MLReal)sparsity;
+- (void) pruneLayersWithSparsities:(nonnull NSArray<NSNumber *> *)sparsities;
+- (void) removePruning;
+
+
+#pragma mark -
+#pragma mark Factorization
+
+- (void) factorizeWithMaxError:(MLReal)maxError;
+- (void) factorizeLayersWithRanks:(nonnull NSArray<NSNumber *> *)ranks;
+- (void) removeFactorization;
+- (nonnull NSString *) factorizationReport;
+
+
+#pragma mark -
+#pragma mark Softmax training
+
+- (void) setUpSampledSoftmaxWithSamples:(NSUInteger)samples
+                            classCounts:(nullable NSArray<NSNumber *> *)counts;
+- (void) setUpHierarchicalSoftmaxWithClassCounts:(nonnull NSArray<NSNumber *> *)counts;
+- (void) removeSoftmaxApproximation;
 
 
 #pragma mark -
 #pragma mark Operations
 
 - (void) feedForward;
+- (void) feedForwardSparseInputWithIndices:(nonnull const int *)indices
+                                    values:(nonnull const MLReal *)values
+                                      size:(NSUInteger)size;
+- (void) feedForwardWordPositions:(nonnull const int *)positions
+                            count:(NSUInteger)count;
 - (void) backPropagate;
 - (void) backPropagateWithLearningRate:(MLReal)learningRate;
+- (void) backPropagateClass:(NSUInteger)targetClass
+               learningRate:(MLReal)learningRate;
 - (void) updateWeights;
 
+- (NSUInteger) computeTopClasses:(NSUInteger)k
+                         indices:(nonnull int *)indices
+                   probabilities:(nullable MLReal *)probabilities;
+
 - (void) terminate;
 
 
+#pragma mark -
+#pragma mark Batch operations
+
+- (void) setUpBatchOfSize:(NSUInteger)batchSize;
+
+- (void) feedForwardBatchOfSize:(NSUInteger)size;
+- (void) backPropagateBatch;
+- (void) backPropagateBatchWithLearningRate:(MLReal)learningRate;
+
+
 #pragma mark -
 #pragma mark Configuration
 
 - (nonnull NSDictionary<NSString *, id> *) saveConfigurationToDictionary;
+- (void) saveModelToFile:(nonnull NSString *)path;
+
+
+#pragma mark -
+#pragma mark Profiling
+
+- (void) enableProfilingWithMaxTraceEvents:(NSUInteger)maxTraceEvents;
+- (void) disableProfiling;
 
 
 #pragma mark -
 #pragma mark Properties
 
 @property (nonatomic, readonly, nonnull) NSArray<MLLayer *> *layers;
+@property (nonatomic, readonly, nullable) MLEmbeddingLayer *embeddingLayer;
+
+@property (nonatomic, readonly) MLCostFunctionType costType;
+@property (nonatomic, readonly) MLBackPropagationType backPropType;
 
 @property (nonatomic, readonly) NSUInteger inputSize;
 @property (nonatomic, readonly, nonnull) MLReal *inputBuffer;
@@ -121,8 +198,29 @@
 @property (nonatomic, readonly, nonnull) MLReal *outputBuffer;
 @property (nonatomic, readonly, nonnull) MLReal *expectedOutputBuffer;
 @property (nonatomic, readonly) MLReal cost;
+@property (nonatomic, readonly) MLReal classCost;
+
+@property (nonatomic, readonly) NSUInteger batchSize;
+@property (nonatomic, readonly, nullable) MLReal *batchInputBuffer;
+@property (nonatomic, readonly, nullable) MLReal *batchOutputBuffer;
+@property (nonatomic, readonly, nullable) MLReal *batchExpectedOutputBuffer;
+@property (nonatomic, readonly) MLReal batchCost;
 
 @property (nonatomic, readonly) MLNeuralNetworkStatus status;
+@property (nonatomic, readonly) BOOL readOnly;
+
+@property (nonatomic, assign) BOOL fastApproximateActivation;
+@property (nonatomic, assign) MLWeightsStorageType weightsStorageType;
+@property (nonatomic, readonly) MLReal sparsity;
+
+@property (nonatomic, readonly) MLSoftmaxTrainingType softmaxTrainingType;
+@property (nonatomic, assign) BOOL skipOutputLayer;
+
+@property (nonatomic, assign) MLReal momentum;
+@property (nonatomic, assign) MLReal decayRate;
+@property (nonatomic, assign) MLReal epsilon;
+
+@property (nonatomic, readonly, nullable) MLNeuralNetworkProfile *profile;
 
 
 @end
@@ -33,9 +33,13 @@
 
 #import "MLNeuralNetwork.h"
 #import "MLInputLayer.h"
+#import "MLEmbeddingLayer.h"
 #import "MLNeuronLayer.h"
 #import "MLNeuron.h"
 #import "MLNeuralNetworkException.h"
+#import "MLProfileCounters.h"
+#import "MLHalfKernels.h"
+#import "MLSparseKernels.h"
 
 #import "MLAlloc.h"
 
@@ -48,6 +52,56 @@
 #define CONFIG_PARAM_OUTPUT_FUNCTION_TYPE    (@"outputFunctionType")
 #define CONFIG_PARAM_LAYER                   (@"layer%d")
 #define CONFIG_PARAM_WEIGHTS                 (@"weights")
+#define CONFIG_PARAM_VOCABULARY_SIZE         (@"vocabularySize")
+#define CONFIG_PARAM_EMBEDDING_POOLING_TYPE  (@"embeddingPoolingType")
+#define CONFIG_PARAM_EMBEDDINGS              (@"embeddings")
+#define CONFIG_PARAM_SOFTMAX_TRAINING_TYPE   (@"softmaxTrainingType")
+#define CONFIG_PARAM_SOFTMAX_SAMPLES         (@"softmaxSamples")
+#define CONFIG_PARAM_CLASS_COUNTS            (@"classCounts")
+
+#define MODEL_FILE_MAGIC                     (0x4E4E4C4D) // "MLNN"
+#define MODEL_FILE_VERSION                   (1)
+#define MODEL_FILE_ALIGNMENT                 (128)
+#define MODEL_FILE_ALIGN(x)                  ((((x) + MODEL_FILE_ALIGNMENT -1) / MODEL_FILE_ALIGNMENT) * MODEL_FILE_ALIGNMENT)
+
+
+#pragma mark -
+#pragma mark Model file structures
+
+// Model file layout: the header is followed by one layer descriptor
+// for each layer (input layer included), then by the weight matrices
+// of each neuron layer, row-major, each aligned to MODEL_FILE_ALIGNMENT
+// so that they can be used in place when the file is memory mapped.
+// Networks with half-precision weights storage save only 16-bit
+// weights: master weights are not saved and are rebuilt from them on
+// load, so these files are for inference. An embedding input
+// layer has its embedding matrix as weights, always saved with
+// realSize, and its pooling type in the layer descriptor. A softmax
+// output layer with a training approximation has its class counts
+// after the last weight matrix, aligned and saved with realSize, as
+// many as the output neurons. All fields are in host byte order.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t realSize;
+    uint32_t layerCount;
+    uint32_t useBias;
+    uint32_t costType;
+    uint32_t backPropType;
+    uint32_t hiddenFuncType;
+    uint32_t outputFuncType;
+    uint32_t weightsStorageType;
+    uint32_t softmaxTrainingType;
+    uint32_t sampledSoftmaxSamples;
+    uint32_t reserved[4];
+} MLModelFileHeader;
+
+typedef struct {
+    uint64_t size;
+    uint64_t weightsCount;
+    uint64_t weightsOffset;
+    uint64_t poolingType;
+} MLModelFileLayer;
 
 
 #pragma mark -
@@ -55,6 +109,7 @@
 
 @interface MLNeuralNetwork () {
     NSMutableArray<MLLayer *> *_layers;
+    MLEmbeddingLayer *_embeddingLayer;
     BOOL _useBias;
     MLActivationFunctionType _hiddenFuncType;
     MLActivationFunctionType _funcType;
@@ -69,10 +124,44 @@
     MLReal *_expectedOutputBuffer;
     MLReal *_errorBuffer;
     
+    MLReal *_costBuffer;
+    NSUInteger _costBufferSize;
+    
+    BOOL _skipOutputLayer;
+    BOOL _outputLayerFed;
+    MLReal _classCost;
+    
+    NSUInteger _batchSize;
+    NSUInteger _currentBatchSize;
+    MLReal *_batchInputBuffer;
+    MLReal *_batchOutputBuffer;
+    MLReal *_batchExpectedOutputBuffer;
+    MLReal *_batchErrorBuffer;
+    
     MLNeuralNetworkStatus _status;
+    
+    MLNeuralNetworkProfile *_profile;
+    MLProfileState *_profileState;
 }
 
 
+#pragma mark -
+#pragma mark Internals
+
+- (void) checkLearningRate:(MLReal)learningRate;
+
+- (void) feedForwardLayersFromIndex:(NSUInteger)index;
+- (void) backPropagateLayersFromIndex:(NSUInteger)index learningRate:(MLReal)learningRate;
+
+- (MLReal) costOfOutputBuffer:(MLReal *)outputBuffer
+         expectedOutputBuffer:(MLReal *)expectedOutputBuffer
+                  errorBuffer:(MLReal *)errorBuffer
+                   tempBuffer:(MLReal *)tempBuffer
+                         size:(NSUInteger)size;
+
++ (nonnull MLNeuralNetwork *) createNetworkFromModelFile:(nonnull NSString *)path mapped:(BOOL)mapped;
+
+
 @end
 
 
@@ -129,13 +218,33 @@ static const MLReal __one=                    1.0;
         @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid configuration: missing cost function type"
                                                                  userInfo:@{@"config": config}];
     
+    // Get embedding parameters from configuration, if any
+    NSNumber *vocabularySize= config[CONFIG_PARAM_VOCABULARY_SIZE];
+    NSNumber *poolingType= config[CONFIG_PARAM_EMBEDDING_POOLING_TYPE];
+    
     // Create the network
-    MLNeuralNetwork *network= [[MLNeuralNetwork alloc] initWithLayerSizes:sizes
-                                                                  useBias:useBias.boolValue
-                                                         costFunctionType:costType.intValue
-                                                      backPropagationType:backPropType.intValue
-                                                       hiddenFunctionType:hiddenFuncType.intValue
-                                                       outputFunctionType:funcType.intValue];
+    MLNeuralNetwork *network= [[MLNeuralNetwork alloc] initWithVocabularySize:vocabularySize.unsignedIntegerValue
+                                                         embeddingPoolingType:poolingType.unsignedIntegerValue
+                                                                   layerSizes:sizes
+                                                                      useBias:useBias.boolValue
+                                                             costFunctionType:costType.intValue
+                                                          backPropagationType:backPropType.intValue
+                                                           hiddenFunctionType:hiddenFuncType.intValue
+                                                           outputFunctionType:funcType.intValue];
+    
+    // Get embeddings from configuration
+    if (network.embeddingLayer) {
+        MLEmbeddingLayer *embeddingLayer= network.embeddingLayer;
+        NSUInteger embeddingsCount= embeddingLayer.vocabularySize * embeddingLayer.size;
+        
+        NSArray<NSNumber *> *embeddings= config[CONFIG_PARAM_EMBEDDINGS];
+        if (embeddings.count != embeddingsCount)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid configuration: missing or incomplete embeddings list"
+                                                                     userInfo:@{@"config": config}];
+        
+        for (NSUInteger i= 0; i < embeddingsCount; i++)
+            embeddingLayer.embeddings[i]= embeddings[i].doubleValue;
+    }
     
     // Get weights from configuration
     for (int i= 1; i < network.layers.count; i++) {
@@ -180,9 +289,45 @@ static const MLReal __one=                    1.0;
         }
     }
     
+    // Get softmax training approximation from configuration, if any
+    NSNumber *softmaxTrainingType= config[CONFIG_PARAM_SOFTMAX_TRAINING_TYPE];
+    NSArray<NSNumber *> *classCounts= config[CONFIG_PARAM_CLASS_COUNTS];
+    
+    switch (softmaxTrainingType.intValue) {
+        case MLSoftmaxTrainingTypeSampled: {
+            NSNumber *samples= config[CONFIG_PARAM_SOFTMAX_SAMPLES];
+            if (samples == nil)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid configuration: missing softmax samples"
+                                                                         userInfo:@{@"config": config}];
+            
+            [network setUpSampledSoftmaxWithSamples:samples.unsignedIntegerValue classCounts:classCounts];
+            break;
+        }
+            
+        case MLSoftmaxTrainingTypeHierarchical: {
+            if (!classCounts)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid configuration: missing class counts"
+                                                                         userInfo:@{@"config": config}];
+            
+            [network setUpHierarchicalSoftmaxWithClassCounts:classCounts];
+            break;
+        }
+            
+        default:
+            break;
+    }
+    
     return network;
 }
 
++ (MLNeuralNetwork *) createNetworkFromModelFile:(NSString *)path {
+    return [MLNeuralNetwork createNetworkFromModelFile:path mapped:NO];
+}
+
++ (MLNeuralNetwork *) createNetworkByMappingModelFile:(NSString *)path {
+    return [MLNeuralNetwork createNetworkFromModelFile:path mapped:YES];
+}
+
 + (MLNeuralNetwork *) createNetworkWithLayerSizes:(NSArray<NSNumber *> *)sizes
                                outputFunctionType:(MLActivationFunctionType)funcType {
     
@@ -277,22 +422,56 @@ static const MLReal __one=                    1.0;
                  hiddenFunctionType:(MLActivationFunctionType)hiddenFuncType
                  outputFunctionType:(MLActivationFunctionType)funcType {
     
+    // A vocabulary size of 0 means a plain input layer
+    return [self initWithVocabularySize:0
+                   embeddingPoolingType:MLEmbeddingPoolingTypeSum
+                             layerSizes:sizes
+                                useBias:useBias
+                       costFunctionType:costType
+                    backPropagationType:backPropType
+                     hiddenFunctionType:hiddenFuncType
+                     outputFunctionType:funcType];
+}
+
+- (instancetype) initWithVocabularySize:(NSUInteger)vocabularySize
+                   embeddingPoolingType:(MLEmbeddingPoolingType)poolingType
+                             layerSizes:(NSArray<NSNumber *> *)sizes
+                                useBias:(BOOL)useBias
+                       costFunctionType:(MLCostFunctionType)costType
+                    backPropagationType:(MLBackPropagationType)backPropType
+                     hiddenFunctionType:(MLActivationFunctionType)hiddenFuncType
+                     outputFunctionType:(MLActivationFunctionType)funcType {
+    
     if ((self = [super init])) {
         
         // Checks
         switch (costType) {
             case MLCostFunctionTypeCrossEntropy: {
-                if ((hiddenFuncType != MLActivationFunctionTypeSigmoid) || (funcType != MLActivationFunctionTypeSigmoid))
-                    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Wrong cost function: cross entropy can be used only with sigmoid activation function for all layers"
+                
+                // A softmax output layer has the same gradient with any hidden layer
+                if (((hiddenFuncType != MLActivationFunctionTypeSigmoid) || (funcType != MLActivationFunctionTypeSigmoid)) &&
+                    (funcType != MLActivationFunctionTypeSoftmax))
+                    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Wrong cost function: cross entropy can be used only with sigmoid activation function for all layers, or with a softmax output layer"
                                                                              userInfo:@{@"hiddenFunctionType": @(hiddenFuncType),
                                                                                         @"outputFunctionType": @(funcType)}];
                 break;
             }
                 
             default:
+                if (funcType == MLActivationFunctionTypeSoftmax)
+                    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Wrong cost function: softmax output layer can be used only with cross entropy"
+                                                                             userInfo:@{@"costFunctionType": @(costType)}];
                 break;
         }
         
+        if (hiddenFuncType == MLActivationFunctionTypeSoftmax)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Wrong activation function: softmax can be used only for the output layer"
+                                                                     userInfo:@{@"hiddenFunctionType": @(hiddenFuncType)}];
+        
+        if (poolingType > MLEmbeddingPoolingTypeMean)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid embedding pooling type"
+                                                                     userInfo:@{@"embeddingPoolingType": @(poolingType)}];
+        
         // Initialize the layers: layer 0 is the input layer,
         // while the last layer is the output layer
         _layers= [NSMutableArray array];
@@ -308,7 +487,13 @@ static const MLReal __one=                    1.0;
                 @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid size specified"
                                                                          userInfo:@{@"size": size}];
             
-            if (i == 0) {
+            if ((i == 0) && (vocabularySize > 0)) {
+                
+                // Create embedding input layer, its size is that of embeddings
+                _embeddingLayer= [[MLEmbeddingLayer alloc] initWithIndex:i size:size.intValue vocabularySize:vocabularySize poolingType:poolingType];
+                [_layers addObject:_embeddingLayer];
+                
+            } else if (i == 0) {
                 
                 // Create input layer
                 MLInputLayer *layer= [[MLInputLayer alloc] initWithIndex:i size:size.intValue];
@@ -354,17 +539,19 @@ static const MLReal __one=                    1.0;
             i++;
         }
         
-        // Neurons setup: during setup each neuron connects its weights
-        // pointer for weight gathering during backpropagation, for this
-        // reason we have to go from output layers backwords
-        for (NSUInteger i= _layers.count -1; i > 0; i--) {
+        // Neurons setup: allocates buffers needed by
+        // the backpropagation algorithm
+        for (NSUInteger i= 1; i < _layers.count; i++) {
             MLNeuronLayer *neuronLayer= (MLNeuronLayer *) _layers[i];
-            for (MLNeuron *neuron in neuronLayer.neurons)
-                [neuron setUpForBackpropagationWithAlgorithm:_backPropType];
+            [neuronLayer setUpForBackpropagationWithAlgorithm:_backPropType];
         }
         
         _expectedOutputBuffer= MLAllocRealBuffer(_outputSize);
         
+        // Allocate the workspace for cost computation
+        _costBufferSize= _outputSize;
+        _costBuffer= MLAllocRealBuffer(_costBufferSize);
+        
         _status= MLNeuralNetworkStatusIdle;
     }
     
@@ -373,9 +560,15 @@ static const MLReal __one=                    1.0;
 
 - (void) dealloc {
     
-    // Deallocate buffer
+    // Deallocate buffers
     MLFreeRealBuffer(_expectedOutputBuffer);
     _expectedOutputBuffer= NULL;
+    
+    MLFreeRealBuffer(_batchExpectedOutputBuffer);
+    _batchExpectedOutputBuffer= NULL;
+    
+    MLFreeRealBuffer(_costBuffer);
+    _costBuffer= NULL;
 }
 
 
@@ -390,21 +583,237 @@ static const MLReal __one=                    1.0;
         
         [layer randomizeWeights];
     }
+    
+    [_embeddingLayer randomizeEmbeddings];
+}
+
+- (void) updateWeightsStorage {
+    
+    // Convert weights of each layer to their storage type
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer updateWeightsStorage];
+    }
 }
 
 
 #pragma mark -
-#pragma mark Operations
+#pragma mark Pruning
 
-- (void) feedForward {
-    _status= MLNeuralNetworkStatusFeededForward;
+- (void) pruneWithSparsity:(MLReal)sparsity {
+    if ((sparsity < 0.0) || (sparsity >= 1.0))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid sparsity: must be at least 0 and less than 1"
+                                                                 userInfo:@{@"sparsity": @(sparsity)}];
     
-    // Apply forward propagation
+    // Collect magnitudes of all weights, bias rows excluded
+    NSUInteger weightsCount= 0;
     for (int i= 1; i < _layers.count; i++) {
         MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
         
-        [layer feedForward];
+        weightsCount += (layer.usingBias ? (layer.size -1) : layer.size) * layer.previousLayer.size;
+    }
+    
+    MLReal *magnitudes= MLAllocRealBuffer(weightsCount);
+    
+    NSUInteger offset= 0;
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        NSUInteger count= (layer.usingBias ? (layer.size -1) : layer.size) * layer.previousLayer.size;
+        
+        ML_VABS(layer.weights, 1, &magnitudes[offset], 1, count);
+        offset += count;
+    }
+    
+    // A single threshold for the whole network: layers
+    // with smaller weights end up more sparse
+    MLReal threshold= MLMagnitudeThreshold(magnitudes, weightsCount, (NSUInteger) (sparsity * weightsCount));
+    
+    MLFreeRealBuffer(magnitudes);
+    
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer pruneWithThreshold:threshold];
+    }
+}
+
+- (void) pruneLayersWithSparsities:(NSArray<NSNumber *> *)sparsities {
+    if (sparsities.count != _layers.count -1)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid sparsities: must be one for each layer, input layer excluded"
+                                                                 userInfo:@{@"sparsities": @(sparsities.count),
+                                                                            @"layers": @(_layers.count -1)}];
+    
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer pruneWithSparsity:sparsities[i -1].doubleValue];
+    }
+}
+
+- (void) removePruning {
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer removePruning];
+    }
+}
+
+
+#pragma mark -
+#pragma mark Factorization
+
+- (void) factorizeWithMaxError:(MLReal)maxError {
+    
+    // Each layer gets the smallest rank within the error,
+    // layers that would not shrink are left dense
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer factorizeWithMaxError:maxError];
+    }
+}
+
+- (void) factorizeLayersWithRanks:(NSArray<NSNumber *> *)ranks {
+    if (ranks.count != _layers.count -1)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid ranks: must be one for each layer, input layer excluded"
+                                                                 userInfo:@{@"ranks": @(ranks.count),
+                                                                            @"layers": @(_layers.count -1)}];
+    
+    // A rank of 0 leaves the layer dense
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        NSUInteger rank= ranks[i -1].unsignedIntegerValue;
+        
+        if (rank > 0)
+            [layer factorizeWithRank:rank];
+        else
+            [layer removeFactorization];
+    }
+}
+
+- (void) removeFactorization {
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer removeFactorization];
+    }
+}
+
+- (NSString *) factorizationReport {
+    NSMutableString *report= [[NSMutableString alloc] init];
+    [report appendFormat:@"%-6s %8s %8s %6s %12s %12s %8s %10s\n", "Layer", "Neurons", "Inputs", "Rank", "Weights", "Factorized", "Ratio", "Error"];
+    
+    NSUInteger weightsCount= 0;
+    NSUInteger factorizedCount= 0;
+    
+    // Error is the relative Frobenius norm of the difference
+    // with the original weights, bias rows are excluded
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        NSUInteger rows= layer.usingBias ? (layer.size -1) : layer.size;
+        NSUInteger count= rows * layer.previousLayer.size;
+        NSUInteger factorized= layer.factorized ? layer.factorizedWeightsCount : count;
+        
+        [report appendFormat:@"%-6d %8lu %8lu %6lu %12lu %12lu %8.3f %10.6f\n",
+         i,
+         (unsigned long) rows,
+         (unsigned long) layer.previousLayer.size,
+         (unsigned long) layer.factorizationRank,
+         (unsigned long) count,
+         (unsigned long) factorized,
+         ((double) factorized) / ((double) count),
+         (double) layer.factorizationError];
+        
+        weightsCount += count;
+        factorizedCount += factorized;
     }
+    
+    [report appendFormat:@"%-6s %8s %8s %6s %12lu %12lu %8.3f\n",
+     "Total", "", "", "",
+     (unsigned long) weightsCount,
+     (unsigned long) factorizedCount,
+     ((double) factorizedCount) / ((double) weightsCount)];
+    
+    return report;
+}
+
+
+#pragma mark -
+#pragma mark Softmax training
+
+- (void) setUpSampledSoftmaxWithSamples:(NSUInteger)samples classCounts:(NSArray<NSNumber *> *)counts {
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers.lastObject;
+    
+    if (outputLayer.softmaxTrainingType == MLSoftmaxTrainingTypeHierarchical)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't switch from hierarchical softmax, its weights belong to the nodes of the tree"
+                                                                 userInfo:nil];
+    
+    [outputLayer setUpSampledSoftmaxWithSamples:samples classCounts:counts];
+}
+
+- (void) setUpHierarchicalSoftmaxWithClassCounts:(NSArray<NSNumber *> *)counts {
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers.lastObject;
+    
+    // Rows of the weights become the inner nodes of the tree,
+    // hence it should be set up before training
+    [outputLayer setUpHierarchicalSoftmaxWithClassCounts:counts];
+}
+
+- (void) removeSoftmaxApproximation {
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers.lastObject;
+    
+    if (outputLayer.softmaxTrainingType == MLSoftmaxTrainingTypeHierarchical)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't remove hierarchical softmax, its weights belong to the nodes of the tree"
+                                                                 userInfo:nil];
+    
+    [outputLayer removeSoftmaxApproximation];
+}
+
+
+#pragma mark -
+#pragma mark Operations
+
+- (void) feedForward {
+    _status= MLNeuralNetworkStatusFeededForward;
+    
+    // Input buffer has been filled directly, no word to train
+    [_embeddingLayer clearWordPositions];
+    
+    // Apply forward propagation
+    [self feedForwardLayersFromIndex:1];
+}
+
+- (void) feedForwardSparseInputWithIndices:(const int *)indices values:(const MLReal *)values size:(NSUInteger)size {
+    _status= MLNeuralNetworkStatusFeededForward;
+    
+    // Input is not made of words, no word to train
+    [_embeddingLayer clearWordPositions];
+    
+    if (_skipOutputLayer && (_layers.count == 2))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input can't skip the output layer, as it is also the first layer"
+                                                                 userInfo:nil];
+    
+    // Apply forward propagation, the first layer
+    // computes only on the nonzero inputs
+    MLNeuronLayer *firstLayer= (MLNeuronLayer *) _layers[1];
+    [firstLayer feedForwardSparseInputWithIndices:indices values:values size:size];
+    
+    [self feedForwardLayersFromIndex:2];
+}
+
+- (void) feedForwardWordPositions:(const int *)positions count:(NSUInteger)count {
+    if (!_embeddingLayer)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Word positions can be fed only to a network with an embedding input layer"
+                                                                 userInfo:nil];
+    
+    _status= MLNeuralNetworkStatusFeededForward;
+    
+    // Pool the embeddings of the words in the input buffer,
+    // then apply forward propagation as usual
+    [_embeddingLayer feedWordPositions:positions count:count];
+    
+    [self feedForwardLayersFromIndex:1];
 }
 
 - (void) backPropagate {
@@ -415,7 +824,15 @@ static const MLReal __one=                    1.0;
             @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: standard backpropagation requires a positive learning rate"
                                                                      userInfo:nil];
             
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+        case MLBackPropagationTypeRMSProp:
+        case MLBackPropagationTypeAdam:
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: adaptive optimizers require a positive learning rate"
+                                                                     userInfo:nil];
+            
         case MLBackPropagationTypeResilient:
+        case MLBackPropagationTypeImprovedResilient:
             [self backPropagateWithLearningRate:0.0];
             break;
     }
@@ -424,19 +841,7 @@ static const MLReal __one=                    1.0;
 - (void) backPropagateWithLearningRate:(MLReal)learningRate {
     
     // Checks
-    switch (_backPropType) {
-        case MLBackPropagationTypeStandard:
-            if (learningRate <= 0.0)
-                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: standard backpropagation requires a positive learning rate"
-                                                                         userInfo:@{@"learningRate": @(learningRate)}];
-            break;
-            
-        case MLBackPropagationTypeResilient:
-            if (learningRate != 0.0)
-                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: resilient backpropagation makes no use of learning rate, should not be passed"
-                                                                         userInfo:nil];
-            break;
-    }
+    [self checkLearningRate:learningRate];
     
     // Check call sequence
     switch (_status) {
@@ -448,22 +853,82 @@ static const MLReal __one=                    1.0;
                                                                      userInfo:@{@"status": @(_status)}];
     }
     
+    if (!_outputLayerFed)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Output layer has been skipped, back propagate a class instead"
+                                                                 userInfo:nil];
+    
     _status= MLNeuralNetworkStatusBackPropagated;
     
-    // Apply backward propagation
-    for (NSUInteger i= _layers.count -1; i > 0; i--) {
-        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+    // Apply backward propagation, starting from the output layer
+    NSUInteger outputIndex= _layers.count -1;
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers[outputIndex];
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseErrorFetch);
+    
+    // Error on output layer is the difference between expected and actual output
+    ML_VSUB(_outputBuffer, 1, _expectedOutputBuffer, 1, _errorBuffer, 1, _outputSize);
+    
+    ML_PROFILE_END(_profileState, outputIndex, MLProfilePhaseErrorFetch,
+                   _outputSize,
+                   3 * sizeof(MLReal) * _outputSize);
+    
+    [outputLayer backPropagateWithAlgorithm:_backPropType learningRate:learningRate costFunction:_costType];
+    
+    [self backPropagateLayersFromIndex:outputIndex -1 learningRate:learningRate];
+}
+
+- (void) backPropagateClass:(NSUInteger)targetClass learningRate:(MLReal)learningRate {
+    
+    // Checks
+    if (_funcType != MLActivationFunctionTypeSoftmax)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Classes can be back propagated only with a softmax output layer"
+                                                                 userInfo:@{@"outputFunctionType": @(_funcType)}];
+    
+    if (targetClass >= _outputSize)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Class out of range"
+                                                                 userInfo:@{@"class": @(targetClass),
+                                                                            @"outputSize": @(_outputSize)}];
+    
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers.lastObject;
+    
+    if (outputLayer.softmaxTrainingType == MLSoftmaxTrainingTypeFull) {
         
-        if (i == _layers.count -1) {
-            
-            // Error on output layer is the difference between expected and actual output
-            ML_VSUB(_outputBuffer, 1, _expectedOutputBuffer, 1, _errorBuffer, 1, _outputSize);
-            
-        } else
-            [layer fetchErrorFromNextLayer];
+        // Full softmax needs all the outputs, feed the output layer if skipped
+        if ((_status == MLNeuralNetworkStatusFeededForward) && !_outputLayerFed) {
+            [outputLayer feedForward];
+            _outputLayerFed= YES;
+        }
         
-        [layer backPropagateWithAlgorithm:_backPropType learningRate:learningRate costFunction:_costType];
+        // Expected output is the one-hot vector of the class
+        ML_VCLR(_expectedOutputBuffer, 1, _outputSize);
+        _expectedOutputBuffer[targetClass]= __one;
+        
+        [self backPropagateWithLearningRate:learningRate];
+        
+        // Apply formula: cost = -ln(output[class])
+        _classCost= -ML_LOG(_outputBuffer[targetClass]);
+        return;
+    }
+    
+    [self checkLearningRate:learningRate];
+    
+    // Check call sequence
+    switch (_status) {
+        case MLNeuralNetworkStatusFeededForward:
+            break;
+            
+        default:
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Wrong call sequence: network must be feeded forward before it can be back propagated"
+                                                                     userInfo:@{@"status": @(_status)}];
     }
+    
+    _status= MLNeuralNetworkStatusBackPropagated;
+    
+    // Output layer computes only the rows of the candidates
+    // of the class, the output buffer is not needed
+    _classCost= [outputLayer backPropagateClass:targetClass learningRate:learningRate];
+    
+    [self backPropagateLayersFromIndex:_layers.count -2 learningRate:learningRate];
 }
 
 - (void) updateWeights {
@@ -471,6 +936,7 @@ static const MLReal __one=                    1.0;
     // Check call sequence
     switch (_status) {
         case MLNeuralNetworkStatusBackPropagated:
+        case MLNeuralNetworkStatusBatchBackPropagated:
             break;
             
         default:
@@ -486,6 +952,34 @@ static const MLReal __one=                    1.0;
         
         [layer updateWeights];
     }
+    
+    [_embeddingLayer updateEmbeddings];
+}
+
+- (NSUInteger) computeTopClasses:(NSUInteger)k indices:(int *)indices probabilities:(MLReal *)probabilities {
+    
+    // Check call sequence
+    switch (_status) {
+        case MLNeuralNetworkStatusFeededForward:
+        case MLNeuralNetworkStatusBackPropagated:
+        case MLNeuralNetworkStatusWeightsUpdated:
+            break;
+            
+        default:
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Wrong call sequence: network must be feeded forward before top classes can be computed"
+                                                                     userInfo:@{@"status": @(_status)}];
+    }
+    
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers.lastObject;
+    
+    // Hierarchical softmax searches the tree from the input of the output
+    // layer, the others select from the outputs: feed them if skipped
+    if ((!_outputLayerFed) && (outputLayer.softmaxTrainingType != MLSoftmaxTrainingTypeHierarchical)) {
+        [outputLayer feedForward];
+        _outputLayerFed= YES;
+    }
+    
+    return [outputLayer selectTopClasses:k indices:indices probabilities:probabilities];
 }
 
 - (void) terminate {
@@ -496,38 +990,293 @@ static const MLReal __one=                    1.0;
     _outputBuffer= NULL;
     _errorBuffer= NULL;
     
+    _batchSize= 0;
+    _batchInputBuffer= NULL;
+    _batchOutputBuffer= NULL;
+    _batchErrorBuffer= NULL;
+    
     [_layers removeAllObjects];
     _layers= nil;
+    _embeddingLayer= nil;
 }
 
 
 #pragma mark -
-#pragma mark Configuration load/save
+#pragma mark Batch operations
 
-- (NSDictionary<NSString *, id> *) saveConfigurationToDictionary {
-    NSMutableDictionary<NSString *, id> *config= [[NSMutableDictionary alloc] initWithCapacity:_layers.count +1];
+- (void) setUpBatchOfSize:(NSUInteger)batchSize {
     
-    // Save the basic configuration
-    config[CONFIG_PARAM_COST_FUNCTION_TYPE]= @(_costType);
-    config[CONFIG_PARAM_OUTPUT_FUNCTION_TYPE]= @(_funcType);
-    config[CONFIG_PARAM_BACK_PROPAGATION_TYPE]= @(_backPropType);
-    config[CONFIG_PARAM_HIDDEN_FUNCTION_TYPE]= @(_hiddenFuncType);
-    config[CONFIG_PARAM_USE_BIAS]= @(_useBias);
+    // Set up batch buffers of each layer
+    for (MLLayer *layer in _layers)
+        [layer setUpBatchOfSize:batchSize];
     
-    // Save layer sizes
-    NSMutableArray<NSNumber *> *sizes= [[NSMutableArray alloc] initWithCapacity:_layers.count];
-    for (MLLayer *layer in _layers) {
-        BOOL hasBiasNeuron= ([layer isKindOfClass:[MLNeuronLayer class]] && ((MLNeuronLayer *) layer).usingBias);
-        [sizes addObject:@(layer.size - (hasBiasNeuron ? 1 : 0))];
-    }
+    _batchSize= batchSize;
+    _currentBatchSize= 0;
     
-    config[CONFIG_PARAM_LAYER_SIZES]= sizes;
+    _batchInputBuffer= ((MLInputLayer *) _layers.firstObject).batchInputBuffer;
+    _batchOutputBuffer= ((MLNeuronLayer *) _layers.lastObject).batchOutputBuffer;
+    _batchErrorBuffer= ((MLNeuronLayer *) _layers.lastObject).batchErrorBuffer;
     
-    // Save weights for each non-input layer
-    for (int i= 1; i < _layers.count; i++) {
-        MLNeuronLayer *neuronLayer= (MLNeuronLayer *) _layers[i];
-        MLLayer *previousLayer= neuronLayer.previousLayer;
-        
+    // Release previous expected output buffer, if any
+    MLFreeRealBuffer(_batchExpectedOutputBuffer);
+    
+    _batchExpectedOutputBuffer= MLAllocRealBuffer(batchSize * _outputSize);
+    ML_VCLR(_batchExpectedOutputBuffer, 1, batchSize * _outputSize);
+    
+    // Enlarge the workspace for cost computation to cover the whole batch
+    if (_costBufferSize < batchSize * _outputSize) {
+        MLFreeRealBuffer(_costBuffer);
+        
+        _costBufferSize= batchSize * _outputSize;
+        _costBuffer= MLAllocRealBuffer(_costBufferSize);
+    }
+}
+
+- (void) feedForwardBatchOfSize:(NSUInteger)size {
+    
+    // Checks
+    if (_batchSize == 0)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Network not yet set up for batch"
+                                                                 userInfo:nil];
+    
+    if ((size == 0) || (size > _batchSize))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid size: must be positive and not greater than the batch size"
+                                                                 userInfo:@{@"size": @(size),
+                                                                            @"batchSize": @(_batchSize)}];
+    
+    _status= MLNeuralNetworkStatusBatchFeededForward;
+    _currentBatchSize= size;
+    
+    // Apply forward propagation, one matrix multiplication per layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer feedForwardBatchOfSize:size];
+    }
+}
+
+- (void) backPropagateBatch {
+    
+    // Checks
+    switch (_backPropType) {
+        case MLBackPropagationTypeStandard:
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: standard backpropagation requires a positive learning rate"
+                                                                     userInfo:nil];
+            
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+        case MLBackPropagationTypeRMSProp:
+        case MLBackPropagationTypeAdam:
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: adaptive optimizers require a positive learning rate"
+                                                                     userInfo:nil];
+            
+        case MLBackPropagationTypeResilient:
+        case MLBackPropagationTypeImprovedResilient:
+            [self backPropagateBatchWithLearningRate:0.0];
+            break;
+    }
+}
+
+- (void) backPropagateBatchWithLearningRate:(MLReal)learningRate {
+    
+    // Checks
+    [self checkLearningRate:learningRate];
+    
+    if (_embeddingLayer.trainable)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Embeddings can't be trained by batch, set trainable to NO to freeze them"
+                                                                 userInfo:nil];
+    
+    // Check call sequence
+    switch (_status) {
+        case MLNeuralNetworkStatusBatchFeededForward:
+            break;
+            
+        default:
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Wrong call sequence: network must be feeded forward by batch before it can be back propagated by batch"
+                                                                     userInfo:@{@"status": @(_status)}];
+    }
+    
+    _status= MLNeuralNetworkStatusBatchBackPropagated;
+    
+    // Apply backward propagation, two matrix multiplications per layer
+    for (NSUInteger i= _layers.count -1; i > 0; i--) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        if (i == _layers.count -1) {
+            ML_PROFILE_BEGIN(_profileState, MLProfilePhaseErrorFetch);
+            
+            // Error on output layer is the difference between expected and actual output
+            ML_VSUB(_batchOutputBuffer, 1, _batchExpectedOutputBuffer, 1, _batchErrorBuffer, 1, _currentBatchSize * _outputSize);
+            
+            ML_PROFILE_END(_profileState, i, MLProfilePhaseErrorFetch,
+                           _currentBatchSize * _outputSize,
+                           3 * sizeof(MLReal) * _currentBatchSize * _outputSize);
+            
+        } else
+            [layer fetchBatchErrorFromNextLayerOfSize:_currentBatchSize];
+        
+        [layer backPropagateBatchOfSize:_currentBatchSize algorithm:_backPropType learningRate:learningRate costFunction:_costType];
+    }
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (void) checkLearningRate:(MLReal)learningRate {
+    switch (_backPropType) {
+        case MLBackPropagationTypeStandard:
+            if (learningRate <= 0.0)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: standard backpropagation requires a positive learning rate"
+                                                                         userInfo:@{@"learningRate": @(learningRate)}];
+            break;
+            
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+        case MLBackPropagationTypeRMSProp:
+        case MLBackPropagationTypeAdam:
+            if (learningRate <= 0.0)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: adaptive optimizers require a positive learning rate"
+                                                                         userInfo:@{@"learningRate": @(learningRate)}];
+            break;
+            
+        case MLBackPropagationTypeResilient:
+        case MLBackPropagationTypeImprovedResilient:
+            if (learningRate != 0.0)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: resilient backpropagation makes no use of learning rate, should not be passed"
+                                                                         userInfo:nil];
+            break;
+    }
+}
+
+- (void) feedForwardLayersFromIndex:(NSUInteger)index {
+    
+    // Output layer may be skipped when training with a softmax
+    // approximation, it is then computed on demand
+    NSUInteger count= _skipOutputLayer ? (_layers.count -1) : _layers.count;
+    
+    for (NSUInteger i= index; i < count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer feedForward];
+    }
+    
+    _outputLayerFed= !_skipOutputLayer;
+}
+
+- (void) backPropagateLayersFromIndex:(NSUInteger)index learningRate:(MLReal)learningRate {
+    for (NSUInteger i= index; i > 0; i--) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        [layer fetchErrorFromNextLayer];
+        [layer backPropagateWithAlgorithm:_backPropType learningRate:learningRate costFunction:_costType];
+    }
+    
+    // Embeddings of fed words, if any, get the error of the first layer
+    [_embeddingLayer backPropagateWithAlgorithm:_backPropType learningRate:learningRate];
+}
+
+- (MLReal) costOfOutputBuffer:(MLReal *)outputBuffer expectedOutputBuffer:(MLReal *)expectedOutputBuffer errorBuffer:(MLReal *)errorBuffer tempBuffer:(MLReal *)tempBuffer size:(NSUInteger)size {
+    MLReal cost= 0.0;
+    
+    switch (_costType) {
+        case MLCostFunctionTypeSquaredError: {
+            
+            // Apply formula: cost = 0.5 * Sum((expectedOutput[i] - output[i])^2)
+            ML_VSUB(outputBuffer, 1, expectedOutputBuffer, 1, errorBuffer, 1, size);
+            ML_SVESQ(errorBuffer, 1, &cost, size);
+            cost *= 0.5;
+            break;
+        }
+            
+        case MLCostFunctionTypeCrossEntropy: {
+            
+            // An "int" size is needed by vvlog,
+            // the others still use size
+            int intSize= (int) size;
+            
+            if (_funcType == MLActivationFunctionTypeSoftmax) {
+                
+                // Apply formula: cost = -Sum(expectedOutput[i] * ln(output[i]))
+                ML_VVLOG(tempBuffer, outputBuffer, &intSize);
+                ML_DOTPR(tempBuffer, 1, expectedOutputBuffer, 1, &cost, size);
+                cost *= -1.0;
+                break;
+            }
+            
+            // Apply formula: cost = -Sum(expectedOutput[i] * ln(output[i]) + (1 - expectedOutput[i]) * ln(1 - output[i]))
+            ML_VSMUL(outputBuffer, 1, &__minusOne, tempBuffer, 1, size);
+            ML_VSADD(tempBuffer, 1, &__one, tempBuffer, 1, size);
+            ML_VVLOG(errorBuffer, tempBuffer, &intSize);
+            
+            ML_VMUL(errorBuffer, 1, expectedOutputBuffer, 1, tempBuffer, 1, size);
+            ML_VSMUL(tempBuffer, 1, &__minusOne, tempBuffer, 1, size);
+            ML_VADD(tempBuffer, 1, errorBuffer, 1, errorBuffer, 1, size);
+            
+            ML_VVLOG(tempBuffer, outputBuffer, &intSize);
+            ML_VMUL(tempBuffer, 1, expectedOutputBuffer, 1, tempBuffer, 1, size);
+            ML_VADD(tempBuffer, 1, errorBuffer, 1, errorBuffer, 1, size);
+            
+            ML_SVE(errorBuffer, 1, &cost, size);
+            cost *= -1.0;
+            break;
+        }
+    }
+    
+    return cost;
+}
+
+
+#pragma mark -
+#pragma mark Configuration load/save
+
+- (NSDictionary<NSString *, id> *) saveConfigurationToDictionary {
+    NSMutableDictionary<NSString *, id> *config= [[NSMutableDictionary alloc] initWithCapacity:_layers.count +1];
+    
+    // Save the basic configuration
+    config[CONFIG_PARAM_COST_FUNCTION_TYPE]= @(_costType);
+    config[CONFIG_PARAM_OUTPUT_FUNCTION_TYPE]= @(_funcType);
+    config[CONFIG_PARAM_BACK_PROPAGATION_TYPE]= @(_backPropType);
+    config[CONFIG_PARAM_HIDDEN_FUNCTION_TYPE]= @(_hiddenFuncType);
+    config[CONFIG_PARAM_USE_BIAS]= @(_useBias);
+    
+    // Save layer sizes
+    NSMutableArray<NSNumber *> *sizes= [[NSMutableArray alloc] initWithCapacity:_layers.count];
+    for (MLLayer *layer in _layers) {
+        BOOL hasBiasNeuron= ([layer isKindOfClass:[MLNeuronLayer class]] && ((MLNeuronLayer *) layer).usingBias);
+        [sizes addObject:@(layer.size - (hasBiasNeuron ? 1 : 0))];
+    }
+    
+    config[CONFIG_PARAM_LAYER_SIZES]= sizes;
+    
+    // Save embeddings, if any
+    if (_embeddingLayer) {
+        NSUInteger embeddingsCount= _embeddingLayer.vocabularySize * _embeddingLayer.size;
+        
+        NSMutableArray<NSNumber *> *embeddings= [[NSMutableArray alloc] initWithCapacity:embeddingsCount];
+        for (NSUInteger i= 0; i < embeddingsCount; i++)
+            [embeddings addObject:@(_embeddingLayer.embeddings[i])];
+        
+        config[CONFIG_PARAM_VOCABULARY_SIZE]= @(_embeddingLayer.vocabularySize);
+        config[CONFIG_PARAM_EMBEDDING_POOLING_TYPE]= @(_embeddingLayer.poolingType);
+        config[CONFIG_PARAM_EMBEDDINGS]= embeddings;
+    }
+    
+    // Save softmax training approximation, if any
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers.lastObject;
+    if (outputLayer.softmaxTrainingType != MLSoftmaxTrainingTypeFull) {
+        config[CONFIG_PARAM_SOFTMAX_TRAINING_TYPE]= @(outputLayer.softmaxTrainingType);
+        config[CONFIG_PARAM_SOFTMAX_SAMPLES]= @(outputLayer.sampledSoftmaxSamples);
+        
+        if (outputLayer.classCounts)
+            config[CONFIG_PARAM_CLASS_COUNTS]= outputLayer.classCounts;
+    }
+    
+    // Save weights for each non-input layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *neuronLayer= (MLNeuronLayer *) _layers[i];
+        MLLayer *previousLayer= neuronLayer.previousLayer;
+        
         NSMutableArray<NSDictionary<NSString *, id> *> *layerConfig= [[NSMutableArray alloc] initWithCapacity:neuronLayer.size];
         for (int j= 0; j < neuronLayer.size; j++) {
             MLNeuron *neuron= neuronLayer.neurons[j];
@@ -550,10 +1299,291 @@ static const MLReal __one=                    1.0;
 }
 
 
+- (void) saveModelToFile:(NSString *)path {
+    NSUInteger layerCount= _layers.count;
+    
+    // Prepare header and layer descriptors, with space up to the first weight matrix
+    NSUInteger offset= MODEL_FILE_ALIGN(sizeof(MLModelFileHeader) + (layerCount * sizeof(MLModelFileLayer)));
+    NSMutableData *data= [NSMutableData dataWithLength:offset];
+    
+    MLModelFileHeader *header= (MLModelFileHeader *) data.mutableBytes;
+    header->magic= MODEL_FILE_MAGIC;
+    header->version= MODEL_FILE_VERSION;
+    header->realSize= sizeof(MLReal);
+    header->layerCount= (uint32_t) layerCount;
+    header->useBias= _useBias;
+    header->costType= (uint32_t) _costType;
+    header->backPropType= (uint32_t) _backPropType;
+    header->hiddenFuncType= (uint32_t) _hiddenFuncType;
+    header->outputFuncType= (uint32_t) _funcType;
+    header->weightsStorageType= (uint32_t) self.weightsStorageType;
+    
+    MLNeuronLayer *outputLayer= (MLNeuronLayer *) _layers.lastObject;
+    header->softmaxTrainingType= (uint32_t) outputLayer.softmaxTrainingType;
+    header->sampledSoftmaxSamples= (uint32_t) outputLayer.sampledSoftmaxSamples;
+    
+    // Weights stored in half precision are saved as they are
+    BOOL halfWeights= (header->weightsStorageType != MLWeightsStorageTypeReal);
+    NSUInteger weightSize= halfWeights ? sizeof(MLHalf) : sizeof(MLReal);
+    
+    MLModelFileLayer *layerDescs= (MLModelFileLayer *) (header +1);
+    for (NSUInteger i= 0; i < layerCount; i++) {
+        MLLayer *layer= _layers[i];
+        BOOL hasBiasNeuron= ([layer isKindOfClass:[MLNeuronLayer class]] && ((MLNeuronLayer *) layer).usingBias);
+        
+        layerDescs[i].size= layer.size - (hasBiasNeuron ? 1 : 0);
+        
+        if (i > 0) {
+            layerDescs[i].weightsCount= layer.size * layer.previousLayer.size;
+            layerDescs[i].weightsOffset= offset;
+            
+            offset= MODEL_FILE_ALIGN(offset + (layerDescs[i].weightsCount * weightSize));
+            
+        } else if (_embeddingLayer) {
+            layerDescs[i].weightsCount= _embeddingLayer.vocabularySize * layer.size;
+            layerDescs[i].weightsOffset= offset;
+            layerDescs[i].poolingType= _embeddingLayer.poolingType;
+            
+            offset= MODEL_FILE_ALIGN(offset + (layerDescs[i].weightsCount * sizeof(MLReal)));
+        }
+    }
+    
+    // Append the embedding matrix first, it is never in half precision
+    if (_embeddingLayer) {
+        NSUInteger embeddingsCount= layerDescs[0].weightsCount;
+        
+        [data appendBytes:_embeddingLayer.embeddings length:embeddingsCount * sizeof(MLReal)];
+        
+        [data setLength:MODEL_FILE_ALIGN(data.length)];
+    }
+    
+    // Append weight matrices, padding each to the alignment
+    for (NSUInteger i= 1; i < layerCount; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        NSUInteger weightsCount= layer.size * layer.previousLayer.size;
+        
+        if (halfWeights)
+            [data appendBytes:layer.halfWeights length:weightsCount * sizeof(MLHalf)];
+        else
+            [data appendBytes:layer.weights length:weightsCount * sizeof(MLReal)];
+        
+        [data setLength:MODEL_FILE_ALIGN(data.length)];
+    }
+    
+    // Append class counts of the softmax approximation, if any
+    if (outputLayer.classCounts) {
+        for (NSNumber *count in outputLayer.classCounts) {
+            MLReal value= (MLReal) count.doubleValue;
+            [data appendBytes:&value length:sizeof(MLReal)];
+        }
+    }
+    
+    NSError *error= nil;
+    if (![data writeToFile:path options:NSDataWritingAtomic error:&error])
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while writing model file"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"error": error}];
+}
+
++ (MLNeuralNetwork *) createNetworkFromModelFile:(NSString *)path mapped:(BOOL)mapped {
+    
+    // When mapped, the file is shared with other processes through the page cache
+    NSError *error= nil;
+    NSData *data= [NSData dataWithContentsOfFile:path
+                                         options:(mapped ? NSDataReadingMappedAlways : 0)
+                                           error:&error];
+    if (!data)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while reading model file"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"error": error}];
+    
+    // Check header
+    if (data.length < sizeof(MLModelFileHeader))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: file too short"
+                                                                 userInfo:@{@"path": path}];
+    
+    const MLModelFileHeader *header= (const MLModelFileHeader *) data.bytes;
+    if (header->magic != MODEL_FILE_MAGIC)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: wrong magic number or byte order"
+                                                                 userInfo:@{@"path": path}];
+    
+    if (header->version != MODEL_FILE_VERSION)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: unsupported version"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"version": @(header->version)}];
+    
+    if (header->realSize != sizeof(MLReal))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: weights precision differs from MLReal"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"realSize": @(header->realSize)}];
+    
+    if (header->weightsStorageType > MLWeightsStorageTypeBFloat16)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: unsupported weights storage type"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"weightsStorageType": @(header->weightsStorageType)}];
+    
+    // Master weights of half-precision models must be converted
+    BOOL halfWeights= (header->weightsStorageType != MLWeightsStorageTypeReal);
+    NSUInteger weightSize= halfWeights ? sizeof(MLHalf) : sizeof(MLReal);
+    
+    if (mapped && halfWeights)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't map a model file with half-precision weights, load it by copy"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"weightsStorageType": @(header->weightsStorageType)}];
+    
+    if ((header->layerCount < 2) ||
+        (data.length < sizeof(MLModelFileHeader) + (header->layerCount * sizeof(MLModelFileLayer))))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: wrong layer count"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"layerCount": @(header->layerCount)}];
+    
+    // Create the network
+    const MLModelFileLayer *layerDescs= (const MLModelFileLayer *) (header +1);
+    
+    NSMutableArray<NSNumber *> *sizes= [[NSMutableArray alloc] initWithCapacity:header->layerCount];
+    for (NSUInteger i= 0; i < header->layerCount; i++)
+        [sizes addObject:@(layerDescs[i].size)];
+    
+    // Input layer has weights only if it is an embedding layer
+    if ((layerDescs[0].weightsCount > 0) &&
+        ((layerDescs[0].size == 0) || (layerDescs[0].weightsCount % layerDescs[0].size != 0)))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: wrong embeddings block"
+                                                                 userInfo:@{@"path": path}];
+    
+    NSUInteger vocabularySize= (layerDescs[0].weightsCount > 0) ? (NSUInteger) (layerDescs[0].weightsCount / layerDescs[0].size) : 0;
+    
+    MLNeuralNetwork *network= [[MLNeuralNetwork alloc] initWithVocabularySize:vocabularySize
+                                                         embeddingPoolingType:(MLEmbeddingPoolingType) layerDescs[0].poolingType
+                                                                   layerSizes:sizes
+                                                                      useBias:(header->useBias != 0)
+                                                             costFunctionType:header->costType
+                                                          backPropagationType:header->backPropType
+                                                           hiddenFunctionType:header->hiddenFuncType
+                                                           outputFunctionType:header->outputFuncType];
+    
+    // Get embeddings, always by copy since they may be trained
+    if (vocabularySize > 0) {
+        NSUInteger embeddingsCount= (NSUInteger) layerDescs[0].weightsCount;
+        
+        if ((layerDescs[0].weightsOffset % MODEL_FILE_ALIGNMENT != 0) ||
+            (layerDescs[0].weightsOffset + (embeddingsCount * sizeof(MLReal)) > data.length))
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: wrong embeddings block"
+                                                                     userInfo:@{@"path": path}];
+        
+        const void *embeddings= ((const char *) data.bytes) + layerDescs[0].weightsOffset;
+        
+        memcpy(network.embeddingLayer.embeddings, embeddings, embeddingsCount * sizeof(MLReal));
+    }
+    
+    // Get weights, in place if mapped
+    for (NSUInteger i= 1; i < header->layerCount; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) network.layers[i];
+        NSUInteger weightsCount= layer.size * layer.previousLayer.size;
+        
+        if ((layerDescs[i].weightsCount != weightsCount) ||
+            (layerDescs[i].weightsOffset % MODEL_FILE_ALIGNMENT != 0) ||
+            (layerDescs[i].weightsOffset + (weightsCount * weightSize) > data.length))
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: wrong weights block"
+                                                                     userInfo:@{@"path": path,
+                                                                                @"layer": @(i)}];
+        
+        const void *weights= ((const char *) data.bytes) + layerDescs[i].weightsOffset;
+        
+        if (mapped)
+            [layer useWeights:(MLReal *) weights ownedBy:data readOnly:YES];
+        else if (halfWeights)
+            MLConvertHalfToReal(header->weightsStorageType, (const MLHalf *) weights, layer.weights, weightsCount);
+        else
+            memcpy(layer.weights, weights, weightsCount * sizeof(MLReal));
+    }
+    
+    // Half-precision copy is converted back from master weights, exactly
+    if (halfWeights)
+        network.weightsStorageType= header->weightsStorageType;
+    
+    // Get class counts of the softmax approximation, if any, they follow the last weights
+    if (header->softmaxTrainingType != MLSoftmaxTrainingTypeFull) {
+        const MLModelFileLayer *lastDesc= &layerDescs[header->layerCount -1];
+        NSUInteger countsOffset= (NSUInteger) MODEL_FILE_ALIGN(lastDesc->weightsOffset + (lastDesc->weightsCount * weightSize));
+        NSUInteger outputSize= network.outputSize;
+        
+        NSArray<NSNumber *> *classCounts= nil;
+        if (countsOffset + (outputSize * sizeof(MLReal)) <= data.length) {
+            const MLReal *counts= (const MLReal *) (((const char *) data.bytes) + countsOffset);
+            
+            NSMutableArray<NSNumber *> *loadedCounts= [[NSMutableArray alloc] initWithCapacity:outputSize];
+            for (NSUInteger i= 0; i < outputSize; i++)
+                [loadedCounts addObject:@(counts[i])];
+            
+            classCounts= loadedCounts;
+        }
+        
+        switch (header->softmaxTrainingType) {
+            case MLSoftmaxTrainingTypeSampled:
+                [network setUpSampledSoftmaxWithSamples:header->sampledSoftmaxSamples classCounts:classCounts];
+                break;
+                
+            case MLSoftmaxTrainingTypeHierarchical:
+                if (!classCounts)
+                    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: missing class counts"
+                                                                             userInfo:@{@"path": path}];
+                
+                [network setUpHierarchicalSoftmaxWithClassCounts:classCounts];
+                break;
+                
+            default:
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid model file: unsupported softmax training type"
+                                                                         userInfo:@{@"path": path,
+                                                                                    @"softmaxTrainingType": @(header->softmaxTrainingType)}];
+        }
+    }
+    
+    return network;
+}
+
+
+#pragma mark -
+#pragma mark Profiling
+
+- (void) enableProfilingWithMaxTraceEvents:(NSUInteger)maxTraceEvents {
+#ifdef ML_DISABLE_PROFILING
+    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Profiling has been disabled at compile time"
+                                                             userInfo:nil];
+#else // ML_DISABLE_PROFILING
+    
+    // Counters are indexed by layer, input layer included
+    _profile= [[MLNeuralNetworkProfile alloc] initWithLayers:_layers.count maxTraceEvents:maxTraceEvents];
+    _profileState= _profile.state;
+    
+    // Propagate to each neuron layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        layer.profile= _profile;
+    }
+#endif // ML_DISABLE_PROFILING
+}
+
+- (void) disableProfiling {
+    _profile= nil;
+    _profileState= NULL;
+    
+    // Propagate to each neuron layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        layer.profile= nil;
+    }
+}
+
 #pragma mark -
 #pragma mark Properties
 
 @synthesize layers= _layers;
+@synthesize embeddingLayer= _embeddingLayer;
+
+@synthesize costType= _costType;
+@synthesize backPropType= _backPropType;
 
 @synthesize inputSize= _inputSize;
 @synthesize inputBuffer= _inputBuffer;
@@ -565,50 +1595,149 @@ static const MLReal __one=                    1.0;
 @dynamic cost;
 
 - (MLReal) cost {
-    MLReal cost= 0.0;
+    return [self costOfOutputBuffer:_outputBuffer
+               expectedOutputBuffer:_expectedOutputBuffer
+                        errorBuffer:_errorBuffer
+                         tempBuffer:_costBuffer
+                               size:_outputSize];
+}
+
+@synthesize classCost= _classCost;
+
+@synthesize batchSize= _batchSize;
+@synthesize batchInputBuffer= _batchInputBuffer;
+@synthesize batchOutputBuffer= _batchOutputBuffer;
+@synthesize batchExpectedOutputBuffer= _batchExpectedOutputBuffer;
+
+@dynamic batchCost;
+
+- (MLReal) batchCost {
+    if (_currentBatchSize == 0)
+        return 0.0;
     
-    switch (_costType) {
-        case MLCostFunctionTypeSquaredError: {
-            
-            // Apply formula: cost = 0.5 * Sum((expectedOutput[i] - output[i])^2)
-            ML_VSUB(_outputBuffer, 1, _expectedOutputBuffer, 1, _errorBuffer, 1, _outputSize);
-            ML_SVESQ(_errorBuffer, 1, &cost, _outputSize);
-            cost *= 0.5;
-            break;
-        }
-            
-        case MLCostFunctionTypeCrossEntropy: {
-            MLReal *tempBuffer= MLAllocRealBuffer(_outputSize);
-            
-            // An "int" size is needed by vvlog,
-            // the others still use _outputSize
-            int outputSize= (int) _outputSize;
-            
-            // Apply formula: cost = -Sum(expectedOutput[i] * ln(output[i]) + (1 - expectedOutput[i]) * ln(1 - output[i]))
-            ML_VSMUL(_outputBuffer, 1, &__minusOne, tempBuffer, 1, _outputSize);
-            ML_VSADD(tempBuffer, 1, &__one, tempBuffer, 1, _outputSize);
-            ML_VVLOG(_errorBuffer, tempBuffer, &outputSize);
-            
-            ML_VMUL(_errorBuffer, 1, _expectedOutputBuffer, 1, tempBuffer, 1, _outputSize);
-            ML_VSMUL(tempBuffer, 1, &__minusOne, tempBuffer, 1, _outputSize);
-            ML_VADD(tempBuffer, 1, _errorBuffer, 1, _errorBuffer, 1, _outputSize);
-            
-            ML_VVLOG(tempBuffer, _outputBuffer, &outputSize);
-            ML_VMUL(tempBuffer, 1, _expectedOutputBuffer, 1, tempBuffer, 1, _outputSize);
-            ML_VADD(tempBuffer, 1, _errorBuffer, 1, _errorBuffer, 1, _outputSize);
-            
-            ML_SVE(_errorBuffer, 1, &cost, _outputSize);
-            cost *= -1.0;
-            
-            MLFreeRealBuffer(tempBuffer);
-            break;
-        }
+    // Cost is summed over all samples of the current batch
+    return [self costOfOutputBuffer:_batchOutputBuffer
+               expectedOutputBuffer:_batchExpectedOutputBuffer
+                        errorBuffer:_batchErrorBuffer
+                         tempBuffer:_costBuffer
+                               size:_currentBatchSize * _outputSize];
+}
+
+@synthesize status= _status;
+
+@dynamic readOnly;
+
+- (BOOL) readOnly {
+    return ((MLNeuronLayer *) _layers.lastObject).weightsReadOnly;
+}
+
+@dynamic fastApproximateActivation;
+
+- (BOOL) fastApproximateActivation {
+    return ((MLNeuronLayer *) _layers.lastObject).fastApproximateActivation;
+}
+
+- (void) setFastApproximateActivation:(BOOL)fastApproximateActivation {
+    
+    // Propagate to each neuron layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        layer.fastApproximateActivation= fastApproximateActivation;
     }
+}
+
+@dynamic momentum;
+
+- (MLReal) momentum {
+    return ((MLNeuronLayer *) _layers.lastObject).momentum;
+}
+
+- (void) setMomentum:(MLReal)momentum {
     
-    return cost;
+    // Propagate to each neuron layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        layer.momentum= momentum;
+    }
 }
 
-@synthesize status= _status;
+@dynamic decayRate;
+
+- (MLReal) decayRate {
+    return ((MLNeuronLayer *) _layers.lastObject).decayRate;
+}
+
+- (void) setDecayRate:(MLReal)decayRate {
+    
+    // Propagate to each neuron layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        layer.decayRate= decayRate;
+    }
+}
+
+@dynamic epsilon;
+
+- (MLReal) epsilon {
+    return ((MLNeuronLayer *) _layers.lastObject).epsilon;
+}
+
+- (void) setEpsilon:(MLReal)epsilon {
+    
+    // Propagate to each neuron layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        layer.epsilon= epsilon;
+    }
+}
+
+@dynamic weightsStorageType;
+
+- (MLWeightsStorageType) weightsStorageType {
+    return ((MLNeuronLayer *) _layers.lastObject).weightsStorageType;
+}
+
+- (void) setWeightsStorageType:(MLWeightsStorageType)weightsStorageType {
+    
+    // Propagate to each neuron layer
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        
+        layer.weightsStorageType= weightsStorageType;
+    }
+}
+
+@dynamic sparsity;
+
+- (MLReal) sparsity {
+    NSUInteger weightsCount= 0;
+    NSUInteger nonzeroCount= 0;
+    
+    // Unpruned layers count as dense
+    for (int i= 1; i < _layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) _layers[i];
+        NSUInteger count= (layer.usingBias ? (layer.size -1) : layer.size) * layer.previousLayer.size;
+        
+        weightsCount += count;
+        nonzeroCount += layer.pruned ? layer.nonzeroWeightsCount : count;
+    }
+    
+    return 1.0 - (((MLReal) nonzeroCount) / ((MLReal) weightsCount));
+}
+
+@dynamic softmaxTrainingType;
+
+- (MLSoftmaxTrainingType) softmaxTrainingType {
+    return ((MLNeuronLayer *) _layers.lastObject).softmaxTrainingType;
+}
+
+@synthesize skipOutputLayer= _skipOutputLayer;
+
+@synthesize profile= _profile;
 
 
 @end
@@ -0,0 +1,209 @@
+//
+//  MLNeuralNetworkContext.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLNeuralNetworkContext.h"
+#import "MLNeuralNetwork.h"
+#import "MLNeuronLayer.h"
+#import "MLNeuralNetworkException.h"
+
+#import "MLAlloc.h"
+
+
+#pragma mark -
+#pragma mark NeuralNetworkContext extension
+
+@interface MLNeuralNetworkContext () {
+    MLNeuralNetwork *_network;
+    NSArray<MLNeuronLayer *> *_layers;
+    
+    NSUInteger _inputSize;
+    MLReal *_inputBuffer;
+    
+    NSUInteger _outputSize;
+    MLReal *_outputBuffer;
+    
+    NSUInteger _batchSize;
+    MLReal *_batchInputBuffer;
+    MLReal *_batchOutputBuffer;
+    
+    MLReal **_layerOutputBuffers;
+    MLReal **_layerBatchOutputBuffers;
+}
+
+
+@end
+
+
+#pragma mark -
+#pragma mark NeuralNetworkContext implementation
+
+@implementation MLNeuralNetworkContext
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (instancetype) init {
+    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"MLNeuralNetworkContext class must be initialized properly"
+                                                             userInfo:nil];
+}
+
+- (instancetype) initWithNetwork:(MLNeuralNetwork *)network {
+    return [self initWithNetwork:network batchSize:0];
+}
+
+- (instancetype) initWithNetwork:(MLNeuralNetwork *)network batchSize:(NSUInteger)batchSize {
+    if ((self = [super init])) {
+        
+        // Initialization
+        _network= network;
+        _layers= (NSArray<MLNeuronLayer *> *) [network.layers subarrayWithRange:NSMakeRange(1, network.layers.count -1)];
+        
+        _inputSize= network.inputSize;
+        _outputSize= network.outputSize;
+        _batchSize= batchSize;
+        
+        // Allocate one output buffer for each neuron layer,
+        // the context owns only activations, not weights
+        _inputBuffer= MLAllocRealBuffer(_inputSize);
+        ML_VCLR(_inputBuffer, 1, _inputSize);
+        
+        _layerOutputBuffers= MLAllocRealPointerBuffer(_layers.count);
+        
+        for (NSUInteger i= 0; i < _layers.count; i++) {
+            _layerOutputBuffers[i]= MLAllocRealBuffer(_layers[i].size);
+            ML_VCLR(_layerOutputBuffers[i], 1, _layers[i].size);
+        }
+        
+        _outputBuffer= _layerOutputBuffers[_layers.count -1];
+        
+        if (batchSize > 0) {
+            
+            // Same for batch, with one row per sample
+            _batchInputBuffer= MLAllocRealBuffer(batchSize * _inputSize);
+            ML_VCLR(_batchInputBuffer, 1, batchSize * _inputSize);
+            
+            _layerBatchOutputBuffers= MLAllocRealPointerBuffer(_layers.count);
+            
+            for (NSUInteger i= 0; i < _layers.count; i++) {
+                _layerBatchOutputBuffers[i]= MLAllocRealBuffer(batchSize * _layers[i].size);
+                ML_VCLR(_layerBatchOutputBuffers[i], 1, batchSize * _layers[i].size);
+            }
+            
+            _batchOutputBuffer= _layerBatchOutputBuffers[_layers.count -1];
+        }
+    }
+    
+    return self;
+}
+
+- (void) dealloc {
+    
+    // Deallocate buffers
+    MLFreeRealBuffer(_inputBuffer);
+    _inputBuffer= NULL;
+    
+    for (NSUInteger i= 0; i < _layers.count; i++)
+        MLFreeRealBuffer(_layerOutputBuffers[i]);
+    
+    MLFreeRealPointerBuffer(_layerOutputBuffers);
+    _layerOutputBuffers= NULL;
+    _outputBuffer= NULL;
+    
+    // Deallocate batch buffers
+    MLFreeRealBuffer(_batchInputBuffer);
+    _batchInputBuffer= NULL;
+    
+    if (_layerBatchOutputBuffers) {
+        for (NSUInteger i= 0; i < _layers.count; i++)
+            MLFreeRealBuffer(_layerBatchOutputBuffers[i]);
+        
+        MLFreeRealPointerBuffer(_layerBatchOutputBuffers);
+        _layerBatchOutputBuffers= NULL;
+    }
+    
+    _batchOutputBuffer= NULL;
+}
+
+
+#pragma mark -
+#pragma mark Operations
+
+- (void) feedForward {
+    MLReal *inputBuffer= _inputBuffer;
+    
+    // Apply forward propagation using the weights of the network
+    // and the buffers of this context, the network is not modified
+    for (NSUInteger i= 0; i < _layers.count; i++) {
+        [_layers[i] feedForwardBatchOfSize:1 inputBuffer:inputBuffer outputBuffer:_layerOutputBuffers[i]];
+        
+        inputBuffer= _layerOutputBuffers[i];
+    }
+}
+
+- (void) feedForwardBatchOfSize:(NSUInteger)size {
+    
+    // Checks
+    if ((size == 0) || (size > _batchSize))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid size: must be positive and not greater than the batch size"
+                                                                 userInfo:@{@"size": @(size),
+                                                                            @"batchSize": @(_batchSize)}];
+    
+    MLReal *inputBuffer= _batchInputBuffer;
+    
+    // Apply forward propagation, one matrix multiplication per layer
+    for (NSUInteger i= 0; i < _layers.count; i++) {
+        [_layers[i] feedForwardBatchOfSize:size inputBuffer:inputBuffer outputBuffer:_layerBatchOutputBuffers[i]];
+        
+        inputBuffer= _layerBatchOutputBuffers[i];
+    }
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+@synthesize network= _network;
+
+@synthesize inputSize= _inputSize;
+@synthesize inputBuffer= _inputBuffer;
+
+@synthesize outputSize= _outputSize;
+@synthesize outputBuffer= _outputBuffer;
+
+@synthesize batchSize= _batchSize;
+@synthesize batchInputBuffer= _batchInputBuffer;
+@synthesize batchOutputBuffer= _batchOutputBuffer;
+
+
+@end
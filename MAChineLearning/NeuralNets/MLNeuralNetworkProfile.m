@@ -0,0 +1,268 @@
+//
+//  MLNeuralNetworkProfile.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLNeuralNetworkProfile.h"
+#import "MLProfileCounters.h"
+#import "MLNeuralNetworkException.h"
+
+
+#pragma mark -
+#pragma mark NeuralNetworkProfile extension
+
+@interface MLNeuralNetworkProfile () {
+    MLProfileState _state;
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (MLProfileCounter *) counterOfLayer:(NSUInteger)layer phase:(MLProfilePhase)phase;
+
+
+@end
+
+
+#pragma mark -
+#pragma mark Static constants and variables
+
+static NSString * const __phaseNames[ML_PROFILE_PHASES]= {
+    @"feedForward",
+    @"activation",
+    @"errorFetch",
+    @"backPropagation",
+    @"weightsUpdate",
+};
+
+static uint32_t __nextThreadIndex= 0;
+static __thread uint32_t __threadIndex= 0;
+
+
+#pragma mark -
+#pragma mark Thread index
+
+uint32_t MLProfileThreadIndex(void) {
+    
+    // Indexes start from 1, 0 means not yet assigned
+    if (__threadIndex == 0)
+        __threadIndex= __atomic_add_fetch(&__nextThreadIndex, 1, __ATOMIC_RELAXED);
+    
+    return __threadIndex;
+}
+
+
+#pragma mark -
+#pragma mark NeuralNetworkProfile implementation
+
+@implementation MLNeuralNetworkProfile
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (instancetype) init {
+    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"MLNeuralNetworkProfile class must be initialized properly"
+                                                             userInfo:nil];
+}
+
+- (instancetype) initWithLayers:(NSUInteger)layers maxTraceEvents:(NSUInteger)maxTraceEvents {
+    if ((self = [super init])) {
+        
+        // Checks
+        if (layers == 0)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid number of layers: must be positive"
+                                                                     userInfo:nil];
+        
+        // Allocate counters and trace events
+        _state.layers= layers;
+        _state.counters= calloc(layers * ML_PROFILE_PHASES, sizeof(MLProfileCounter));
+        if (!_state.counters)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while allocating counters"
+                                                                     userInfo:nil];
+        
+        _state.maxEvents= maxTraceEvents;
+        if (maxTraceEvents > 0) {
+            _state.events= calloc(maxTraceEvents, sizeof(MLProfileEvent));
+            if (!_state.events)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while allocating trace events"
+                                                                         userInfo:@{@"maxTraceEvents": @(maxTraceEvents)}];
+        }
+        
+        _state.origin= MLProfileNow();
+    }
+    
+    return self;
+}
+
+- (void) dealloc {
+    free(_state.counters);
+    _state.counters= NULL;
+    
+    free(_state.events);
+    _state.events= NULL;
+}
+
+
+#pragma mark -
+#pragma mark Counters
+
+- (NSUInteger) callsOfLayer:(NSUInteger)layer phase:(MLProfilePhase)phase {
+    return (NSUInteger) [self counterOfLayer:layer phase:phase]->calls;
+}
+
+- (NSTimeInterval) timeOfLayer:(NSUInteger)layer phase:(MLProfilePhase)phase {
+    return ((NSTimeInterval) [self counterOfLayer:layer phase:phase]->time) / 1.0e9;
+}
+
+- (uint64_t) flopsOfLayer:(NSUInteger)layer phase:(MLProfilePhase)phase {
+    return [self counterOfLayer:layer phase:phase]->flops;
+}
+
+- (uint64_t) bytesOfLayer:(NSUInteger)layer phase:(MLProfilePhase)phase {
+    return [self counterOfLayer:layer phase:phase]->bytes;
+}
+
+- (void) reset {
+    memset(_state.counters, 0, _state.layers * ML_PROFILE_PHASES * sizeof(MLProfileCounter));
+    
+    _state.eventCount= 0;
+    _state.origin= MLProfileNow();
+}
+
+
+#pragma mark -
+#pragma mark Reporting
+
+- (NSString *) report {
+    NSMutableString *report= [[NSMutableString alloc] init];
+    [report appendFormat:@"%-6s %-16s %10s %12s %10s %10s\n", "Layer", "Phase", "Calls", "Time (ms)", "GFLOP/s", "GB/s"];
+    
+    for (NSUInteger layer= 0; layer < _state.layers; layer++) {
+        for (NSUInteger phase= 0; phase < ML_PROFILE_PHASES; phase++) {
+            MLProfileCounter *counter= &_state.counters[layer * ML_PROFILE_PHASES + phase];
+            if (counter->calls == 0)
+                continue;
+            
+            // FLOP and byte counts per nanosecond are G-units per second
+            double time= (double) counter->time;
+            [report appendFormat:@"%-6lu %-16s %10llu %12.3f %10.3f %10.3f\n",
+             (unsigned long) layer,
+             __phaseNames[phase].UTF8String,
+             counter->calls,
+             time / 1.0e6,
+             (time > 0.0) ? ((double) counter->flops) / time : 0.0,
+             (time > 0.0) ? ((double) counter->bytes) / time : 0.0];
+        }
+    }
+    
+    return report;
+}
+
+- (NSData *) chromeTrace {
+    NSUInteger eventCount= MIN(_state.eventCount, _state.maxEvents);
+    
+    // Events are complete events ("ph": "X") with times in microseconds,
+    // see the Trace Event Format specification of Chrome's about:tracing
+    NSMutableString *trace= [[NSMutableString alloc] initWithCapacity:64 + eventCount * 160];
+    [trace appendString:@"{\"traceEvents\":["];
+    
+    for (NSUInteger i= 0; i < eventCount; i++) {
+        MLProfileEvent *event= &_state.events[i];
+        
+        [trace appendFormat:@"%@{\"name\":\"%@\",\"cat\":\"layer%u\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"layer\":%u}}",
+         (i > 0) ? @"," : @"",
+         __phaseNames[event->phase],
+         event->layer,
+         ((double) event->start) / 1000.0,
+         ((double) event->duration) / 1000.0,
+         event->thread,
+         event->layer];
+    }
+    
+    [trace appendString:@"],\"displayTimeUnit\":\"ms\"}"];
+    
+    return [trace dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void) writeChromeTraceToFile:(NSString *)path {
+    NSData *data= [self chromeTrace];
+    
+    NSError *error= nil;
+    if (![data writeToFile:path options:NSDataWritingAtomic error:&error])
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while writing trace file"
+                                                                 userInfo:@{@"path": path,
+                                                                            @"error": error}];
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (MLProfileCounter *) counterOfLayer:(NSUInteger)layer phase:(MLProfilePhase)phase {
+    if ((layer >= _state.layers) || (phase >= ML_PROFILE_PHASES))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Layer or phase out of range"
+                                                                 userInfo:@{@"layer": @(layer),
+                                                                            @"phase": @(phase),
+                                                                            @"layers": @(_state.layers)}];
+    
+    return &_state.counters[layer * ML_PROFILE_PHASES + phase];
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+@dynamic layers;
+
+- (NSUInteger) layers {
+    return _state.layers;
+}
+
+@dynamic maxTraceEvents;
+
+- (NSUInteger) maxTraceEvents {
+    return _state.maxEvents;
+}
+
+@dynamic traceEventCount;
+
+- (NSUInteger) traceEventCount {
+    return MIN(_state.eventCount, _state.maxEvents);
+}
+
+- (MLProfileState *) state {
+    return &_state;
+}
+
+
+@end
@@ -39,7 +39,9 @@ typedef NS_ENUM(NSUInteger, MLNeuralNetworkStatus) {
 	MLNeuralNetworkStatusIdle= 0,
 	MLNeuralNetworkStatusFeededForward,
 	MLNeuralNetworkStatusBackPropagated,
-	MLNeuralNetworkStatusWeightsUpdated
+	MLNeuralNetworkStatusWeightsUpdated,
+	MLNeuralNetworkStatusBatchFeededForward,
+	MLNeuralNetworkStatusBatchBackPropagated
 };
 
 
@@ -73,6 +73,10 @@
                        learningRate:(MLReal)learningRate
                               delta:(MLReal)delta;
 
+- (void) backPropagateWithAlgorithm:(MLBackPropagationType)backPropType
+                       learningRate:(MLReal)learningRate
+                           gradient:(nonnull MLReal *)gradient;
+
 - (void) updateWeights;
 
 
@@ -90,9 +94,6 @@
 @property (nonatomic, readonly, nonnull) MLReal *weights;
 @property (nonatomic, readonly, nonnull) MLReal *weightsDelta;
 
-@property (nonatomic, readonly) MLReal * _Nonnull * _Nullable nextLayerWeightPtrs;
-@property (nonatomic, readonly) MLReal * _Nonnull * _Nullable nextLayerWeightDeltaPtrs;
-
 @property (nonatomic, readonly) MLReal error;
 @property (nonatomic, readonly) MLReal delta;
 
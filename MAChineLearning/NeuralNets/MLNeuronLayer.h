@@ -39,9 +39,12 @@
 #import "MLBackPropagationType.h"
 #import "MLActivationFunctionType.h"
 #import "MLCostFunctionType.h"
+#import "MLWeightsStorageType.h"
+#import "MLSoftmaxTrainingType.h"
 
 
 @class MLNeuron;
+@class MLNeuralNetworkProfile;
 
 @interface MLNeuronLayer : MLLayer
 
@@ -61,9 +64,40 @@
 
 
 #pragma mark -
-#pragma mark Randomization
+#pragma mark Setup and randomization
 
+- (void) setUpForBackpropagationWithAlgorithm:(MLBackPropagationType)backPropType;
+- (void) shareWeightsOfLayer:(nonnull MLNeuronLayer *)layer;
+- (void) useWeights:(nonnull MLReal *)weights ownedBy:(nonnull id)owner readOnly:(BOOL)readOnly;
 - (void) randomizeWeights;
+- (void) updateWeightsStorage;
+
+
+#pragma mark -
+#pragma mark Pruning
+
+- (void) pruneWithSparsity:(MLReal)sparsity;
+- (void) pruneWithThreshold:(MLReal)threshold;
+- (void) removePruning;
+
+
+#pragma mark -
+#pragma mark Factorization
+
+- (void) factorizeWithRank:(NSUInteger)rank;
+- (void) factorizeWithMaxError:(MLReal)maxError;
+- (void) removeFactorization;
+
+
+#pragma mark -
+#pragma mark Softmax training
+
+- (void) setUpSampledSoftmaxWithSamples:(NSUInteger)samples
+                            classCounts:(nullable NSArray<NSNumber *> *)counts;
+
+- (void) setUpHierarchicalSoftmaxWithClassCounts:(nonnull NSArray<NSNumber *> *)counts;
+
+- (void) removeSoftmaxApproximation;
 
 
 #pragma mark -
@@ -71,25 +105,85 @@
 
 - (void) feedForward;
 
+- (void) feedForwardSparseInputWithIndices:(nonnull const int *)indices
+                                    values:(nonnull const MLReal *)values
+                                      size:(NSUInteger)size;
+
 - (void) fetchErrorFromNextLayer;
+- (void) propagateErrorToBuffer:(nonnull MLReal *)errorBuffer;
 
 - (void) backPropagateWithAlgorithm:(MLBackPropagationType)backPropType
                        learningRate:(MLReal)learningRate
                        costFunction:(MLCostFunctionType)costType;
 
+- (MLReal) backPropagateClass:(NSUInteger)targetClass
+                 learningRate:(MLReal)learningRate;
+
 - (void) updateWeights;
 
+- (NSUInteger) selectTopClasses:(NSUInteger)k
+                        indices:(nonnull int *)indices
+                  probabilities:(nullable MLReal *)probabilities;
+
+
+#pragma mark -
+#pragma mark Batch operations
+
+- (void) feedForwardBatchOfSize:(NSUInteger)size;
+
+- (void) feedForwardBatchOfSize:(NSUInteger)size
+                    inputBuffer:(nonnull MLReal *)inputBuffer
+                   outputBuffer:(nonnull MLReal *)outputBuffer;
+
+- (void) fetchBatchErrorFromNextLayerOfSize:(NSUInteger)size;
+
+- (void) backPropagateBatchOfSize:(NSUInteger)size
+                        algorithm:(MLBackPropagationType)backPropType
+                     learningRate:(MLReal)learningRate
+                     costFunction:(MLCostFunctionType)costType;
+
 
 #pragma mark -
 #pragma mark Properties
 
 @property (nonatomic, readonly) MLActivationFunctionType funcType;
+@property (nonatomic, assign) BOOL fastApproximateActivation;
+@property (nonatomic, assign) MLReal momentum;
+@property (nonatomic, assign) MLReal decayRate;
+@property (nonatomic, assign) MLReal epsilon;
+@property (nonatomic, strong, nullable) MLNeuralNetworkProfile *profile;
+
+@property (nonatomic, readonly, nonnull) MLReal *weights;
+@property (nonatomic, readonly) BOOL weightsReadOnly;
+@property (nonatomic, assign) MLWeightsStorageType weightsStorageType;
+@property (nonatomic, readonly, nullable) uint16_t *halfWeights;
+
+@property (nonatomic, readonly) BOOL pruned;
+@property (nonatomic, readonly) MLReal sparsity;
+@property (nonatomic, readonly) NSUInteger nonzeroWeightsCount;
+
+@property (nonatomic, readonly) BOOL factorized;
+@property (nonatomic, readonly) NSUInteger factorizationRank;
+@property (nonatomic, readonly) MLReal factorizationError;
+@property (nonatomic, readonly) NSUInteger factorizedWeightsCount;
+@property (nonatomic, readonly, nullable) NSArray<NSNumber *> *singularValues;
+
+@property (nonatomic, readonly) MLSoftmaxTrainingType softmaxTrainingType;
+@property (nonatomic, readonly) NSUInteger sampledSoftmaxSamples;
+@property (nonatomic, readonly, nullable) NSArray<NSNumber *> *classCounts;
+
+@property (nonatomic, readonly, nonnull) MLReal *weightsDelta;
 
 @property (nonatomic, readonly, nonnull) MLReal *errorBuffer;
 @property (nonatomic, readonly, nonnull) MLReal *deltaBuffer;
 
 @property (nonatomic, readonly, nonnull) MLReal *outputBuffer;
 
+@property (nonatomic, readonly, nullable) MLReal *batchErrorBuffer;
+@property (nonatomic, readonly, nullable) MLReal *batchDeltaBuffer;
+
+@property (nonatomic, readonly, nullable) MLReal *batchOutputBuffer;
+
 @property (nonatomic, readonly) BOOL usingBias;
 @property (nonatomic, readonly, nonnull) NSArray<MLNeuron *> *neurons;
 
@@ -31,13 +31,25 @@
 //  POSSIBILITY OF SUCH DAMAGE.
 //
 
+
 #import "MLNeuronLayer.h"
 #import "MLInputLayer.h"
 #import "MLNeuron.h"
 #import "MLBiasNeuron.h"
 #import "MLNeuralNetworkException.h"
+#import "MLProfileCounters.h"
+#import "MLRandom.h"
 
 #import "MLAlloc.h"
+#import "MLActivationKernels.h"
+#import "MLOptimizerKernels.h"
+#import "MLHalfKernels.h"
+#import "MLSparseKernels.h"
+#import "MLLowRankKernels.h"
+#import "MLSoftmaxKernels.h"
+
+#define FACTORIZATION_BLOCK_SIZE            (4096)
+#define SAMPLING_DISTRIBUTION_POWER         (0.75)
 
 #define DUMP_VECTOR(x) \
     { \
@@ -53,33 +65,150 @@
 
 @interface MLNeuronLayer () {
     MLActivationFunctionType _funcType;
+    MLBackPropagationType _backPropType;
+    BOOL _fastApproximateActivation;
+    
+    MLNeuralNetworkProfile *_profile;
+    MLProfileState *_profileState;
+    
+    NSUInteger _inputSize;
+    MLReal *_inputBuffer;
+    
+    MLReal *_weights;
+    MLReal *_weightsDelta;
+    id _weightsOwner;
+    BOOL _weightsReadOnly;
+    
+    MLWeightsStorageType _weightsStorageType;
+    MLHalf *_halfWeights;
+    
+    MLReal *_pruningMask;
+    NSUInteger _nonzeroCount;
+    int *_prunedRowOffsets;
+    int *_prunedColumns;
+    MLReal *_prunedValues;
+    
+    NSUInteger _factorizationRank;
+    MLReal _factorizationError;
+    MLReal *_factorU;
+    MLReal *_factorV;
+    NSArray<NSNumber *> *_singularValues;
+    
+    MLSoftmaxTrainingType _softmaxTrainingType;
+    NSUInteger _sampledSoftmaxSamples;
+    NSArray<NSNumber *> *_classCounts;
+    MLReal *_aliasProbabilities;
+    int *_aliases;
+    MLReal *_samplingCorrections;
+    int *_candidateRowFlags;
+    int *_treeChildren;
+    int *_treePathOffsets;
+    int *_treePathNodes;
+    int *_treePathCodes;
+    MLReal *_treeNodeBuffer;
+    MLReal *_topValues;
+    int *_topNodes;
+    
+    NSUInteger _activeRowCount;
+    int *_activeRows;
+    MLReal *_activeDeltas;
 
     MLReal *_outputBuffer;
     
     MLReal *_deltaBuffer;
     MLReal *_errorBuffer;
     
-    MLReal *_nextLayerWeightsBuffer;
-    MLReal *_nextLayerWeightsDeltaBuffer;
+    MLReal *_batchOutputBuffer;
+    
+    MLReal *_batchDeltaBuffer;
+    MLReal *_batchErrorBuffer;
+    
+    MLReal *_batchGradientBuffer;
+    
+    MLReal _learningRate;
+    MLReal _momentum;
+    MLReal _decayRate;
+    MLReal _epsilon;
+    NSUInteger _optimizerSteps;
+    MLReal *_optimizerState;
+    MLReal *_optimizerSecondState;
+    
+    MLReal *_weightSteps;
+    MLReal *_previousGradient;
+    MLReal *_previousWeightsChange;
+    
+    BOOL _sparseInput;
+    NSUInteger _sparseInputSize;
+    int *_sparseInputIndices;
+    MLReal *_sparseInputValues;
+    
+    BOOL _weightsDeltaPending;
+    BOOL _weightsDeltaSparse;
+    NSUInteger _touchedColumnCount;
+    int *_touchedColumns;
+    int *_touchedColumnFlags;
+    
+    BOOL _weightsDeltaRowSparse;
+    NSUInteger _touchedRowCount;
+    int *_touchedRows;
+    int *_touchedRowFlags;
 
     BOOL _usingBias;
     NSMutableArray<MLNeuron *> *_neurons;
 }
 
 
+#pragma mark -
+#pragma mark Internals
+
+- (void) applyActivationFunctionToBuffer:(MLReal *)buffer size:(NSUInteger)size;
+
+- (void) computeDeltaBuffer:(MLReal *)deltaBuffer
+            fromErrorBuffer:(MLReal *)errorBuffer
+               outputBuffer:(MLReal *)outputBuffer
+                       size:(NSUInteger)size
+               costFunction:(MLCostFunctionType)costType;
+
+- (MLReal *) previousLayerBatchOutputBuffer;
+
+- (void) applyOptimizer;
+
+- (void) freePrunedMatrix;
+- (void) updatePrunedMatrix;
+
+- (void) factorizeWithRank:(NSUInteger)rank maxError:(MLReal)maxError;
+
+- (void) checkSoftmaxApproximationWithClassCounts:(NSArray<NSNumber *> *)counts;
+- (void) setUpActiveRowsWithCapacity:(NSUInteger)capacity;
+
+
 @end
 
 
 #pragma mark -
 #pragma mark Static constants
 
-static const MLReal __minusFourty= -40.0;
-static const MLReal __minusTwo=     -2.0;
-static const MLReal __minusOne=     -1.0;
-static const MLReal __zero=          0.0;
-static const MLReal __half=          0.5;
-static const MLReal __one=           1.0;
-static const MLReal __fourty=       40.0;
+static const MLReal __zero=               0.0;
+static const MLReal __one=                1.0;
+
+static const MLReal __stepInitialValue=   0.1;
+
+
+#pragma mark -
+#pragma mark Static functions
+
+static inline BOOL MLBackPropagationTypeIsAdaptive(MLBackPropagationType backPropType) {
+    switch (backPropType) {
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+        case MLBackPropagationTypeRMSProp:
+        case MLBackPropagationTypeAdam:
+            return YES;
+            
+        default:
+            return NO;
+    }
+}
 
 
 #pragma mark -
@@ -109,6 +238,37 @@ static const MLReal __fourty=       40.0;
 
 - (void) dealloc {
     
+    // Deallocate weight matrices, unless shared
+    if (!_weightsOwner)
+        MLFreeRealBuffer(_weights);
+    
+    _weights= NULL;
+    _weightsOwner= nil;
+    
+    MLFreeRealBuffer(_weightsDelta);
+    _weightsDelta= NULL;
+    
+    MLFreeUInt16Buffer(_halfWeights);
+    _halfWeights= NULL;
+    
+    // Deallocate pruning mask and sparse matrix
+    MLFreeRealBuffer(_pruningMask);
+    _pruningMask= NULL;
+    
+    [self freePrunedMatrix];
+    
+    // Deallocate factors
+    [self removeFactorization];
+    
+    // Deallocate softmax approximation tables
+    [self removeSoftmaxApproximation];
+    
+    MLFreeRealBuffer(_topValues);
+    _topValues= NULL;
+    
+    MLFreeIntBuffer(_topNodes);
+    _topNodes= NULL;
+    
     // Deallocate buffers
     MLFreeRealBuffer(_outputBuffer);
     _outputBuffer= NULL;
@@ -118,12 +278,48 @@ static const MLReal __fourty=       40.0;
 
     MLFreeRealBuffer(_errorBuffer);
     _errorBuffer= NULL;
-
-    MLFreeRealBuffer(_nextLayerWeightsBuffer);
-    _nextLayerWeightsBuffer= NULL;
-
-    MLFreeRealBuffer(_nextLayerWeightsDeltaBuffer);
-    _nextLayerWeightsDeltaBuffer= NULL;
+    
+    // Deallocate batch buffers
+    MLFreeRealBuffer(_batchOutputBuffer);
+    _batchOutputBuffer= NULL;
+    
+    MLFreeRealBuffer(_batchDeltaBuffer);
+    _batchDeltaBuffer= NULL;
+    
+    MLFreeRealBuffer(_batchErrorBuffer);
+    _batchErrorBuffer= NULL;
+    
+    MLFreeRealBuffer(_batchGradientBuffer);
+    _batchGradientBuffer= NULL;
+    
+    // Deallocate optimizer state
+    MLFreeRealBuffer(_optimizerState);
+    _optimizerState= NULL;
+    
+    MLFreeRealBuffer(_optimizerSecondState);
+    _optimizerSecondState= NULL;
+    
+    MLFreeRealBuffer(_weightSteps);
+    _weightSteps= NULL;
+    
+    MLFreeRealBuffer(_previousGradient);
+    _previousGradient= NULL;
+    
+    MLFreeRealBuffer(_previousWeightsChange);
+    _previousWeightsChange= NULL;
+    
+    // Deallocate sparse input buffers
+    MLFreeIntBuffer(_sparseInputIndices);
+    _sparseInputIndices= NULL;
+    
+    MLFreeRealBuffer(_sparseInputValues);
+    _sparseInputValues= NULL;
+    
+    MLFreeIntBuffer(_touchedColumns);
+    _touchedColumns= NULL;
+    
+    MLFreeIntBuffer(_touchedColumnFlags);
+    _touchedColumnFlags= NULL;
 }
 
 
@@ -135,6 +331,27 @@ static const MLReal __fourty=       40.0;
         @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer already set up"
                                                                  userInfo:@{@"layer": @(self.index)}];
     
+    if ([self.previousLayer isKindOfClass:[MLInputLayer class]]) {
+        _inputBuffer= ((MLInputLayer *) self.previousLayer).inputBuffer;
+        
+    } else if ([self.previousLayer isKindOfClass:[MLNeuronLayer class]]) {
+        _inputBuffer= ((MLNeuronLayer *) self.previousLayer).outputBuffer;
+        
+    } else
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Unknown type of layer found as previous layer"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"previousLayer": @(self.previousLayer.index)}];
+    
+    _inputSize= self.previousLayer.size;
+    
+    // Allocate the weight matrices: one row per neuron,
+    // rows of bias neurons are left to 0
+    _weights= MLAllocRealBuffer(self.size * _inputSize);
+    _weightsDelta= MLAllocRealBuffer(self.size * _inputSize);
+    
+    ML_VCLR(_weights, 1, self.size * _inputSize);
+    ML_VCLR(_weightsDelta, 1, self.size * _inputSize);
+    
     // Allocate buffers
     _outputBuffer= MLAllocRealBuffer(self.size);
     _deltaBuffer= MLAllocRealBuffer(self.size);
@@ -144,23 +361,31 @@ static const MLReal __fourty=       40.0;
     ML_VCLR(_outputBuffer, 1, self.size);
     ML_VCLR(_deltaBuffer, 1, self.size);
     ML_VCLR(_errorBuffer, 1, self.size);
+    
+    if (_funcType == MLActivationFunctionTypeSoftmax) {
+        
+        // Workspace for the selection of top classes
+        _topValues= MLAllocRealBuffer(self.size);
+        _topNodes= MLAllocIntBuffer(self.size);
+    }
+    
+    if ([self.previousLayer isKindOfClass:[MLInputLayer class]]) {
+        
+        // The first layer may be fed with sparse input: keep a copy
+        // of it, and track weight columns touched by its updates
+        _sparseInputIndices= MLAllocIntBuffer(_inputSize);
+        _sparseInputValues= MLAllocRealBuffer(_inputSize);
+        
+        _touchedColumns= MLAllocIntBuffer(_inputSize);
+        _touchedColumnFlags= MLAllocIntBuffer(_inputSize);
+        
+        memset(_touchedColumnFlags, 0, _inputSize * sizeof(int));
+    }
 
+    // Neurons are views on the layer buffers and weight matrices
     _neurons= [[NSMutableArray alloc] initWithCapacity:self.size];
     
     for (int i= 0; i < self.size; i++) {
-        MLReal *inputBuffer= NULL;
-
-        if ([self.previousLayer isKindOfClass:[MLInputLayer class]]) {
-            inputBuffer= ((MLInputLayer *) self.previousLayer).inputBuffer;
-
-        } else if ([self.previousLayer isKindOfClass:[MLNeuronLayer class]]) {
-            inputBuffer= ((MLNeuronLayer *) self.previousLayer).outputBuffer;
-        
-        } else
-            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Unknown type of layer found as previous layer"
-                                                                     userInfo:@{@"layer": @(self.index),
-                                                                                @"previousLayer": @(self.previousLayer.index)}];
-
         MLNeuron *neuron= nil;
         if (_usingBias && (i == (self.size -1))) {
             
@@ -168,8 +393,8 @@ static const MLReal __fourty=       40.0;
             neuron= [[MLBiasNeuron alloc] initWithLayer:self
                                                   index:i
                                            outputBuffer:self.outputBuffer
-                                              inputSize:self.previousLayer.size
-                                            inputBuffer:inputBuffer];
+                                              inputSize:_inputSize
+                                            inputBuffer:_inputBuffer];
             
         } else {
             
@@ -177,257 +402,1753 @@ static const MLReal __fourty=       40.0;
             neuron= [[MLNeuron alloc] initWithLayer:self
                                               index:i
                                        outputBuffer:self.outputBuffer
-                                          inputSize:self.previousLayer.size
-                                        inputBuffer:inputBuffer];
+                                          inputSize:_inputSize
+                                        inputBuffer:_inputBuffer];
         }
         
         [_neurons addObject:neuron];
     }
-
-    if (self.nextLayer) {
-        
-        // Prepare buffer for weights of next layer
-        MLNeuronLayer *nextLayer= (MLNeuronLayer *) self.nextLayer;
-        
-        _nextLayerWeightsBuffer= MLAllocRealBuffer(nextLayer.size);
-        _nextLayerWeightsDeltaBuffer= MLAllocRealBuffer(nextLayer.size);
-        
-        ML_VCLR(_nextLayerWeightsBuffer, 1, nextLayer.size);
-        ML_VCLR(_nextLayerWeightsDeltaBuffer, 1, nextLayer.size);
-    }
 }
 
-- (void) randomizeWeights {
+- (void) setUpBatchOfSize:(NSUInteger)batchSize {
     if (!_neurons)
         @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
                                                                  userInfo:@{@"layer": @(self.index)}];
-
-    // Compute beta for Nguyen-Widrow randomization
-    MLReal beta= 0.7 * ML_POW(((MLReal) self.size), 1.0 / ((MLReal) self.previousLayer.size));
-
-    // Randomize each neuron
-    for (MLNeuron *neuron in _neurons)
-        [neuron randomizeWeightsWithBeta:beta];
+    
+    [super setUpBatchOfSize:batchSize];
+    
+    // Release previous batch buffers, if any
+    MLFreeRealBuffer(_batchOutputBuffer);
+    MLFreeRealBuffer(_batchDeltaBuffer);
+    MLFreeRealBuffer(_batchErrorBuffer);
+    MLFreeRealBuffer(_batchGradientBuffer);
+    _batchGradientBuffer= NULL;
+    
+    // Allocate batch buffers: outputs, errors and deltas have one row per sample
+    _batchOutputBuffer= MLAllocRealBuffer(batchSize * self.size);
+    _batchDeltaBuffer= MLAllocRealBuffer(batchSize * self.size);
+    _batchErrorBuffer= MLAllocRealBuffer(batchSize * self.size);
+    
+    ML_VCLR(_batchOutputBuffer, 1, batchSize * self.size);
+    ML_VCLR(_batchDeltaBuffer, 1, batchSize * self.size);
+    ML_VCLR(_batchErrorBuffer, 1, batchSize * self.size);
+    
+    switch (_backPropType) {
+        case MLBackPropagationTypeResilient:
+        case MLBackPropagationTypeImprovedResilient:
+            
+            // RPROP needs the full gradient of the batch, one row per neuron
+            _batchGradientBuffer= MLAllocRealBuffer(self.size * _inputSize);
+            
+            ML_VCLR(_batchGradientBuffer, 1, self.size * _inputSize);
+            break;
+            
+        default:
+            break;
+    }
 }
 
-
-#pragma mark -
-#pragma mark Operations
-
-- (void) feedForward {
+- (void) setUpForBackpropagationWithAlgorithm:(MLBackPropagationType)backPropType {
     if (!_neurons)
         @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
                                                                  userInfo:@{@"layer": @(self.index)}];
     
-    // Reset error and delta
-    ML_VCLR(_deltaBuffer, 1, _size);
-    ML_VCLR(_errorBuffer, 1, _size);
-
-    // First step: compute dot product for each neuron,
-    // will fill the output buffer
-    for (MLNeuron *neuron in _neurons)
-        [neuron feedForward];
+    if ((_softmaxTrainingType != MLSoftmaxTrainingTypeFull) && (backPropType != MLBackPropagationTypeStandard))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Softmax approximations are supported only with standard backpropagation"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"backPropagationType": @(backPropType)}];
     
-    // Second step: apply activation function
-    switch (_funcType) {
-        case MLActivationFunctionTypeLinear: {
+    _backPropType= backPropType;
+    
+    // Release optimizer state of a previous setup, if any
+    MLFreeRealBuffer(_optimizerState);
+    _optimizerState= NULL;
+    
+    MLFreeRealBuffer(_optimizerSecondState);
+    _optimizerSecondState= NULL;
+    
+    MLFreeRealBuffer(_weightSteps);
+    _weightSteps= NULL;
+    
+    MLFreeRealBuffer(_previousGradient);
+    _previousGradient= NULL;
+    
+    MLFreeRealBuffer(_previousWeightsChange);
+    _previousWeightsChange= NULL;
+    
+    _optimizerSteps= 0;
+    
+    switch (backPropType) {
+        case MLBackPropagationTypeResilient:
             
-            // Apply formula: output[i] = output[i]
-            break;
-        }
+            // Previous weights change is needed for backtracking only
+            _previousWeightsChange= MLAllocRealBuffer(_size * _inputSize);
             
-        case MLActivationFunctionTypeRectifiedLinear: {
+            ML_VCLR(_previousWeightsChange, 1, _size * _inputSize);
             
-            // Apply formula: output[i] = (output[i] < 0.0 ? 0.0 : output[i])
-            ML_VTHRES(_outputBuffer, 1, &__zero, _outputBuffer, 1, _size);
-            break;
-        }
-
-        case MLActivationFunctionTypeStep: {
-            MLReal *tempBuffer= MLAllocRealBuffer(self.size);
-
-            // Apply formula: output[i] = (output[i] < 0.5 ? 0.0 : 1.0)
-            ML_VTHRSC(_outputBuffer, 1, &__half, &__one, tempBuffer, 1, _size);
-            ML_VTHRES(tempBuffer, 1, &__zero, _outputBuffer, 1, _size);
+            // Fall through
             
-            MLFreeRealBuffer(tempBuffer);
-            break;
-        }
+        case MLBackPropagationTypeImprovedResilient:
             
-        case MLActivationFunctionTypeSigmoid: {
-            MLReal *tempBuffer= MLAllocRealBuffer(self.size);
+            // Weight steps and previous gradient, one per weight
+            _weightSteps= MLAllocRealBuffer(_size * _inputSize);
+            _previousGradient= MLAllocRealBuffer(_size * _inputSize);
             
-            // Apply clipping before the function to avoid NaNs
-            ML_VCLIP(_outputBuffer, 1, &__minusFourty, &__fourty, _outputBuffer, 1, _size);
+            ML_VFILL(&__stepInitialValue, _weightSteps, 1, _size * _inputSize);
+            ML_VCLR(_previousGradient, 1, _size * _inputSize);
+            break;
             
-            // An "int" size is needed by vvexp,
-            // the others still use _size
-            int size= (int) _size;
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+        case MLBackPropagationTypeRMSProp:
             
-            // Apply formula: output[i] = 1 / (1 + exp(-output[i])
-            ML_VSMUL(_outputBuffer, 1, &__minusOne, tempBuffer, 1, _size);
-            ML_VVEXP(tempBuffer, tempBuffer, &size);
-            ML_VSADD(tempBuffer, 1, &__one, tempBuffer, 1, _size);
-            ML_SVDIV(&__one, tempBuffer, 1, _outputBuffer, 1, _size);
+            // Velocity or mean square, one per weight
+            _optimizerState= MLAllocRealBuffer(_size * _inputSize);
             
-            MLFreeRealBuffer(tempBuffer);
+            ML_VCLR(_optimizerState, 1, _size * _inputSize);
             break;
-        }
             
-        case MLActivationFunctionTypeTanH: {
-            MLReal *tempBuffer= MLAllocRealBuffer(self.size);
+        case MLBackPropagationTypeAdam:
             
-            // Apply clipping before the function to avoid NaNs
-            ML_VCLIP(_outputBuffer, 1, &__minusFourty, &__fourty, _outputBuffer, 1, _size);
-
-            // An "int" size is needed by vvexp,
-            // the others still use _size
-            int size= (int) _size;
-
-            // Apply formula: output[i] = (1 - exp(-2 * output[i])) / (1 + exp(-2 * output[i]))
-            // Equivalent to: output[i] = tanh(output[i])
-            ML_VSMUL(_outputBuffer, 1, &__minusTwo, tempBuffer, 1, _size);
-            ML_VVEXP(tempBuffer, tempBuffer, &size);
-            ML_VSADD(tempBuffer, 1, &__one, _outputBuffer, 1, _size);
-            ML_VSMUL(tempBuffer, 1, &__minusOne, tempBuffer, 1, _size);
-            ML_VSADD(tempBuffer, 1, &__one, tempBuffer, 1, _size);
-            ML_VDIV(_outputBuffer, 1, tempBuffer, 1, _outputBuffer, 1, _size);
+            // First and second moment, one per weight
+            _optimizerState= MLAllocRealBuffer(_size * _inputSize);
+            _optimizerSecondState= MLAllocRealBuffer(_size * _inputSize);
             
-            MLFreeRealBuffer(tempBuffer);
+            ML_VCLR(_optimizerState, 1, _size * _inputSize);
+            ML_VCLR(_optimizerSecondState, 1, _size * _inputSize);
+            break;
+            
+        default:
             break;
-        }
     }
+    
+    // Default hyperparameters
+    _momentum= 0.9;
+    _decayRate= (backPropType == MLBackPropagationTypeAdam) ? 0.999 : 0.9;
+    _epsilon= 1e-8;
+    
+    for (MLNeuron *neuron in _neurons)
+        [neuron setUpForBackpropagationWithAlgorithm:backPropType];
 }
 
-- (void) fetchErrorFromNextLayer {
+- (void) shareWeightsOfLayer:(MLNeuronLayer *)layer {
     if (!_neurons)
         @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
                                                                  userInfo:@{@"layer": @(self.index)}];
     
-    MLNeuronLayer *nextLayer= (MLNeuronLayer *) self.nextLayer;
+    if ((layer.size != _size) || (layer.previousLayer.size != _inputSize))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't share weights of a layer with different size"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"otherLayer": @(layer.index)}];
     
-    for (MLNeuron *neuron in _neurons) {
-        if ([neuron isKindOfClass:[MLBiasNeuron class]]) {
-            
-            // Bias neurons have constant output and don't backpropagate
-            _errorBuffer[neuron.index]= __zero;
-            
-        } else {
-            if ((!neuron.nextLayerWeightPtrs) || (!neuron.nextLayerWeightDeltaPtrs))
-                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron not yet set up"
-                                                                         userInfo:@{@"layer": @(self.index),
-                                                                                    @"neuron": @(neuron.index)}];
-            
-            // Gather next layer weights using vector gathering
-            ML_VGATHRA((const MLReal **) neuron.nextLayerWeightPtrs, 1, _nextLayerWeightsBuffer, 1, nextLayer.size);
-            ML_VGATHRA((const MLReal **) neuron.nextLayerWeightDeltaPtrs, 1, _nextLayerWeightsDeltaBuffer, 1, nextLayer.size);
-            
-            // Sum the delta
-            ML_VADD(_nextLayerWeightsBuffer, 1, _nextLayerWeightsDeltaBuffer, 1, _nextLayerWeightsBuffer, 1, nextLayer.size);
-            
-            // Compute the dot product
-            ML_DOTPR(nextLayer.deltaBuffer, 1, _nextLayerWeightsBuffer, 1, &_errorBuffer[neuron.index], nextLayer.size);
-        }
-    }
+    if ((layer->_weightsStorageType != MLWeightsStorageTypeReal) || (_weightsStorageType != MLWeightsStorageTypeReal))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't share weights stored in half precision"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"otherLayer": @(layer.index)}];
+    
+    if (layer->_pruningMask || _pruningMask)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't share weights of a pruned layer"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"otherLayer": @(layer.index)}];
+    
+    if (layer->_factorU || _factorU)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't share weights of a factorized layer"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"otherLayer": @(layer.index)}];
+    
+    // Weights delta stays ours
+    [self useWeights:layer->_weights
+             ownedBy:(layer->_weightsOwner ? layer->_weightsOwner : layer)
+            readOnly:layer->_weightsReadOnly];
 }
 
-- (void) backPropagateWithAlgorithm:(MLBackPropagationType)backPropType learningRate:(MLReal)learningRate costFunction:(MLCostFunctionType)costType {
+- (void) useWeights:(MLReal *)weights ownedBy:(id)owner readOnly:(BOOL)readOnly {
     if (!_neurons)
         @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
                                                                  userInfo:@{@"layer": @(self.index)}];
     
-    // First step: compute the delta with
-    // activation function derivative
-    switch (_funcType) {
-        case MLActivationFunctionTypeLinear: {
-            
-            // Apply formula: delta[i] = error[i]
-            ML_VSMUL(_errorBuffer, 1, &__one, _deltaBuffer, 1, _size);
-            break;
-        }
-            
-        case MLActivationFunctionTypeRectifiedLinear: {
-            
-            // Apply formula: delta[i] = (error[i] < 0.0 ? 0.0 : error[i])
-            ML_VSMUL(_errorBuffer, 1, &__one, _deltaBuffer, 1, _size);
-            ML_VTHRES(_errorBuffer, 1, &__zero, _errorBuffer, 1, _size);
-            break;
-        }
-
-        case MLActivationFunctionTypeStep: {
-            if (self.nextLayer)
-                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't backpropagate in a hidden layer with step function"
-                                                                         userInfo:@{@"layer": @(self.index)}];
-            
-            // Apply formula: delta[i] = error[i]
-            ML_VSMUL(_errorBuffer, 1, &__one, _deltaBuffer, 1, _size);
-            break;
-        }
-            
-        case MLActivationFunctionTypeSigmoid: {
-            switch (costType) {
-                case MLCostFunctionTypeCrossEntropy: {
-                    
-                    // Apply formula: delta[i] = error[i]
-                    ML_VSMUL(_errorBuffer, 1, &__one, _deltaBuffer, 1, _size);
-                    break;
-                }
-                    
-                case MLCostFunctionTypeSquaredError: {
-                    MLReal *tempBuffer= MLAllocRealBuffer(self.size);
-            
-                    // Apply formula: delta[i] = output[i] * (1 - output[i]) * error[i]
-                    ML_VSMUL(_outputBuffer, 1, &__minusOne, tempBuffer, 1, _size);
-                    ML_VSADD(tempBuffer, 1, &__one, tempBuffer, 1, _size);
-                    ML_VMUL(tempBuffer, 1, _outputBuffer, 1, tempBuffer, 1, _size);
-                    ML_VMUL(tempBuffer, 1, _errorBuffer, 1, _deltaBuffer, 1, _size);
-                    
-                    MLFreeRealBuffer(tempBuffer);
-                    break;
-                }
-            }
-            break;
-        }
-            
-        case MLActivationFunctionTypeTanH: {
-            MLReal *tempBuffer= MLAllocRealBuffer(self.size);
-            
-            // Apply formula: delta[i] = (1 - (output[i] * output[i])) * error[i]
-            ML_VSQ(_outputBuffer, 1, tempBuffer, 1, _size);
-            ML_VSMUL(tempBuffer, 1, &__minusOne, tempBuffer, 1, _size);
-            ML_VSADD(tempBuffer, 1, &__one, tempBuffer, 1, _size);
-            ML_VMUL(tempBuffer, 1, _errorBuffer, 1, _deltaBuffer, 1, _size);
-            
-            MLFreeRealBuffer(tempBuffer);
-            break;
-        }
-    }
+    // Release our own weights, if any
+    if (!_weightsOwner)
+        MLFreeRealBuffer(_weights);
     
-    // Second step: compute new weights for each neuron
-    for (MLNeuron *neuron in _neurons)
-        [neuron backPropagateWithAlgorithm:backPropType learningRate:learningRate delta:_deltaBuffer[neuron.index]];
+    // From now on we use the external weights, the owner is
+    // kept alive for as long as we use its buffer
+    _weightsOwner= owner;
+    _weights= weights;
+    _weightsReadOnly= readOnly;
 }
 
-- (void) updateWeights {
+- (void) randomizeWeights {
     if (!_neurons)
         @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
                                                                  userInfo:@{@"layer": @(self.index)}];
     
-    // Second step: update weights for each neuron
+    if (_weightsReadOnly)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't randomize read-only weights"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+
+    // New weights are neither pruned nor factorized
+    [self removePruning];
+    [self removeFactorization];
+    
+    // Compute beta for Nguyen-Widrow randomization
+    MLReal beta= 0.7 * ML_POW(((MLReal) self.size), 1.0 / ((MLReal) self.previousLayer.size));
+
+    // Randomize each neuron
     for (MLNeuron *neuron in _neurons)
-        [neuron updateWeights];
+        [neuron randomizeWeightsWithBeta:beta];
+    
+    [self updateWeightsStorage];
 }
 
+- (void) updateWeightsStorage {
+    if (!_halfWeights)
+        return;
+    
+    // Convert the whole matrix, bias row included
+    MLConvertRealToHalf(_weightsStorageType, _weights, 1, _halfWeights, 1, _size * _inputSize);
+}
 
-#pragma mark -
-#pragma mark Properties
 
-@synthesize funcType= _funcType;
+#pragma mark -
+#pragma mark Pruning
 
-@synthesize errorBuffer= _errorBuffer;
-@synthesize deltaBuffer= _deltaBuffer;
+- (void) pruneWithSparsity:(MLReal)sparsity {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if ((sparsity < 0.0) || (sparsity >= 1.0))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid sparsity: must be at least 0 and less than 1"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"sparsity": @(sparsity)}];
+    
+    // Bias neurons are not pruned, their row is excluded
+    NSUInteger rows= _usingBias ? (_size -1) : _size;
+    NSUInteger weightsCount= rows * _inputSize;
+    
+    // Find the magnitude threshold of the requested sparsity
+    MLReal *magnitudes= MLAllocRealBuffer(weightsCount);
+    ML_VABS(_weights, 1, magnitudes, 1, weightsCount);
+    
+    MLReal threshold= MLMagnitudeThreshold(magnitudes, weightsCount, (NSUInteger) (sparsity * weightsCount));
+    
+    MLFreeRealBuffer(magnitudes);
+    
+    [self pruneWithThreshold:threshold];
+}
 
-@synthesize outputBuffer= _outputBuffer;
+- (void) pruneWithThreshold:(MLReal)threshold {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_weightsReadOnly)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't prune read-only weights"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_weightsOwner)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't prune shared weights"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_factorU)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't prune a factorized layer"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Bias neurons are not pruned, their row is excluded
+    NSUInteger rows= _usingBias ? (_size -1) : _size;
+    
+    if (!_pruningMask)
+        _pruningMask= MLAllocRealBuffer(_size * _inputSize);
+    
+    [self freePrunedMatrix];
+    
+    // The mask has 1 where the weight is kept, 0 where it is pruned;
+    // previously pruned weights are zero and remain pruned
+    _nonzeroCount= 0;
+    for (NSUInteger i= 0; i < rows * _inputSize; i++) {
+        MLReal magnitude= ML_ABS(_weights[i]);
+        BOOL kept= (magnitude >= threshold) && (magnitude > __zero);
+        
+        _pruningMask[i]= kept ? __one : __zero;
+        _nonzeroCount += kept ? 1 : 0;
+    }
+    
+    ML_VFILL(&__one, &_pruningMask[rows * _inputSize], 1, (_size - rows) * _inputSize);
+    
+    // Apply the mask
+    ML_VMUL(_weights, 1, _pruningMask, 1, _weights, 1, _size * _inputSize);
+    
+    // Apply the mask to the optimizer state too: with a zero state
+    // and a zero gradient, adaptive optimizers leave pruned weights
+    // exactly zero, otherwise momentum would move them away from it
+    if (_optimizerState)
+        ML_VMUL(_optimizerState, 1, _pruningMask, 1, _optimizerState, 1, _size * _inputSize);
+    
+    if (_optimizerSecondState)
+        ML_VMUL(_optimizerSecondState, 1, _pruningMask, 1, _optimizerSecondState, 1, _size * _inputSize);
+    
+    // Build the sparse matrix in CSR format: row offsets, columns and values
+    _prunedRowOffsets= MLAllocIntBuffer(rows +1);
+    _prunedColumns= MLAllocIntBuffer(MAX(_nonzeroCount, 1));
+    _prunedValues= MLAllocRealBuffer(MAX(_nonzeroCount, 1));
+    
+    int k= 0;
+    for (NSUInteger i= 0; i < rows; i++) {
+        _prunedRowOffsets[i]= k;
+        
+        for (NSUInteger j= 0; j < _inputSize; j++) {
+            if (_pruningMask[i * _inputSize + j] != __zero)
+                _prunedColumns[k++]= (int) j;
+        }
+    }
+    
+    _prunedRowOffsets[rows]= k;
+    
+    [self updatePrunedMatrix];
+    [self updateWeightsStorage];
+}
+
+- (void) removePruning {
+    
+    // Weights stay as they are, but may be trained again
+    MLFreeRealBuffer(_pruningMask);
+    _pruningMask= NULL;
+    
+    [self freePrunedMatrix];
+}
+
+
+#pragma mark -
+#pragma mark Factorization
+
+- (void) factorizeWithRank:(NSUInteger)rank {
+    if (rank == 0)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid rank: must be at least 1"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"rank": @(rank)}];
+    
+    [self factorizeWithRank:rank maxError:__zero];
+}
+
+- (void) factorizeWithMaxError:(MLReal)maxError {
+    if ((maxError < 0.0) || (maxError >= 1.0))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid maximum error: must be at least 0 and less than 1"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"maxError": @(maxError)}];
+    
+    [self factorizeWithRank:0 maxError:maxError];
+}
+
+- (void) removeFactorization {
+    
+    // Weights stay the product of the factors, but may be trained again
+    MLFreeRealBuffer(_factorU);
+    _factorU= NULL;
+    
+    MLFreeRealBuffer(_factorV);
+    _factorV= NULL;
+    
+    _factorizationRank= 0;
+    _factorizationError= __zero;
+    _singularValues= nil;
+}
+
+
+#pragma mark -
+#pragma mark Softmax training
+
+- (void) setUpSampledSoftmaxWithSamples:(NSUInteger)samples classCounts:(NSArray<NSNumber *> *)counts {
+    [self checkSoftmaxApproximationWithClassCounts:counts];
+    
+    if ((samples == 0) || (samples >= _size))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid samples: must be at least 1 and less than the layer size"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"samples": @(samples)}];
+    
+    [self removeSoftmaxApproximation];
+    
+    // Negative classes are drawn with probability proportional to
+    // their count raised to 3/4, as in word2vec, or uniformly
+    MLReal *weights= MLAllocRealBuffer(_size);
+    int *workspace= MLAllocIntBuffer(2 * _size);
+    
+    MLReal sum= __zero;
+    for (NSUInteger i= 0; i < _size; i++) {
+        weights[i]= counts ? ML_POW(counts[i].doubleValue, SAMPLING_DISTRIBUTION_POWER) : __one;
+        sum += weights[i];
+    }
+    
+    _aliasProbabilities= MLAllocRealBuffer(_size);
+    _aliases= MLAllocIntBuffer(_size);
+    
+    MLBuildAliasTable(weights, _size, _aliasProbabilities, _aliases, workspace);
+    
+    // Logits of candidates are corrected by the log of their probability
+    // of being drawn at least once, as repeated draws are merged, so
+    // that the softmax over the candidates estimates the full one
+    _samplingCorrections= MLAllocRealBuffer(_size);
+    
+    for (NSUInteger i= 0; i < _size; i++) {
+        double probability= ((double) weights[i]) / ((double) sum);
+        
+        // Apply formula: correction = ln(1 - (1 - p)^samples), computed
+        // with expm1 and log1p to keep precision for rare classes
+        _samplingCorrections[i]= (MLReal) log(-expm1(((double) samples) * log1p(-probability)));
+    }
+    
+    MLFreeIntBuffer(workspace);
+    MLFreeRealBuffer(weights);
+    
+    // Candidates are the target and the distinct samples
+    [self setUpActiveRowsWithCapacity:samples +1];
+    
+    _candidateRowFlags= MLAllocIntBuffer(_size);
+    memset(_candidateRowFlags, 0, _size * sizeof(int));
+    
+    _softmaxTrainingType= MLSoftmaxTrainingTypeSampled;
+    _sampledSoftmaxSamples= samples;
+    _classCounts= [counts copy];
+}
+
+- (void) setUpHierarchicalSoftmaxWithClassCounts:(NSArray<NSNumber *> *)counts {
+    if (!counts)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Hierarchical softmax requires the class counts"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    [self checkSoftmaxApproximationWithClassCounts:counts];
+    
+    if (_size < 2)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Hierarchical softmax requires at least 2 classes"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    [self removeSoftmaxApproximation];
+    
+    // Build the Huffman tree of the classes: frequent classes get shorter
+    // paths, inner nodes use the first size -1 rows of the weights
+    MLReal *classCounts= MLAllocRealBuffer(_size);
+    for (NSUInteger i= 0; i < _size; i++)
+        classCounts[i]= counts[i].doubleValue;
+    
+    int *parents= MLAllocIntBuffer(2 * _size -1);
+    
+    _treeChildren= MLAllocIntBuffer(2 * (_size -1));
+    
+    NSUInteger pathsLength= MLBuildHuffmanTree(classCounts, _size, _treeChildren, parents);
+    
+    _treePathOffsets= MLAllocIntBuffer(_size +1);
+    _treePathNodes= MLAllocIntBuffer(pathsLength);
+    _treePathCodes= MLAllocIntBuffer(pathsLength);
+    
+    MLBuildHuffmanPaths(parents, _size, _treePathOffsets, _treePathNodes, _treePathCodes);
+    
+    MLFreeIntBuffer(parents);
+    MLFreeRealBuffer(classCounts);
+    
+    // Feed forward needs the outputs and the probabilities of inner nodes
+    _treeNodeBuffer= MLAllocRealBuffer(2 * (_size -1));
+    
+    // Candidates are the nodes of the longest path
+    NSUInteger maxDepth= 0;
+    for (NSUInteger i= 0; i < _size; i++)
+        maxDepth= MAX(maxDepth, (NSUInteger) (_treePathOffsets[i +1] - _treePathOffsets[i]));
+    
+    [self setUpActiveRowsWithCapacity:maxDepth];
+    
+    _softmaxTrainingType= MLSoftmaxTrainingTypeHierarchical;
+    _classCounts= [counts copy];
+}
+
+- (void) removeSoftmaxApproximation {
+    MLFreeRealBuffer(_aliasProbabilities);
+    _aliasProbabilities= NULL;
+    
+    MLFreeIntBuffer(_aliases);
+    _aliases= NULL;
+    
+    MLFreeRealBuffer(_samplingCorrections);
+    _samplingCorrections= NULL;
+    
+    MLFreeIntBuffer(_candidateRowFlags);
+    _candidateRowFlags= NULL;
+    
+    MLFreeIntBuffer(_treeChildren);
+    _treeChildren= NULL;
+    
+    MLFreeIntBuffer(_treePathOffsets);
+    _treePathOffsets= NULL;
+    
+    MLFreeIntBuffer(_treePathNodes);
+    _treePathNodes= NULL;
+    
+    MLFreeIntBuffer(_treePathCodes);
+    _treePathCodes= NULL;
+    
+    MLFreeRealBuffer(_treeNodeBuffer);
+    _treeNodeBuffer= NULL;
+    
+    MLFreeIntBuffer(_activeRows);
+    _activeRows= NULL;
+    
+    MLFreeRealBuffer(_activeDeltas);
+    _activeDeltas= NULL;
+    
+    MLFreeIntBuffer(_touchedRows);
+    _touchedRows= NULL;
+    
+    MLFreeIntBuffer(_touchedRowFlags);
+    _touchedRowFlags= NULL;
+    
+    // A pending weights delta, if any, is then applied as a whole
+    _activeRowCount= 0;
+    _touchedRowCount= 0;
+    _weightsDeltaRowSparse= NO;
+    
+    _softmaxTrainingType= MLSoftmaxTrainingTypeFull;
+    _sampledSoftmaxSamples= 0;
+    _classCounts= nil;
+}
+
+
+#pragma mark -
+#pragma mark Operations
+
+- (void) feedForward {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Reset error and delta
+    ML_VCLR(_deltaBuffer, 1, _size);
+    ML_VCLR(_errorBuffer, 1, _size);
+    
+    _sparseInput= NO;
+    _activeRowCount= 0;
+    
+    if (_treeChildren) {
+        ML_PROFILE_BEGIN(_profileState, MLProfilePhaseFeedForward);
+        
+        // First step: compute the dot products of inner nodes
+        // of the tree, one per row but the last one
+        ML_GEMV(CblasRowMajor, CblasNoTrans,
+                (int) (_size -1), (int) _inputSize,
+                __one, _weights, (int) _inputSize,
+                _inputBuffer, 1,
+                __zero, _treeNodeBuffer, 1);
+        
+        ML_PROFILE_END(_profileState, _index, MLProfilePhaseFeedForward,
+                       2 * (_size -1) * _inputSize,
+                       sizeof(MLReal) * ((_size -1) * _inputSize + _inputSize + _size));
+        
+        // Second step: class probabilities are products of the
+        // sigmoid outputs of inner nodes along their path
+        ML_PROFILE_BEGIN(_profileState, MLProfilePhaseActivation);
+        
+        MLActivateSigmoid(_treeNodeBuffer, _size -1, _fastApproximateActivation);
+        MLHierarchicalProbabilities(_treeNodeBuffer, _treeChildren, _size, &_treeNodeBuffer[_size -1], _outputBuffer);
+        
+        ML_PROFILE_END(_profileState, _index, MLProfilePhaseActivation,
+                       3 * _size,
+                       4 * sizeof(MLReal) * _size);
+        return;
+    }
+
+    // Compute output and apply activation function
+    [self feedForwardBatchOfSize:1 inputBuffer:_inputBuffer outputBuffer:_outputBuffer];
+}
+
+- (void) feedForwardSparseInputWithIndices:(const int *)indices values:(const MLReal *)values size:(NSUInteger)size {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (!_sparseInputIndices)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input is supported only by the first neuron layer"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (size > _inputSize)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input size exceeds the input size"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"size": @(size),
+                                                                            @"inputSize": @(_inputSize)}];
+    
+    if (_softmaxTrainingType != MLSoftmaxTrainingTypeFull)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input is supported only with full softmax training"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Reset error and delta
+    ML_VCLR(_deltaBuffer, 1, _size);
+    ML_VCLR(_errorBuffer, 1, _size);
+    
+    _activeRowCount= 0;
+    
+    // Keep a copy of the input for backpropagation
+    for (NSUInteger i= 0; i < size; i++) {
+        if ((indices[i] < 0) || (indices[i] >= _inputSize))
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input index out of range"
+                                                                     userInfo:@{@"layer": @(self.index),
+                                                                                @"index": @(indices[i])}];
+        
+        _sparseInputIndices[i]= indices[i];
+        _sparseInputValues[i]= values[i];
+    }
+    
+    _sparseInput= YES;
+    _sparseInputSize= size;
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseFeedForward);
+    
+    // First step: compute the dot products of all neurons
+    // using only the weight columns of nonzero inputs
+    for (NSUInteger i= 0; i < _size; i++) {
+        MLReal *weights= &_weights[i * _inputSize];
+        
+        MLReal dot= __zero;
+        for (NSUInteger j= 0; j < size; j++)
+            dot += weights[_sparseInputIndices[j]] * _sparseInputValues[j];
+        
+        _outputBuffer[i]= dot;
+    }
+    
+    // Bias neurons have constant output, it
+    // is set before activation for consistency
+    if (_usingBias)
+        _outputBuffer[_size -1]= __one;
+    
+    // Dot products touch only the weight columns of nonzero inputs
+    ML_PROFILE_END(_profileState, _index, MLProfilePhaseFeedForward,
+                   2 * _size * size,
+                   sizeof(MLReal) * _size * (size + 1) + (sizeof(int) + sizeof(MLReal)) * size);
+    
+    // Second step: apply activation function
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseActivation);
+    
+    [self applyActivationFunctionToBuffer:_outputBuffer size:_size];
+    
+    ML_PROFILE_END(_profileState, _index, MLProfilePhaseActivation,
+                   _size,
+                   2 * sizeof(MLReal) * _size);
+}
+
+- (void) fetchErrorFromNextLayer {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    MLNeuronLayer *nextLayer= (MLNeuronLayer *) self.nextLayer;
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseErrorFetch);
+    
+    [nextLayer propagateErrorToBuffer:_errorBuffer];
+    
+    // Bias neurons have constant output and don't backpropagate
+    if (_usingBias)
+        _errorBuffer[_size -1]= __zero;
+    
+    // The weights and, unless an adaptive optimizer is used, the weights delta
+    // of the next layer are read, only the rows of candidates with a softmax
+    // approximation
+    NSUInteger rows= (nextLayer->_activeRowCount > 0) ? nextLayer->_activeRowCount : nextLayer.size;
+    NSUInteger matrices= MLBackPropagationTypeIsAdaptive(nextLayer->_backPropType) ? 1 : 2;
+    
+    ML_PROFILE_END(_profileState, _index, MLProfilePhaseErrorFetch,
+                   2 * matrices * rows * _size,
+                   sizeof(MLReal) * (matrices * rows * _size + rows + 2 * _size));
+}
+
+- (void) propagateErrorToBuffer:(MLReal *)errorBuffer {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Adaptive optimizers accumulate the plain gradient in the weights
+    // delta, it is not a step to be summed to the weights
+    BOOL addWeightsDelta= !MLBackPropagationTypeIsAdaptive(_backPropType);
+    
+    if (_activeRowCount > 0) {
+        
+        // Only candidates of the softmax approximation have a delta:
+        // error = Sum(delta[j] * (weights[row[j]] + weightsDelta[row[j]]))
+        ML_VCLR(errorBuffer, 1, _inputSize);
+        
+        for (NSUInteger j= 0; j < _activeRowCount; j++) {
+            NSUInteger offset= _activeRows[j] * _inputSize;
+            
+            ML_VSMA(&_weights[offset], 1, &_activeDeltas[j], errorBuffer, 1, errorBuffer, 1, _inputSize);
+            
+            if (addWeightsDelta)
+                ML_VSMA(&_weightsDelta[offset], 1, &_activeDeltas[j], errorBuffer, 1, errorBuffer, 1, _inputSize);
+        }
+        
+        return;
+    }
+    
+    // Compute the error with two transposed matrix-vector multiplications,
+    // as weights delta are summed to weights: error = weights^T x delta,
+    // then error += weightsDelta^T x delta (skipped with adaptive optimizers)
+    ML_GEMV(CblasRowMajor, CblasTrans,
+            (int) _size, (int) _inputSize,
+            __one, _weights, (int) _inputSize,
+            _deltaBuffer, 1,
+            __zero, errorBuffer, 1);
+    
+    if (addWeightsDelta)
+        ML_GEMV(CblasRowMajor, CblasTrans,
+                (int) _size, (int) _inputSize,
+                __one, _weightsDelta, (int) _inputSize,
+                _deltaBuffer, 1,
+                __one, errorBuffer, 1);
+}
+
+- (void) backPropagateWithAlgorithm:(MLBackPropagationType)backPropType learningRate:(MLReal)learningRate costFunction:(MLCostFunctionType)costType {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Rows of hierarchical softmax are nodes of the tree, not classes
+    if (_treeChildren)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Hierarchical softmax can be back propagated only by class"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseBackPropagation);
+    
+    // All rows have a delta now
+    _activeRowCount= 0;
+    _weightsDeltaRowSparse= NO;
+    
+    // First step: compute the delta with
+    // activation function derivative
+    [self computeDeltaBuffer:_deltaBuffer
+             fromErrorBuffer:_errorBuffer
+                outputBuffer:_outputBuffer
+                        size:_size
+                costFunction:costType];
+    
+    // Second step: compute new weights
+    switch (backPropType) {
+        case MLBackPropagationTypeStandard:
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+        case MLBackPropagationTypeRMSProp:
+        case MLBackPropagationTypeAdam: {
+            
+            // Bias neurons don't backpropagate, their row is excluded
+            NSUInteger rows= _usingBias ? (_size -1) : _size;
+            
+            // Adaptive optimizers accumulate the plain gradient,
+            // the learning rate is applied during the update
+            if (MLBackPropagationTypeIsAdaptive(backPropType)) {
+                if (_sparseInput)
+                    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input is supported only with standard backpropagation"
+                                                                             userInfo:@{@"layer": @(self.index)}];
+                
+                _learningRate= learningRate;
+                learningRate= __one;
+            }
+            
+            if (_sparseInput) {
+                
+                // Weights delta stay sparse only if nothing
+                // else has been accumulated since last update
+                if (!_weightsDeltaPending)
+                    _weightsDeltaSparse= YES;
+                
+                _weightsDeltaPending= YES;
+                
+                // Compute weights delta of columns of nonzero inputs only:
+                // weightsDelta[i][j] += learningRate * delta[i] * input[j]
+                for (NSUInteger i= 0; i < rows; i++) {
+                    MLReal *weightsDelta= &_weightsDelta[i * _inputSize];
+                    MLReal rate= learningRate * _deltaBuffer[i];
+                    
+                    for (NSUInteger j= 0; j < _sparseInputSize; j++)
+                        weightsDelta[_sparseInputIndices[j]] += rate * _sparseInputValues[j];
+                }
+                
+                // Track touched columns for the update
+                for (NSUInteger j= 0; j < _sparseInputSize; j++) {
+                    int column= _sparseInputIndices[j];
+                    
+                    if (!_touchedColumnFlags[column]) {
+                        _touchedColumnFlags[column]= 1;
+                        _touchedColumns[_touchedColumnCount++]= column;
+                    }
+                }
+                
+                ML_PROFILE_END(_profileState, _index, MLProfilePhaseBackPropagation,
+                               3 * _size + 2 * rows * _sparseInputSize,
+                               sizeof(MLReal) * (3 * _size + 2 * rows * _sparseInputSize));
+                break;
+            }
+            
+            _weightsDeltaPending= YES;
+            _weightsDeltaSparse= NO;
+            
+            // Compute weights delta with a single rank-1 update:
+            // weightsDelta += learningRate * delta x input^T
+            ML_GER(CblasRowMajor,
+                   (int) rows, (int) _inputSize,
+                   learningRate, _deltaBuffer, 1,
+                   _inputBuffer, 1,
+                   _weightsDelta, (int) _inputSize);
+            
+            // Rank-1 update reads and writes the whole weights delta
+            ML_PROFILE_END(_profileState, _index, MLProfilePhaseBackPropagation,
+                           3 * _size + 2 * rows * _inputSize,
+                           sizeof(MLReal) * (3 * _size + _inputSize + 2 * rows * _inputSize));
+            break;
+        }
+            
+        case MLBackPropagationTypeResilient:
+        case MLBackPropagationTypeImprovedResilient: {
+            if (_sparseInput)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input is supported only with standard backpropagation"
+                                                                         userInfo:@{@"layer": @(self.index)}];
+            
+            // Bias neurons don't backpropagate, their row is excluded
+            NSUInteger rows= _usingBias ? (_size -1) : _size;
+            
+            _weightsDeltaPending= YES;
+            _weightsDeltaSparse= NO;
+            
+            // Apply the RPROP step to the whole layer at once, computing
+            // the gradient on the fly: gradient = delta x input^T
+            MLOptimizeResilientOuter(_weightsDelta, _deltaBuffer, _inputBuffer,
+                                     _weightSteps, _previousGradient, _previousWeightsChange,
+                                     rows, _inputSize, (backPropType == MLBackPropagationTypeResilient));
+            
+            ML_PROFILE_END(_profileState, _index, MLProfilePhaseBackPropagation,
+                           3 * _size + 6 * rows * _inputSize,
+                           sizeof(MLReal) * (3 * _size + _inputSize + 8 * rows * _inputSize));
+            break;
+        }
+    }
+}
+
+- (MLReal) backPropagateClass:(NSUInteger)targetClass learningRate:(MLReal)learningRate {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_softmaxTrainingType == MLSoftmaxTrainingTypeFull)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not set up for sampled or hierarchical softmax"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (targetClass >= _size)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Class out of range"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"class": @(targetClass)}];
+    
+    if (_sparseInput)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Sparse input is supported only with full softmax training"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseBackPropagation);
+    
+    MLReal cost= __zero;
+    _activeRowCount= 0;
+    
+    switch (_softmaxTrainingType) {
+        case MLSoftmaxTrainingTypeSampled: {
+            
+            // Candidates are the target first, then the classes drawn
+            // in constant time from the alias tables; draws of the
+            // target itself and repeated draws are dropped
+            _activeRows[_activeRowCount++]= (int) targetClass;
+            _candidateRowFlags[targetClass]= 1;
+            
+            for (NSUInteger i= 0; i < _sampledSoftmaxSamples; i++) {
+                NSUInteger drawn= [MLRandom nextUniformUIntWithMax:_size];
+                int row= ([MLRandom nextUniformReal] < _aliasProbabilities[drawn]) ? (int) drawn : _aliases[drawn];
+                
+                if (!_candidateRowFlags[row]) {
+                    _candidateRowFlags[row]= 1;
+                    _activeRows[_activeRowCount++]= row;
+                }
+            }
+            
+            // Clear the flags of candidates for the next sample
+            for (NSUInteger j= 0; j < _activeRowCount; j++)
+                _candidateRowFlags[_activeRows[j]]= 0;
+            
+            // Apply formula: logit[j] = weights[row[j]] . input - ln(drawProbability[row[j]])
+            MLReal maxLogit= __zero;
+            for (NSUInteger j= 0; j < _activeRowCount; j++) {
+                MLReal dot= __zero;
+                ML_DOTPR(&_weights[_activeRows[j] * _inputSize], 1, _inputBuffer, 1, &dot, _inputSize);
+                
+                _activeDeltas[j]= dot - _samplingCorrections[_activeRows[j]];
+                maxLogit= ((j == 0) || (_activeDeltas[j] > maxLogit)) ? _activeDeltas[j] : maxLogit;
+            }
+            
+            // Softmax over the candidates, with the maximum subtracted
+            MLReal sum= __zero;
+            for (NSUInteger j= 0; j < _activeRowCount; j++) {
+                _activeDeltas[j]= ML_EXP(_activeDeltas[j] - maxLogit);
+                sum += _activeDeltas[j];
+            }
+            
+            // Apply formula: cost = -ln(p[0]), computed from the logit
+            cost= ML_LOG(sum) - ML_LOG(_activeDeltas[0]);
+            
+            // Apply formula: delta[j] = (j == 0 ? 1 : 0) - p[j]
+            for (NSUInteger j= 0; j < _activeRowCount; j++)
+                _activeDeltas[j]= ((j == 0) ? __one : __zero) - (_activeDeltas[j] / sum);
+            
+            break;
+        }
+            
+        case MLSoftmaxTrainingTypeHierarchical: {
+            
+            // Candidates are the inner nodes on the path of the target,
+            // each a binary classifier of the code taken
+            for (int i= _treePathOffsets[targetClass]; i < _treePathOffsets[targetClass +1]; i++) {
+                int row= _treePathNodes[i];
+                MLReal code= (MLReal) _treePathCodes[i];
+                
+                MLReal dot= __zero;
+                ML_DOTPR(&_weights[row * _inputSize], 1, _inputBuffer, 1, &dot, _inputSize);
+                
+                // Clipping avoids overflows of exp
+                dot= (dot < -40.0) ? -40.0 : ((dot > 40.0) ? 40.0 : dot);
+                MLReal output= __one / (__one + ML_EXP(-dot));
+                
+                // Apply formula: cost -= ln(code ? output : 1 - output)
+                cost += ML_LOG(__one + ML_EXP((code > __zero) ? -dot : dot));
+                
+                // Apply formula: delta = code - output
+                _activeRows[_activeRowCount]= row;
+                _activeDeltas[_activeRowCount]= code - output;
+                _activeRowCount++;
+            }
+            
+            break;
+        }
+            
+        default:
+            break;
+    }
+    
+    // Weights delta stay sparse by rows only if nothing
+    // else has been accumulated since last update
+    if (!_weightsDeltaPending)
+        _weightsDeltaRowSparse= YES;
+    
+    _weightsDeltaPending= YES;
+    _weightsDeltaSparse= NO;
+    
+    // Compute weights delta of candidate rows only:
+    // weightsDelta[row[j]] += learningRate * delta[j] * input
+    for (NSUInteger j= 0; j < _activeRowCount; j++) {
+        int row= _activeRows[j];
+        MLReal *weightsDelta= &_weightsDelta[row * _inputSize];
+        MLReal rate= learningRate * _activeDeltas[j];
+        
+        ML_VSMA(_inputBuffer, 1, &rate, weightsDelta, 1, weightsDelta, 1, _inputSize);
+        
+        // Track touched rows for the update
+        if (!_touchedRowFlags[row]) {
+            _touchedRowFlags[row]= 1;
+            _touchedRows[_touchedRowCount++]= row;
+        }
+    }
+    
+    // Each candidate reads its row of weights and updates its row of weights delta
+    ML_PROFILE_END(_profileState, _index, MLProfilePhaseBackPropagation,
+                   4 * _activeRowCount * _inputSize,
+                   sizeof(MLReal) * (_inputSize + 3 * _activeRowCount * _inputSize));
+    
+    return cost;
+}
+
+- (void) updateWeights {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_weightsReadOnly)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't update read-only weights"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_factorU)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't update weights of a factorized layer, remove the factorization first"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseWeightsUpdate);
+    
+    // Pruned weights stay zero while fine-tuning
+    if (_pruningMask)
+        ML_VMUL(_weightsDelta, 1, _pruningMask, 1, _weightsDelta, 1, _size * _inputSize);
+    
+    if (_weightsDeltaPending && _weightsDeltaRowSparse) {
+        
+        // Only rows of softmax candidates have changed: add and clear them
+        for (NSUInteger i= 0; i < _touchedRowCount; i++) {
+            NSUInteger offset= _touchedRows[i] * _inputSize;
+            
+            ML_VADD(&_weightsDelta[offset], 1, &_weights[offset], 1, &_weights[offset], 1, _inputSize);
+            ML_VCLR(&_weightsDelta[offset], 1, _inputSize);
+            
+            // Half-precision copy is updated row by row too
+            if (_halfWeights)
+                MLConvertRealToHalf(_weightsStorageType, &_weights[offset], 1, &_halfWeights[offset], 1, _inputSize);
+        }
+        
+        // Weights and weights delta are both read and written
+        ML_PROFILE_END(_profileState, _index, MLProfilePhaseWeightsUpdate,
+                       _touchedRowCount * _inputSize,
+                       4 * sizeof(MLReal) * _touchedRowCount * _inputSize);
+        
+    } else if (_weightsDeltaPending && _weightsDeltaSparse) {
+        
+        // Only columns of sparse inputs have changed: add and clear them,
+        // with a stride of a row (bias row is excluded, its delta is 0)
+        NSUInteger rows= _usingBias ? (_size -1) : _size;
+        
+        for (NSUInteger i= 0; i < _touchedColumnCount; i++) {
+            int column= _touchedColumns[i];
+            
+            ML_VADD(&_weightsDelta[column], _inputSize, &_weights[column], _inputSize, &_weights[column], _inputSize, rows);
+            ML_VCLR(&_weightsDelta[column], _inputSize, rows);
+            
+            // Half-precision copy is updated column by column too
+            if (_halfWeights)
+                MLConvertRealToHalf(_weightsStorageType, &_weights[column], _inputSize, &_halfWeights[column], _inputSize, rows);
+        }
+        
+        // Weights and weights delta are both read and written
+        ML_PROFILE_END(_profileState, _index, MLProfilePhaseWeightsUpdate,
+                       rows * _touchedColumnCount,
+                       4 * sizeof(MLReal) * rows * _touchedColumnCount);
+        
+    } else if (MLBackPropagationTypeIsAdaptive(_backPropType)) {
+        
+        // Apply the optimizer step, state and weights delta are
+        // updated and cleared in the same pass
+        if (_weightsDeltaPending)
+            [self applyOptimizer];
+        
+        // Update the half-precision copy, if any
+        [self updateWeightsStorage];
+        
+        ML_PROFILE_END(_profileState, _index, MLProfilePhaseWeightsUpdate,
+                       8 * _size * _inputSize,
+                       ((_backPropType == MLBackPropagationTypeAdam) ? 8 : 6) * sizeof(MLReal) * _size * _inputSize);
+        
+    } else {
+        
+        // Add the weights with the weights delta, whole matrix at once
+        ML_VADD(_weightsDelta, 1, _weights, 1, _weights, 1, _size * _inputSize);
+        
+        // Clear the weights delta matrix
+        ML_VCLR(_weightsDelta, 1, _size * _inputSize);
+        
+        // Update the half-precision copy, if any
+        [self updateWeightsStorage];
+        
+        ML_PROFILE_END(_profileState, _index, MLProfilePhaseWeightsUpdate,
+                       _size * _inputSize,
+                       4 * sizeof(MLReal) * _size * _inputSize);
+    }
+    
+    // Values of the sparse matrix follow the weights
+    if (_prunedValues)
+        [self updatePrunedMatrix];
+    
+    // Reset tracking of touched columns
+    for (NSUInteger i= 0; i < _touchedColumnCount; i++)
+        _touchedColumnFlags[_touchedColumns[i]]= 0;
+    
+    _touchedColumnCount= 0;
+    
+    // Reset tracking of touched rows
+    for (NSUInteger i= 0; i < _touchedRowCount; i++)
+        _touchedRowFlags[_touchedRows[i]]= 0;
+    
+    _touchedRowCount= 0;
+    _weightsDeltaPending= NO;
+    _weightsDeltaSparse= NO;
+    _weightsDeltaRowSparse= NO;
+}
+
+- (NSUInteger) selectTopClasses:(NSUInteger)k indices:(int *)indices probabilities:(MLReal *)probabilities {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_funcType != MLActivationFunctionTypeSoftmax)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Top classes can be selected only on a softmax layer"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_treeChildren) {
+        
+        // Exact best-first search from the input, only the inner
+        // nodes above the top classes are computed
+        return MLHierarchicalTopClasses(_weights, _inputBuffer, _inputSize, _treeChildren, _size, k,
+                                        indices, probabilities, _topValues, _topNodes);
+    }
+    
+    // Output is the exact softmax, select from it
+    NSUInteger found= MLSelectTopValues(_outputBuffer, _size, k, indices, _topValues);
+    
+    if (probabilities)
+        memcpy(probabilities, _topValues, found * sizeof(MLReal));
+    
+    return found;
+}
+
+
+#pragma mark -
+#pragma mark Batch operations
+
+- (void) feedForwardBatchOfSize:(NSUInteger)size {
+    if (!_batchOutputBuffer)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up for batch"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+
+    if (size > _batchSize)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Batch size exceeds the size the layer was set up for"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"size": @(size),
+                                                                            @"batchSize": @(_batchSize)}];
+    
+    // Compute output and apply activation function
+    [self feedForwardBatchOfSize:size inputBuffer:[self previousLayerBatchOutputBuffer] outputBuffer:_batchOutputBuffer];
+}
+
+- (void) feedForwardBatchOfSize:(NSUInteger)size inputBuffer:(MLReal *)inputBuffer outputBuffer:(MLReal *)outputBuffer {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_treeChildren)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Hierarchical softmax can be fed forward only one sample at a time"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseFeedForward);
+    
+    // This method reads only the weights and the passed buffers,
+    // hence it may be called concurrently on different buffers
+    if (_factorU) {
+        NSUInteger rows= _usingBias ? (_size -1) : _size;
+        
+        // First step: compute the dot products with the two thinner
+        // factors, passing through a rank-sized intermediate vector:
+        // output = U x (V x input); the intermediate is on the stack,
+        // so the batch is split in blocks that fit it
+        MLReal intermediate[FACTORIZATION_BLOCK_SIZE];
+        NSUInteger blockSize= FACTORIZATION_BLOCK_SIZE / _factorizationRank;
+        
+        for (NSUInteger b= 0; b < size; b += blockSize) {
+            NSUInteger count= MIN(blockSize, size - b);
+            MLReal *input= &inputBuffer[b * _inputSize];
+            MLReal *output= &outputBuffer[b * _size];
+            
+            if (count == 1) {
+                ML_GEMV(CblasRowMajor, CblasNoTrans,
+                        (int) _factorizationRank, (int) _inputSize,
+                        __one, _factorV, (int) _inputSize,
+                        input, 1,
+                        __zero, intermediate, 1);
+                
+                ML_GEMV(CblasRowMajor, CblasNoTrans,
+                        (int) rows, (int) _factorizationRank,
+                        __one, _factorU, (int) _factorizationRank,
+                        intermediate, 1,
+                        __zero, output, 1);
+                
+            } else {
+                ML_GEMM(CblasRowMajor, CblasNoTrans, CblasTrans,
+                        (int) count, (int) _factorizationRank, (int) _inputSize,
+                        __one, input, (int) _inputSize,
+                        _factorV, (int) _inputSize,
+                        __zero, intermediate, (int) _factorizationRank);
+                
+                ML_GEMM(CblasRowMajor, CblasNoTrans, CblasTrans,
+                        (int) count, (int) rows, (int) _factorizationRank,
+                        __one, intermediate, (int) _factorizationRank,
+                        _factorU, (int) _factorizationRank,
+                        __zero, output, (int) _size);
+            }
+        }
+        
+    } else if (_prunedValues) {
+        
+        // First step: compute the dot products of the whole batch
+        // with nonzero weights only, from the sparse matrix
+        MLSparseMatrixProduct(_prunedRowOffsets, _prunedColumns, _prunedValues, inputBuffer, outputBuffer,
+                              size, (_usingBias ? (_size -1) : _size), _inputSize, _size);
+        
+    } else if (_halfWeights) {
+        
+        // First step: compute the dot products of the whole batch, weights
+        // are converted from half precision as they are loaded
+        MLHalfMatrixProduct(_weightsStorageType, _halfWeights, inputBuffer, outputBuffer, size, _size, _inputSize);
+        
+    } else if (size == 1) {
+        
+        // First step: compute the dot products of all neurons with
+        // a single matrix-vector multiplication: output = weights x input
+        ML_GEMV(CblasRowMajor, CblasNoTrans,
+                (int) _size, (int) _inputSize,
+                __one, _weights, (int) _inputSize,
+                inputBuffer, 1,
+                __zero, outputBuffer, 1);
+        
+    } else {
+        
+        // First step: compute the dot products of the whole batch
+        // with a single matrix multiplication: output = input x weights^T
+        ML_GEMM(CblasRowMajor, CblasNoTrans, CblasTrans,
+                (int) size, (int) _size, (int) _inputSize,
+                __one, inputBuffer, (int) _inputSize,
+                _weights, (int) _inputSize,
+                __zero, outputBuffer, (int) _size);
+    }
+    
+    // Bias neurons have constant output, it
+    // is set before activation for consistency
+    if (_usingBias)
+        ML_VFILL(&__one, &outputBuffer[_size -1], _size, size);
+    
+    // Weights (or factors) are read once for the whole batch
+    ML_PROFILE_END(_profileState, _index, MLProfilePhaseFeedForward,
+                   2 * size * (_factorU ? self.factorizedWeightsCount : (_prunedValues ? _nonzeroCount : (_size * _inputSize))),
+                   (_factorU ? (sizeof(MLReal) * self.factorizedWeightsCount) :
+                    (_prunedValues ? ((sizeof(MLReal) + sizeof(int)) * _nonzeroCount) :
+                     ((_halfWeights ? sizeof(MLHalf) : sizeof(MLReal)) * _size * _inputSize))) + sizeof(MLReal) * size * (_inputSize + _size));
+    
+    // Second step: apply activation function
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseActivation);
+    
+    [self applyActivationFunctionToBuffer:outputBuffer size:size * _size];
+    
+    ML_PROFILE_END(_profileState, _index, MLProfilePhaseActivation,
+                   size * _size,
+                   2 * sizeof(MLReal) * size * _size);
+}
+
+- (void) fetchBatchErrorFromNextLayerOfSize:(NSUInteger)size {
+    if (!_batchErrorBuffer)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up for batch"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    MLNeuronLayer *nextLayer= (MLNeuronLayer *) self.nextLayer;
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseErrorFetch);
+    
+    // Compute the error of the whole batch with a single
+    // matrix multiplication: error = nextDelta x nextWeights
+    ML_GEMM(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+            (int) size, (int) _size, (int) nextLayer.size,
+            __one, nextLayer->_batchDeltaBuffer, (int) nextLayer.size,
+            nextLayer->_weights, (int) _size,
+            __zero, _batchErrorBuffer, (int) _size);
+    
+    // Bias neurons have constant output and don't backpropagate
+    if (_usingBias)
+        ML_VCLR(&_batchErrorBuffer[_size -1], _size, size);
+    
+    ML_PROFILE_END(_profileState, _index, MLProfilePhaseErrorFetch,
+                   2 * size * nextLayer.size * _size,
+                   sizeof(MLReal) * (nextLayer.size * _size + size * (nextLayer.size + _size)));
+}
+
+- (void) backPropagateBatchOfSize:(NSUInteger)size algorithm:(MLBackPropagationType)backPropType learningRate:(MLReal)learningRate costFunction:(MLCostFunctionType)costType {
+    if (!_batchDeltaBuffer)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up for batch"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    MLReal *inputBuffer= [self previousLayerBatchOutputBuffer];
+    
+    ML_PROFILE_BEGIN(_profileState, MLProfilePhaseBackPropagation);
+    
+    // First step: compute the delta of the whole batch
+    // with activation function derivative
+    [self computeDeltaBuffer:_batchDeltaBuffer
+             fromErrorBuffer:_batchErrorBuffer
+                outputBuffer:_batchOutputBuffer
+                        size:size * _size
+                costFunction:costType];
+    
+    // Bias neurons don't backpropagate, their row is excluded
+    NSUInteger rows= _usingBias ? (_size -1) : _size;
+    
+    _weightsDeltaPending= YES;
+    _weightsDeltaSparse= NO;
+    _weightsDeltaRowSparse= NO;
+    
+    // Second step: compute the gradient summed over the batch with a
+    // single matrix multiplication (gradient = delta^T x input) and
+    // apply it to the weights delta
+    switch (backPropType) {
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+        case MLBackPropagationTypeRMSProp:
+        case MLBackPropagationTypeAdam:
+            
+            // Adaptive optimizers accumulate the plain gradient,
+            // the learning rate is applied during the update
+            _learningRate= learningRate;
+            learningRate= __one;
+            
+            // Fall through
+            
+        case MLBackPropagationTypeStandard: {
+            
+            // Accumulate directly: weightsDelta += learningRate * gradient
+            ML_GEMM(CblasRowMajor, CblasTrans, CblasNoTrans,
+                    (int) rows, (int) _inputSize, (int) size,
+                    learningRate, _batchDeltaBuffer, (int) _size,
+                    inputBuffer, (int) _inputSize,
+                    __one, _weightsDelta, (int) _inputSize);
+            
+            ML_PROFILE_END(_profileState, _index, MLProfilePhaseBackPropagation,
+                           3 * size * _size + 2 * size * rows * _inputSize,
+                           sizeof(MLReal) * (3 * size * _size + size * _inputSize + 2 * rows * _inputSize));
+            break;
+        }
+            
+        case MLBackPropagationTypeResilient:
+        case MLBackPropagationTypeImprovedResilient: {
+            if (!_batchGradientBuffer)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up for batch resilient backpropagation"
+                                                                         userInfo:@{@"layer": @(self.index)}];
+            
+            ML_GEMM(CblasRowMajor, CblasTrans, CblasNoTrans,
+                    (int) rows, (int) _inputSize, (int) size,
+                    __one, _batchDeltaBuffer, (int) _size,
+                    inputBuffer, (int) _inputSize,
+                    __zero, _batchGradientBuffer, (int) _inputSize);
+            
+            // Apply the RPROP step to the whole layer at once
+            MLOptimizeResilient(_weightsDelta, _batchGradientBuffer,
+                                _weightSteps, _previousGradient, _previousWeightsChange,
+                                rows * _inputSize, (backPropType == MLBackPropagationTypeResilient));
+            
+            ML_PROFILE_END(_profileState, _index, MLProfilePhaseBackPropagation,
+                           3 * size * _size + 2 * size * rows * _inputSize + 6 * rows * _inputSize,
+                           sizeof(MLReal) * (3 * size * _size + size * _inputSize + 9 * rows * _inputSize));
+            break;
+        }
+    }
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (void) applyActivationFunctionToBuffer:(MLReal *)buffer size:(NSUInteger)size {
+    if (_funcType == MLActivationFunctionTypeSoftmax) {
+        
+        // Softmax normalizes each sample of the batch on its own
+        for (NSUInteger offset= 0; offset < size; offset += _size)
+            MLActivate(_funcType, &buffer[offset], _size, _fastApproximateActivation);
+        
+        return;
+    }
+    
+    MLActivate(_funcType, buffer, size, _fastApproximateActivation);
+}
+
+- (void) computeDeltaBuffer:(MLReal *)deltaBuffer fromErrorBuffer:(MLReal *)errorBuffer outputBuffer:(MLReal *)outputBuffer size:(NSUInteger)size costFunction:(MLCostFunctionType)costType {
+    switch (_funcType) {
+        case MLActivationFunctionTypeLinear: {
+            
+            // Apply formula: delta[i] = error[i]
+            ML_VSMUL(errorBuffer, 1, &__one, deltaBuffer, 1, size);
+            break;
+        }
+            
+        case MLActivationFunctionTypeRectifiedLinear: {
+            
+            // Apply formula: delta[i] = (output[i] > 0.0 ? error[i] : 0.0)
+            MLDeltaRectifiedLinear(outputBuffer, errorBuffer, deltaBuffer, size);
+            break;
+        }
+
+        case MLActivationFunctionTypeStep: {
+            if (self.nextLayer)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't backpropagate in a hidden layer with step function"
+                                                                         userInfo:@{@"layer": @(self.index)}];
+            
+            // Apply formula: delta[i] = error[i]
+            ML_VSMUL(errorBuffer, 1, &__one, deltaBuffer, 1, size);
+            break;
+        }
+            
+        case MLActivationFunctionTypeSigmoid: {
+            switch (costType) {
+                case MLCostFunctionTypeCrossEntropy: {
+                    
+                    // Apply formula: delta[i] = error[i]
+                    ML_VSMUL(errorBuffer, 1, &__one, deltaBuffer, 1, size);
+                    break;
+                }
+                    
+                case MLCostFunctionTypeSquaredError: {
+                    
+                    // Apply formula: delta[i] = output[i] * (1 - output[i]) * error[i]
+                    MLDeltaSigmoid(outputBuffer, errorBuffer, deltaBuffer, size);
+                    break;
+                }
+            }
+            break;
+        }
+            
+        case MLActivationFunctionTypeTanH: {
+            
+            // Apply formula: delta[i] = (1 - (output[i] * output[i])) * error[i]
+            MLDeltaTanH(outputBuffer, errorBuffer, deltaBuffer, size);
+            break;
+        }
+            
+        case MLActivationFunctionTypeSoftmax: {
+            
+            // Softmax is used only with cross entropy, whose
+            // gradient on logits is the error itself
+            // Apply formula: delta[i] = error[i]
+            ML_VSMUL(errorBuffer, 1, &__one, deltaBuffer, 1, size);
+            break;
+        }
+    }
+}
+
+- (void) applyOptimizer {
+    
+    // Bias row is included: its delta is 0, but the state still decays
+    NSUInteger size= _size * _inputSize;
+    
+    switch (_backPropType) {
+        case MLBackPropagationTypeMomentum:
+        case MLBackPropagationTypeNesterov:
+            MLOptimizeMomentum(_weights, _weightsDelta, _optimizerState, size, _learningRate, _momentum,
+                               (_backPropType == MLBackPropagationTypeNesterov));
+            break;
+            
+        case MLBackPropagationTypeRMSProp:
+            MLOptimizeRMSProp(_weights, _weightsDelta, _optimizerState, size, _learningRate, _decayRate, _epsilon);
+            break;
+            
+        case MLBackPropagationTypeAdam: {
+            _optimizerSteps++;
+            
+            // Fold the bias correction of both moments in
+            // the step size and epsilon, so the kernel can
+            // use the moments as they are
+            MLReal correction1= __one - ML_POW(_momentum, (MLReal) _optimizerSteps);
+            MLReal correction2= ML_SQRT(__one - ML_POW(_decayRate, (MLReal) _optimizerSteps));
+            
+            MLOptimizeAdam(_weights, _weightsDelta, _optimizerState, _optimizerSecondState, size,
+                           _learningRate * correction2 / correction1, _momentum, _decayRate, _epsilon * correction2);
+            break;
+        }
+            
+        default:
+            break;
+    }
+}
+
+- (void) freePrunedMatrix {
+    MLFreeIntBuffer(_prunedRowOffsets);
+    _prunedRowOffsets= NULL;
+    
+    MLFreeIntBuffer(_prunedColumns);
+    _prunedColumns= NULL;
+    
+    MLFreeRealBuffer(_prunedValues);
+    _prunedValues= NULL;
+    
+    _nonzeroCount= 0;
+}
+
+- (void) updatePrunedMatrix {
+    NSUInteger rows= _usingBias ? (_size -1) : _size;
+    
+    // Gather nonzero weights, row by row
+    for (NSUInteger i= 0; i < rows; i++) {
+        MLReal *weights= &_weights[i * _inputSize];
+        
+        for (int k= _prunedRowOffsets[i]; k < _prunedRowOffsets[i +1]; k++)
+            _prunedValues[k]= weights[_prunedColumns[k]];
+    }
+}
+
+- (void) factorizeWithRank:(NSUInteger)rank maxError:(MLReal)maxError {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_weightsReadOnly)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't factorize read-only weights"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_weightsOwner)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't factorize shared weights"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_pruningMask)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't factorize a pruned layer"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    // Bias neurons are not factorized, their row is excluded; the
+    // rank is also limited by the intermediate buffer of feed forward
+    NSUInteger rows= _usingBias ? (_size -1) : _size;
+    NSUInteger maxRank= MIN(MIN(rows, _inputSize), FACTORIZATION_BLOCK_SIZE);
+    
+    if (rank > maxRank)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid rank: exceeds the maximum rank of the layer"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"rank": @(rank),
+                                                                            @"maxRank": @(maxRank)}];
+    
+    [self removeFactorization];
+    
+    // A rank of 0 means it has to be chosen by error
+    BOOL rankByError= (rank == 0);
+    
+    // Decompose a copy of the weights: its rows are rotated until they are
+    // orthogonal, so that weights = rotations^T x rotated; the norms of the
+    // rotated rows are the singular values
+    MLReal *rotated= MLAllocRealBuffer(rows * _inputSize);
+    MLReal *rotations= MLAllocRealBuffer(rows * rows);
+    MLReal *values= MLAllocRealBuffer(rows);
+    int *order= MLAllocIntBuffer(rows);
+    
+    memcpy(rotated, _weights, rows * _inputSize * sizeof(MLReal));
+    
+    MLJacobiSingularValueDecomposition(rotated, rotations, values, rows, _inputSize);
+    MLSortSingularValues(values, order, rows);
+    
+    NSMutableArray<NSNumber *> *singularValues= [[NSMutableArray alloc] initWithCapacity:rows];
+    
+    MLReal energy= __zero;
+    for (NSUInteger i= 0; i < rows; i++) {
+        MLReal value= values[order[i]];
+        
+        [singularValues addObject:@(value)];
+        energy += value * value;
+    }
+    
+    if (rankByError) {
+        
+        // Choose the smallest rank whose relative error, i.e. the
+        // square root of the energy of dropped singular values over
+        // the total, is within the maximum error
+        MLReal dropped= energy;
+        for (; (rank < maxRank) && (dropped > maxError * maxError * energy); rank++)
+            dropped -= values[order[rank]] * values[order[rank]];
+        
+        rank= MAX(rank, 1);
+    }
+    
+    // The dropped energy is summed again, to avoid cancellation
+    MLReal dropped= __zero;
+    for (NSUInteger i= rank; i < rows; i++)
+        dropped += values[order[i]] * values[order[i]];
+    
+    _singularValues= singularValues;
+    
+    // A rank chosen by error is kept only if the factors are smaller
+    // than the weights they replace, otherwise the layer stays dense
+    BOOL smaller= (rank * (rows + _inputSize) < rows * _inputSize);
+    
+    if ((!rankByError) || smaller) {
+        _factorizationRank= rank;
+        _factorizationError= (energy > __zero) ? ML_SQRT(dropped / energy) : __zero;
+        
+        // First factor has the rotations of the largest singular values as
+        // columns, the second has the corresponding rotated rows as rows
+        _factorU= MLAllocRealBuffer(rows * rank);
+        _factorV= MLAllocRealBuffer(rank * _inputSize);
+        
+        for (NSUInteger k= 0; k < rank; k++) {
+            int index= order[k];
+            
+            ML_VSMUL(&rotations[index * rows], 1, &__one, &_factorU[k], rank, rows);
+            ML_VSMUL(&rotated[index * _inputSize], 1, &__one, &_factorV[k * _inputSize], 1, _inputSize);
+        }
+        
+        // Replace the weights with the product of the factors, so that
+        // backpropagation and saved models see the same function
+        ML_GEMM(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                (int) rows, (int) _inputSize, (int) rank,
+                __one, _factorU, (int) rank,
+                _factorV, (int) _inputSize,
+                __zero, _weights, (int) _inputSize);
+        
+        [self updateWeightsStorage];
+    }
+    
+    MLFreeRealBuffer(rotated);
+    MLFreeRealBuffer(rotations);
+    MLFreeRealBuffer(values);
+    MLFreeIntBuffer(order);
+}
+
+- (void) checkSoftmaxApproximationWithClassCounts:(NSArray<NSNumber *> *)counts {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    if (_funcType != MLActivationFunctionTypeSoftmax)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Softmax approximations can be used only on a softmax layer"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"funcType": @(_funcType)}];
+    
+    // Only a few rows are updated at each step, while adaptive
+    // optimizers and RPROP update the whole matrix
+    if (_backPropType != MLBackPropagationTypeStandard)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Softmax approximations are supported only with standard backpropagation"
+                                                                 userInfo:@{@"layer": @(self.index),
+                                                                            @"backPropagationType": @(_backPropType)}];
+    
+    if (counts) {
+        if (counts.count != _size)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Class counts must be as many as the neurons of the layer"
+                                                                     userInfo:@{@"layer": @(self.index),
+                                                                                @"count": @(counts.count)}];
+        
+        for (NSNumber *count in counts) {
+            if (count.doubleValue <= 0.0)
+                @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Class counts must be positive"
+                                                                         userInfo:@{@"layer": @(self.index),
+                                                                                    @"count": count}];
+        }
+    }
+}
+
+- (void) setUpActiveRowsWithCapacity:(NSUInteger)capacity {
+    _activeRowCount= 0;
+    
+    _activeRows= MLAllocIntBuffer(capacity);
+    _activeDeltas= MLAllocRealBuffer(capacity);
+    
+    // Rows updated since last update of weights
+    _touchedRowCount= 0;
+    _touchedRows= MLAllocIntBuffer(_size);
+    _touchedRowFlags= MLAllocIntBuffer(_size);
+    
+    memset(_touchedRowFlags, 0, _size * sizeof(int));
+}
+
+- (MLReal *) previousLayerBatchOutputBuffer {
+    if ([self.previousLayer isKindOfClass:[MLInputLayer class]])
+        return ((MLInputLayer *) self.previousLayer).batchInputBuffer;
+    
+    return ((MLNeuronLayer *) self.previousLayer).batchOutputBuffer;
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+@synthesize funcType= _funcType;
+@synthesize fastApproximateActivation= _fastApproximateActivation;
+@synthesize momentum= _momentum;
+@synthesize decayRate= _decayRate;
+@synthesize epsilon= _epsilon;
+
+@dynamic profile;
+
+- (MLNeuralNetworkProfile *) profile {
+    return _profile;
+}
+
+- (void) setProfile:(MLNeuralNetworkProfile *)profile {
+    _profile= profile;
+    
+    // Keep the counters at hand, to avoid messaging on the hot path
+    _profileState= profile ? profile.state : NULL;
+}
+
+@synthesize weights= _weights;
+@synthesize weightsReadOnly= _weightsReadOnly;
+
+@dynamic weightsStorageType;
+
+- (MLWeightsStorageType) weightsStorageType {
+    return _weightsStorageType;
+}
+
+- (void) setWeightsStorageType:(MLWeightsStorageType)weightsStorageType {
+    if (!_neurons)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Neuron layer not yet set up"
+                                                                 userInfo:@{@"layer": @(self.index)}];
+    
+    _weightsStorageType= weightsStorageType;
+    
+    switch (weightsStorageType) {
+        case MLWeightsStorageTypeReal:
+            MLFreeUInt16Buffer(_halfWeights);
+            _halfWeights= NULL;
+            break;
+            
+        case MLWeightsStorageTypeHalf:
+        case MLWeightsStorageTypeBFloat16:
+            
+            // Master weights stay in MLReal, feed forward uses a copy
+            if (!_halfWeights)
+                _halfWeights= MLAllocUInt16Buffer(_size * _inputSize);
+            
+            [self updateWeightsStorage];
+            break;
+    }
+}
+
+@synthesize halfWeights= _halfWeights;
+
+@dynamic pruned;
+
+- (BOOL) pruned {
+    return (_pruningMask != NULL);
+}
+
+@dynamic sparsity;
+
+- (MLReal) sparsity {
+    if (!_pruningMask)
+        return 0.0;
+    
+    NSUInteger rows= _usingBias ? (_size -1) : _size;
+    return 1.0 - (((MLReal) _nonzeroCount) / ((MLReal) (rows * _inputSize)));
+}
+
+@synthesize nonzeroWeightsCount= _nonzeroCount;
+
+@dynamic factorized;
+
+- (BOOL) factorized {
+    return (_factorU != NULL);
+}
+
+@synthesize factorizationRank= _factorizationRank;
+@synthesize factorizationError= _factorizationError;
+@synthesize singularValues= _singularValues;
+
+@synthesize softmaxTrainingType= _softmaxTrainingType;
+@synthesize sampledSoftmaxSamples= _sampledSoftmaxSamples;
+@synthesize classCounts= _classCounts;
+
+@dynamic factorizedWeightsCount;
+
+- (NSUInteger) factorizedWeightsCount {
+    NSUInteger rows= _usingBias ? (_size -1) : _size;
+    
+    return _factorizationRank * (rows + _inputSize);
+}
+
+@synthesize weightsDelta= _weightsDelta;
+
+@synthesize errorBuffer= _errorBuffer;
+@synthesize deltaBuffer= _deltaBuffer;
+
+@synthesize outputBuffer= _outputBuffer;
+
+@synthesize batchErrorBuffer= _batchErrorBuffer;
+@synthesize batchDeltaBuffer= _batchDeltaBuffer;
+
+@synthesize batchOutputBuffer= _batchOutputBuffer;
 
 @synthesize usingBias= _usingBias;
 @synthesize neurons= _neurons;
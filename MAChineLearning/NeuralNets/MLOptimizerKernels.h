@@ -0,0 +1,67 @@
+//
+//  MLOptimizerKernels.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+
+
+// Optimizer kernels: each applies the accumulated gradient (expected
+// minus actual output times input, hence an ascent direction on the
+// error) to the weights, updating the optimizer state and clearing the
+// gradient with a single pass over the buffers
+
+// Momentum: velocity = momentum * velocity + learningRate * gradient,
+// weights += velocity; with Nesterov look-ahead:
+// weights += momentum * velocity + learningRate * gradient
+void MLOptimizeMomentum(MLReal * _Nonnull weights, MLReal * _Nonnull gradient, MLReal * _Nonnull velocity, NSUInteger size, MLReal learningRate, MLReal momentum, BOOL nesterov);
+
+// RMSProp: meanSquare = decayRate * meanSquare + (1 - decayRate) * gradient^2,
+// weights += learningRate * gradient / (sqrt(meanSquare) + epsilon)
+void MLOptimizeRMSProp(MLReal * _Nonnull weights, MLReal * _Nonnull gradient, MLReal * _Nonnull meanSquare, NSUInteger size, MLReal learningRate, MLReal decayRate, MLReal epsilon);
+
+// Adam: mean = beta1 * mean + (1 - beta1) * gradient,
+// variance = beta2 * variance + (1 - beta2) * gradient^2,
+// weights += stepSize * mean / (sqrt(variance) + epsilon); bias
+// correction is expected to be folded in stepSize and epsilon
+void MLOptimizeAdam(MLReal * _Nonnull weights, MLReal * _Nonnull gradient, MLReal * _Nonnull mean, MLReal * _Nonnull variance, NSUInteger size, MLReal stepSize, MLReal beta1, MLReal beta2, MLReal epsilon);
+
+// RPROP: the step of each weight grows by 1.2 while the sign of its
+// gradient is kept, and shrinks by 0.5 when it changes; on a sign change
+// the previous weight change is reverted (backtracking, RPROP+) or
+// skipped (iRPROP-, previousChange is not used and may be NULL)
+void MLOptimizeResilient(MLReal * _Nonnull weightsDelta, const MLReal * _Nonnull gradient, MLReal * _Nonnull steps, MLReal * _Nonnull previousGradient, MLReal * _Nullable previousChange, NSUInteger size, BOOL backtracking);
+
+// RPROP on the gradient of a single sample, computed on the fly as the
+// outer product of delta and input: gradient[i][j] = delta[i] * input[j]
+void MLOptimizeResilientOuter(MLReal * _Nonnull weightsDelta, const MLReal * _Nonnull delta, const MLReal * _Nonnull input, MLReal * _Nonnull steps, MLReal * _Nonnull previousGradient, MLReal * _Nullable previousChange, NSUInteger rows, NSUInteger columns, BOOL backtracking);
@@ -0,0 +1,171 @@
+//
+//  MLOptimizerKernels.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLOptimizerKernels.h"
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __zero=                0.0;
+static const MLReal __one=                 1.0;
+
+static const MLReal __stepAcceleration=    1.2;
+static const MLReal __stepDeceleration=    0.5;
+static const MLReal __stepMin=             0.000001;
+static const MLReal __stepMax=             1.0;
+
+
+#pragma mark -
+#pragma mark Static functions
+
+// RPROP step of a single weight, plain scalar code called
+// by the single pass of the kernels below
+static inline MLReal MLResilientChange(MLReal gradient, MLReal *step, MLReal *previousGradient, MLReal previousChange, BOOL backtracking) {
+    MLReal product= gradient * (*previousGradient);
+    
+    // Apply formula: step = clip(step * factor, min, max), where factor is
+    // 1.2 if gradient kept its sign, 0.5 if changed, 1 otherwise
+    MLReal factor= (product > __zero) ? __stepAcceleration : ((product < __zero) ? __stepDeceleration : __one);
+    MLReal s= (*step) * factor;
+    s= (s < __stepMin) ? __stepMin : ((s > __stepMax) ? __stepMax : s);
+    
+    MLReal sign= (gradient > __zero) ? __one : ((gradient < __zero) ? -__one : __zero);
+    
+    // On a sign change the gradient is forgotten, so that the
+    // step is not decreased again on the next iteration
+    *step= s;
+    *previousGradient= (product < __zero) ? __zero : gradient;
+    
+    return (product < __zero) ? (backtracking ? -previousChange : __zero) : (s * sign);
+}
+
+
+#pragma mark -
+#pragma mark Optimizer kernels
+
+void MLOptimizeMomentum(MLReal *weights, MLReal *gradient, MLReal *velocity, NSUInteger size, MLReal learningRate, MLReal momentum, BOOL nesterov) {
+    if (nesterov) {
+        
+        // Apply formula: weights[i] += momentum * velocity[i] + learningRate * gradient[i],
+        // with velocity[i] already updated
+        for (NSUInteger i= 0; i < size; i++) {
+            MLReal step= learningRate * gradient[i];
+            MLReal v= momentum * velocity[i] + step;
+            
+            velocity[i]= v;
+            weights[i] += momentum * v + step;
+            gradient[i]= __zero;
+        }
+        
+        return;
+    }
+    
+    // Apply formula: weights[i] += velocity[i], with velocity[i] already updated
+    for (NSUInteger i= 0; i < size; i++) {
+        MLReal v= momentum * velocity[i] + learningRate * gradient[i];
+        
+        velocity[i]= v;
+        weights[i] += v;
+        gradient[i]= __zero;
+    }
+}
+
+void MLOptimizeRMSProp(MLReal *weights, MLReal *gradient, MLReal *meanSquare, NSUInteger size, MLReal learningRate, MLReal decayRate, MLReal epsilon) {
+    MLReal complement= __one - decayRate;
+    
+    // Apply formula: weights[i] += learningRate * gradient[i] / (sqrt(meanSquare[i]) + epsilon),
+    // with meanSquare[i] already updated
+    for (NSUInteger i= 0; i < size; i++) {
+        MLReal g= gradient[i];
+        MLReal s= decayRate * meanSquare[i] + complement * g * g;
+        
+        meanSquare[i]= s;
+        weights[i] += learningRate * g / (ML_SQRT(s) + epsilon);
+        gradient[i]= __zero;
+    }
+}
+
+void MLOptimizeAdam(MLReal *weights, MLReal *gradient, MLReal *mean, MLReal *variance, NSUInteger size, MLReal stepSize, MLReal beta1, MLReal beta2, MLReal epsilon) {
+    MLReal complement1= __one - beta1;
+    MLReal complement2= __one - beta2;
+    
+    // Apply formula: weights[i] += stepSize * mean[i] / (sqrt(variance[i]) + epsilon),
+    // with mean[i] and variance[i] already updated
+    for (NSUInteger i= 0; i < size; i++) {
+        MLReal g= gradient[i];
+        MLReal m= beta1 * mean[i] + complement1 * g;
+        MLReal v= beta2 * variance[i] + complement2 * g * g;
+        
+        mean[i]= m;
+        variance[i]= v;
+        weights[i] += stepSize * m / (ML_SQRT(v) + epsilon);
+        gradient[i]= __zero;
+    }
+}
+
+void MLOptimizeResilient(MLReal *weightsDelta, const MLReal *gradient, MLReal *steps, MLReal *previousGradient, MLReal *previousChange, NSUInteger size, BOOL backtracking) {
+    if (backtracking) {
+        for (NSUInteger i= 0; i < size; i++) {
+            MLReal change= MLResilientChange(gradient[i], &steps[i], &previousGradient[i], previousChange[i], YES);
+            
+            previousChange[i]= change;
+            weightsDelta[i] += change;
+        }
+        
+        return;
+    }
+    
+    for (NSUInteger i= 0; i < size; i++)
+        weightsDelta[i] += MLResilientChange(gradient[i], &steps[i], &previousGradient[i], __zero, NO);
+}
+
+void MLOptimizeResilientOuter(MLReal *weightsDelta, const MLReal *delta, const MLReal *input, MLReal *steps, MLReal *previousGradient, MLReal *previousChange, NSUInteger rows, NSUInteger columns, BOOL backtracking) {
+    for (NSUInteger i= 0; i < rows; i++) {
+        MLReal d= delta[i];
+        NSUInteger offset= i * columns;
+        
+        if (backtracking) {
+            for (NSUInteger j= 0; j < columns; j++) {
+                MLReal change= MLResilientChange(d * input[j], &steps[offset + j], &previousGradient[offset + j], previousChange[offset + j], YES);
+                
+                previousChange[offset + j]= change;
+                weightsDelta[offset + j] += change;
+            }
+            
+        } else {
+            for (NSUInteger j= 0; j < columns; j++)
+                weightsDelta[offset + j] += MLResilientChange(d * input[j], &steps[offset + j], &previousGradient[offset + j], __zero, NO);
+        }
+    }
+}
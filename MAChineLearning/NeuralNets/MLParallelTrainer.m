@@ -0,0 +1,336 @@
+//
+//  MLParallelTrainer.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLParallelTrainer.h"
+#import "MLNeuralNetwork.h"
+#import "MLNeuronLayer.h"
+#import "MLNeuralNetworkException.h"
+
+#import "MLAlloc.h"
+
+
+#pragma mark -
+#pragma mark ParallelTrainer extension
+
+@interface MLParallelTrainer () {
+    MLNeuralNetwork *_network;
+    NSArray<MLNeuralNetwork *> *_replicas;
+    
+    NSUInteger _workers;
+    NSUInteger _batchSize;
+    NSUInteger _shardSize;
+    BOOL _hogwild;
+    
+    MLReal *_batchInputBuffer;
+    MLReal *_batchExpectedOutputBuffer;
+    
+    MLReal *_workerCosts;
+    MLReal _batchCost;
+    
+    int *_sparseIndices;
+    MLReal *_sparseValues;
+    
+    dispatch_queue_t _queue;
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (void) trainShardOfWorker:(NSUInteger)worker size:(NSUInteger)size learningRate:(MLReal)learningRate;
+- (void) reduceAndUpdateWeights;
+
+
+@end
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __one= 1.0;
+
+
+#pragma mark -
+#pragma mark ParallelTrainer implementation
+
+@implementation MLParallelTrainer
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (instancetype) init {
+    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"MLParallelTrainer class must be initialized properly"
+                                                             userInfo:nil];
+}
+
+- (instancetype) initWithNetwork:(MLNeuralNetwork *)network workers:(NSUInteger)workers batchSize:(NSUInteger)batchSize {
+    return [self initWithNetwork:network workers:workers batchSize:batchSize hogwild:NO];
+}
+
+- (instancetype) initWithNetwork:(MLNeuralNetwork *)network workers:(NSUInteger)workers batchSize:(NSUInteger)batchSize hogwild:(BOOL)hogwild {
+    if ((self = [super init])) {
+        
+        // Checks
+        if (network.backPropType != MLBackPropagationTypeStandard)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Parallel training is supported only for standard backpropagation"
+                                                                     userInfo:@{@"backPropType": @(network.backPropType)}];
+        
+        if (network.readOnly)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't train a network with read-only weights"
+                                                                     userInfo:nil];
+        
+        if ((workers == 0) || (batchSize < workers))
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid number of workers: must be positive and not greater than the batch size"
+                                                                     userInfo:@{@"workers": @(workers),
+                                                                                @"batchSize": @(batchSize)}];
+        
+        // Initialization
+        _network= network;
+        _workers= workers;
+        _batchSize= batchSize;
+        _hogwild= hogwild;
+        
+        // Each worker trains a contiguous shard of the batch
+        _shardSize= (batchSize + workers -1) / workers;
+        
+        _batchInputBuffer= MLAllocRealBuffer(batchSize * network.inputSize);
+        _batchExpectedOutputBuffer= MLAllocRealBuffer(batchSize * network.outputSize);
+        _workerCosts= MLAllocRealBuffer(workers);
+        
+        ML_VCLR(_batchInputBuffer, 1, batchSize * network.inputSize);
+        ML_VCLR(_batchExpectedOutputBuffer, 1, batchSize * network.outputSize);
+        ML_VCLR(_workerCosts, 1, workers);
+        
+        // Hogwild workers feed nonzero inputs only, each
+        // gathers them in its own row of these buffers
+        if (hogwild) {
+            _sparseIndices= MLAllocIntBuffer(workers * network.inputSize);
+            _sparseValues= MLAllocRealBuffer(workers * network.inputSize);
+        }
+        
+        // Create the replicas: they share the weights of the network,
+        // while activations and weights delta are private to each of them
+        NSDictionary<NSString *, id> *config= [network saveConfigurationToDictionary];
+        NSMutableArray<MLNeuralNetwork *> *replicas= [[NSMutableArray alloc] initWithCapacity:workers];
+        
+        for (NSUInteger i= 0; i < workers; i++) {
+            MLNeuralNetwork *replica= [MLNeuralNetwork createNetworkFromConfigurationDictionary:config];
+            replica.fastApproximateActivation= network.fastApproximateActivation;
+            
+            for (NSUInteger j= 1; j < network.layers.count; j++) {
+                MLNeuronLayer *layer= (MLNeuronLayer *) replica.layers[j];
+                
+                [layer shareWeightsOfLayer:(MLNeuronLayer *) network.layers[j]];
+            }
+            
+            if (!hogwild)
+                [replica setUpBatchOfSize:_shardSize];
+            
+            [replicas addObject:replica];
+        }
+        
+        _replicas= [NSArray arrayWithArray:replicas];
+        
+        _queue= dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    }
+    
+    return self;
+}
+
+- (void) dealloc {
+    MLFreeRealBuffer(_batchInputBuffer);
+    _batchInputBuffer= NULL;
+    
+    MLFreeRealBuffer(_batchExpectedOutputBuffer);
+    _batchExpectedOutputBuffer= NULL;
+    
+    MLFreeRealBuffer(_workerCosts);
+    _workerCosts= NULL;
+    
+    MLFreeIntBuffer(_sparseIndices);
+    _sparseIndices= NULL;
+    
+    MLFreeRealBuffer(_sparseValues);
+    _sparseValues= NULL;
+}
+
+
+#pragma mark -
+#pragma mark Training
+
+- (void) trainBatchOfSize:(NSUInteger)size learningRate:(MLReal)learningRate {
+    
+    // Checks
+    if ((size == 0) || (size > _batchSize))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid size: must be positive and not greater than the batch size"
+                                                                 userInfo:@{@"size": @(size),
+                                                                            @"batchSize": @(_batchSize)}];
+    
+    if (learningRate <= 0.0)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid learning rate: standard backpropagation requires a positive learning rate"
+                                                                 userInfo:@{@"learningRate": @(learningRate)}];
+    
+    // First step: each worker trains its shard concurrently
+    dispatch_apply(_workers, _queue, ^(size_t worker) {
+        [self trainShardOfWorker:worker size:size learningRate:learningRate];
+    });
+    
+    // Second step: sum the weights delta of each worker and update
+    // the weights, with Hogwild workers have already done it
+    if (!_hogwild)
+        [self reduceAndUpdateWeights];
+    
+    // Sum costs in worker order, so that the result is deterministic
+    _batchCost= 0.0;
+    for (NSUInteger i= 0; i < _workers; i++)
+        _batchCost += _workerCosts[i];
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (void) trainShardOfWorker:(NSUInteger)worker size:(NSUInteger)size learningRate:(MLReal)learningRate {
+    NSUInteger first= worker * _shardSize;
+    if (first >= size) {
+        _workerCosts[worker]= 0.0;
+        return;
+    }
+    
+    NSUInteger count= MIN(_shardSize, size - first);
+    
+    MLNeuralNetwork *replica= _replicas[worker];
+    NSUInteger inputSize= replica.inputSize;
+    NSUInteger outputSize= replica.outputSize;
+    
+    if (_hogwild) {
+        MLReal cost= 0.0;
+        
+        int *indices= &_sparseIndices[worker * inputSize];
+        MLReal *values= &_sparseValues[worker * inputSize];
+        
+        // Train sample by sample, updating the shared weights
+        // with no locking (see Hogwild! by Niu et al., 2011)
+        for (NSUInteger i= first; i < first + count; i++) {
+            const MLReal *input= &_batchInputBuffer[i * inputSize];
+            
+            // Gather nonzero inputs: the first layer then computes and
+            // updates only their columns, so that workers on sparse
+            // samples seldom write the same weights
+            NSUInteger nonzeros= 0;
+            for (NSUInteger j= 0; j < inputSize; j++) {
+                if (input[j] != 0.0) {
+                    indices[nonzeros]= (int) j;
+                    values[nonzeros]= input[j];
+                    nonzeros++;
+                }
+            }
+            
+            ML_VSMUL(&_batchExpectedOutputBuffer[i * outputSize], 1, &__one, replica.expectedOutputBuffer, 1, outputSize);
+            
+            [replica feedForwardSparseInputWithIndices:indices values:values size:nonzeros];
+            
+            cost += replica.cost;
+            
+            [replica backPropagateWithLearningRate:learningRate];
+            [replica updateWeights];
+        }
+        
+        _workerCosts[worker]= cost;
+        
+    } else {
+        
+        // Copy the shard in the replica batch buffers
+        ML_VSMUL(&_batchInputBuffer[first * inputSize], 1, &__one, replica.batchInputBuffer, 1, count * inputSize);
+        ML_VSMUL(&_batchExpectedOutputBuffer[first * outputSize], 1, &__one, replica.batchExpectedOutputBuffer, 1, count * outputSize);
+        
+        // Accumulate the weights delta of the shard,
+        // weights are left untouched until reduction
+        [replica feedForwardBatchOfSize:count];
+        
+        _workerCosts[worker]= replica.batchCost;
+        
+        [replica backPropagateBatchWithLearningRate:learningRate];
+    }
+}
+
+- (void) reduceAndUpdateWeights {
+    NSArray<MLLayer *> *layers= _network.layers;
+    
+    for (NSUInteger i= 1; i < layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) layers[i];
+        MLReal *weightsDelta= layer.weightsDelta;
+        
+        NSUInteger total= layer.size * layer.previousLayer.size;
+        NSUInteger chunkSize= (total + _workers -1) / _workers;
+        
+        // The weights delta matrix is split in chunks reduced concurrently,
+        // each chunk sums the workers in order, so that the result does not
+        // depend on thread scheduling
+        dispatch_apply(_workers, _queue, ^(size_t chunk) {
+            NSUInteger offset= chunk * chunkSize;
+            if (offset >= total)
+                return;
+            
+            NSUInteger length= MIN(chunkSize, total - offset);
+            
+            for (MLNeuralNetwork *replica in _replicas) {
+                MLReal *replicaWeightsDelta= ((MLNeuronLayer *) replica.layers[i]).weightsDelta;
+                
+                ML_VADD(&replicaWeightsDelta[offset], 1, &weightsDelta[offset], 1, &weightsDelta[offset], 1, length);
+                ML_VCLR(&replicaWeightsDelta[offset], 1, length);
+            }
+        });
+        
+        // Apply the summed weights delta
+        [layer updateWeights];
+    }
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+@synthesize network= _network;
+
+@synthesize workers= _workers;
+@synthesize batchSize= _batchSize;
+@synthesize hogwild= _hogwild;
+
+@synthesize batchInputBuffer= _batchInputBuffer;
+@synthesize batchExpectedOutputBuffer= _batchExpectedOutputBuffer;
+@synthesize batchCost= _batchCost;
+
+
+@end
@@ -0,0 +1,168 @@
+//
+//  MLProfileCounters.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MAChineLearning_MLProfileCounters_h
+#define MAChineLearning_MLProfileCounters_h
+
+#import <Foundation/Foundation.h>
+
+#import "MLProfilePhase.h"
+#import "MLNeuralNetworkProfile.h"
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else // __APPLE__
+#include <time.h>
+#endif // __APPLE__
+
+
+#pragma mark -
+#pragma mark Counter structures
+
+typedef struct {
+    uint64_t calls;
+    uint64_t time;
+    uint64_t flops;
+    uint64_t bytes;
+} MLProfileCounter;
+
+typedef struct {
+    uint64_t start;
+    uint64_t duration;
+    uint32_t layer;
+    uint32_t phase;
+    uint32_t thread;
+} MLProfileEvent;
+
+typedef struct {
+    NSUInteger layers;
+    MLProfileCounter *counters;
+    
+    uint64_t origin;
+    NSUInteger maxEvents;
+    NSUInteger eventCount;
+    MLProfileEvent *events;
+} MLProfileState;
+
+
+#pragma mark -
+#pragma mark Recording
+
+// Small sequential index of the calling thread, for trace lanes
+uint32_t MLProfileThreadIndex(void);
+
+// Monotonic time in nanoseconds
+static inline uint64_t MLProfileNow(void) {
+#ifdef __APPLE__
+    
+    // Mach time is used, as clock_gettime is missing before macOS 10.12 and iOS 10
+    static mach_timebase_info_data_t timebase= { 0, 0 };
+    if (timebase.denom == 0)
+        mach_timebase_info(&timebase);
+    
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else // __APPLE__
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return ((uint64_t) now.tv_sec) * 1000000000ULL + (uint64_t) now.tv_nsec;
+#endif // __APPLE__
+}
+
+// Counters are updated atomically, as contexts may feed forward
+// the same layers concurrently; events past the limit are dropped
+static inline void MLProfileRecord(MLProfileState * _Nonnull state, NSUInteger layer, MLProfilePhase phase, uint64_t start, uint64_t flops, uint64_t bytes) {
+    uint64_t duration= MLProfileNow() - start;
+    MLProfileCounter *counter= &state->counters[layer * ML_PROFILE_PHASES + phase];
+    
+    __atomic_fetch_add(&counter->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counter->time, duration, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counter->flops, flops, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counter->bytes, bytes, __ATOMIC_RELAXED);
+    
+    if (state->maxEvents == 0)
+        return;
+    
+    NSUInteger index= __atomic_fetch_add(&state->eventCount, 1, __ATOMIC_RELAXED);
+    if (index >= state->maxEvents)
+        return;
+    
+    MLProfileEvent *event= &state->events[index];
+    event->start= start - state->origin;
+    event->duration= duration;
+    event->layer= (uint32_t) layer;
+    event->phase= (uint32_t) phase;
+    event->thread= MLProfileThreadIndex();
+}
+
+
+#pragma mark -
+#pragma mark Instrumentation macros
+
+// With ML_DISABLE_PROFILING defined the macros expand to nothing,
+// otherwise they cost a single branch when profiling is disabled.
+// The state is read once by ML_PROFILE_BEGIN, so that a profile
+// set or removed in between can't unbalance the pair: the state
+// argument of ML_PROFILE_END is kept for symmetry only
+#ifndef ML_DISABLE_PROFILING
+
+#define ML_PROFILE_BEGIN(state, phase) \
+    MLProfileState *__profileState##phase= (state); \
+    uint64_t __profileStart##phase= __profileState##phase ? MLProfileNow() : 0
+
+#define ML_PROFILE_END(state, layer, phase, flops, bytes) \
+    do { \
+        if (__profileState##phase) MLProfileRecord(__profileState##phase, layer, phase, __profileStart##phase, flops, bytes); \
+    } while (0)
+
+#else // ML_DISABLE_PROFILING
+
+#define ML_PROFILE_BEGIN(state, phase)
+#define ML_PROFILE_END(state, layer, phase, flops, bytes)
+
+#endif // ML_DISABLE_PROFILING
+
+
+#pragma mark -
+#pragma mark Profile internals
+
+@interface MLNeuralNetworkProfile (Counters)
+
+
+@property (nonatomic, readonly, nonnull) MLProfileState *state;
+
+
+@end
+
+
+#endif
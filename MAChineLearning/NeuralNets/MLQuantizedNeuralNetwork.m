@@ -0,0 +1,356 @@
+//
+//  MLQuantizedNeuralNetwork.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLQuantizedNeuralNetwork.h"
+#import "MLNeuralNetwork.h"
+#import "MLNeuralNetworkContext.h"
+#import "MLNeuronLayer.h"
+#import "MLNeuralNetworkException.h"
+
+#import "MLAlloc.h"
+#import "MLActivationKernels.h"
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#import <arm_neon.h>
+#endif
+
+#define QUANTIZATION_RANGE                 (127.0)
+
+
+#pragma mark -
+#pragma mark Quantized layer
+
+// A quantized neuron layer: weights of each row are stored as 8-bit
+// ints with their own scale, while the bias column (if any) is kept
+// in full precision, as its input is not part of the quantized vector
+typedef struct {
+    NSUInteger size;
+    NSUInteger rows;
+    NSUInteger inputSize;
+    BOOL inputUsingBias;
+    BOOL usingBias;
+    MLActivationFunctionType funcType;
+    
+    int8_t *weights;
+    MLReal *weightScales;
+    MLReal *biasWeights;
+    
+    MLReal *outputBuffer;
+} MLQuantizedLayer;
+
+
+#pragma mark -
+#pragma mark QuantizedNeuralNetwork extension
+
+@interface MLQuantizedNeuralNetwork () {
+    NSUInteger _layerCount;
+    MLQuantizedLayer *_layers;
+    
+    NSUInteger _inputSize;
+    MLReal *_inputBuffer;
+    
+    NSUInteger _outputSize;
+    MLReal *_outputBuffer;
+    
+    int8_t *_quantizedInputBuffer;
+    
+    NSUInteger _weightsMemorySize;
+    BOOL _fastApproximateActivation;
+}
+
+
+@end
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __zero=          0.0;
+static const MLReal __half=          0.5;
+static const MLReal __one=           1.0;
+
+
+#pragma mark -
+#pragma mark Kernels
+
+static inline MLReal MLQuantize(const MLReal *buffer, int8_t *quantized, NSUInteger size) {
+    
+    // Symmetric quantization: the largest magnitude maps to 127,
+    // the scale is returned to convert back to reals
+    MLReal max= __zero;
+    ML_VMAXMGV(buffer, 1, &max, size);
+    
+    MLReal scale= (max > __zero) ? (max / QUANTIZATION_RANGE) : __one;
+    MLReal invScale= __one / scale;
+    
+    for (NSUInteger i= 0; i < size; i++) {
+        MLReal value= buffer[i] * invScale;
+        quantized[i]= (int8_t) (value + ((value < __zero) ? -__half : __half));
+    }
+    
+    return scale;
+}
+
+static inline int32_t MLDotInt8(const int8_t *a, const int8_t *b, NSUInteger size) {
+    int32_t dot= 0;
+    NSUInteger i= 0;
+    
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    
+    // Products of 8-bit ints fit in 16 bits (range is limited to
+    // -127...127), adjacent pairs are then accumulated in 32 bits
+    int32x4_t acc= vdupq_n_s32(0);
+    
+    for (; i + 16 <= size; i += 16) {
+        int8x16_t va= vld1q_s8(&a[i]);
+        int8x16_t vb= vld1q_s8(&b[i]);
+        
+        acc= vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        acc= vpadalq_s16(acc, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+    }
+    
+    dot= vaddvq_s32(acc);
+#endif
+    
+    // Remainder, or the whole vector on other architectures:
+    // the compiler vectorizes this loop with 16-bit multiply-adds
+    for (; i < size; i++)
+        dot += ((int32_t) a[i]) * ((int32_t) b[i]);
+    
+    return dot;
+}
+
+
+#pragma mark -
+#pragma mark QuantizedNeuralNetwork implementation
+
+@implementation MLQuantizedNeuralNetwork
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (instancetype) init {
+    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"MLQuantizedNeuralNetwork class must be initialized properly"
+                                                             userInfo:nil];
+}
+
+- (instancetype) initWithNetwork:(MLNeuralNetwork *)network {
+    
+    // Outputs of hierarchical softmax are computed along the tree
+    if (network.softmaxTrainingType == MLSoftmaxTrainingTypeHierarchical)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Quantized networks don't support hierarchical softmax"
+                                                                 userInfo:nil];
+    
+    if ((self = [super init])) {
+        
+        // Initialization
+        _layerCount= network.layers.count -1;
+        _layers= calloc(_layerCount, sizeof(MLQuantizedLayer));
+        if (!_layers)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Error while allocating quantized layers"
+                                                                     userInfo:nil];
+        
+        _inputSize= network.inputSize;
+        _outputSize= network.outputSize;
+        _fastApproximateActivation= network.fastApproximateActivation;
+        
+        _inputBuffer= MLAllocRealBuffer(_inputSize);
+        ML_VCLR(_inputBuffer, 1, _inputSize);
+        
+        NSUInteger maxInputSize= 0;
+        
+        for (NSUInteger i= 0; i < _layerCount; i++) {
+            MLNeuronLayer *neuronLayer= (MLNeuronLayer *) network.layers[i +1];
+            MLQuantizedLayer *layer= &_layers[i];
+            
+            BOOL inputUsingBias= ((i > 0) && _layers[i -1].usingBias);
+            NSUInteger fullInputSize= neuronLayer.previousLayer.size;
+            
+            layer->size= neuronLayer.size;
+            layer->usingBias= neuronLayer.usingBias;
+            layer->rows= layer->usingBias ? (layer->size -1) : layer->size;
+            layer->inputUsingBias= inputUsingBias;
+            layer->inputSize= inputUsingBias ? (fullInputSize -1) : fullInputSize;
+            layer->funcType= neuronLayer.funcType;
+            
+            // Quantize weights row by row, each with its own scale
+            layer->weights= MLAllocInt8Buffer(layer->rows * layer->inputSize);
+            layer->weightScales= MLAllocRealBuffer(layer->rows);
+            
+            for (NSUInteger j= 0; j < layer->rows; j++)
+                layer->weightScales[j]= MLQuantize(&neuronLayer.weights[j * fullInputSize],
+                                                   &layer->weights[j * layer->inputSize],
+                                                   layer->inputSize);
+            
+            _weightsMemorySize += (layer->rows * layer->inputSize * sizeof(int8_t)) + (layer->rows * sizeof(MLReal));
+            
+            if (inputUsingBias) {
+                
+                // Bias column is the last one of the matrix
+                layer->biasWeights= MLAllocRealBuffer(layer->rows);
+                
+                for (NSUInteger j= 0; j < layer->rows; j++)
+                    layer->biasWeights[j]= neuronLayer.weights[j * fullInputSize + fullInputSize -1];
+                
+                _weightsMemorySize += layer->rows * sizeof(MLReal);
+            }
+            
+            layer->outputBuffer= MLAllocRealBuffer(layer->size);
+            ML_VCLR(layer->outputBuffer, 1, layer->size);
+            
+            maxInputSize= MAX(maxInputSize, layer->inputSize);
+        }
+        
+        _outputBuffer= _layers[_layerCount -1].outputBuffer;
+        
+        // Inputs of all layers are quantized in the same buffer
+        _quantizedInputBuffer= MLAllocInt8Buffer(maxInputSize);
+    }
+    
+    return self;
+}
+
+- (void) dealloc {
+    
+    // Deallocate layers
+    for (NSUInteger i= 0; i < _layerCount; i++) {
+        MLFreeInt8Buffer(_layers[i].weights);
+        MLFreeRealBuffer(_layers[i].weightScales);
+        MLFreeRealBuffer(_layers[i].biasWeights);
+        MLFreeRealBuffer(_layers[i].outputBuffer);
+    }
+    
+    free(_layers);
+    _layers= NULL;
+    
+    // Deallocate buffers
+    MLFreeRealBuffer(_inputBuffer);
+    _inputBuffer= NULL;
+    
+    MLFreeInt8Buffer(_quantizedInputBuffer);
+    _quantizedInputBuffer= NULL;
+    
+    _outputBuffer= NULL;
+}
+
+
+#pragma mark -
+#pragma mark Operations
+
+- (void) feedForward {
+    MLReal *inputBuffer= _inputBuffer;
+    
+    for (NSUInteger i= 0; i < _layerCount; i++) {
+        MLQuantizedLayer *layer= &_layers[i];
+        
+        // First step: quantize the input, with a scale
+        // computed on the fly for each input vector
+        MLReal inputScale= MLQuantize(inputBuffer, _quantizedInputBuffer, layer->inputSize);
+        
+        // Second step: compute the dot products with 32-bit int
+        // accumulation and convert them back to reals
+        for (NSUInteger j= 0; j < layer->rows; j++) {
+            int32_t dot= MLDotInt8(&layer->weights[j * layer->inputSize], _quantizedInputBuffer, layer->inputSize);
+            
+            layer->outputBuffer[j]= ((MLReal) dot) * layer->weightScales[j] * inputScale;
+        }
+        
+        // Bias input is applied in full precision
+        if (layer->inputUsingBias) {
+            MLReal biasInput= inputBuffer[layer->inputSize];
+            
+            ML_VSMA(layer->biasWeights, 1, &biasInput, layer->outputBuffer, 1, layer->outputBuffer, 1, layer->rows);
+        }
+        
+        // Bias neurons have constant output, it is set
+        // before activation as in the original network
+        if (layer->usingBias)
+            layer->outputBuffer[layer->size -1]= __one;
+        
+        // Third step: apply activation function
+        MLActivate(layer->funcType, layer->outputBuffer, layer->size, _fastApproximateActivation);
+        
+        inputBuffer= layer->outputBuffer;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Accuracy
+
+- (MLReal) outputDriftFromNetwork:(MLNeuralNetwork *)network inputBuffer:(MLReal *)inputBuffer samples:(NSUInteger)samples {
+    
+    // Checks
+    if ((network.inputSize != _inputSize) || (network.outputSize != _outputSize))
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Network sizes differ from the quantized network"
+                                                                 userInfo:@{@"inputSize": @(network.inputSize),
+                                                                            @"outputSize": @(network.outputSize)}];
+    
+    // Use a context so that the network is not modified
+    MLNeuralNetworkContext *context= [[MLNeuralNetworkContext alloc] initWithNetwork:network];
+    
+    MLReal drift= __zero;
+    for (NSUInteger i= 0; i < samples; i++) {
+        ML_VSMUL(&inputBuffer[i * _inputSize], 1, &__one, context.inputBuffer, 1, _inputSize);
+        ML_VSMUL(&inputBuffer[i * _inputSize], 1, &__one, _inputBuffer, 1, _inputSize);
+        
+        [context feedForward];
+        [self feedForward];
+        
+        // Drift is the largest absolute difference of outputs
+        for (NSUInteger j= 0; j < _outputSize; j++) {
+            MLReal diff= _outputBuffer[j] - context.outputBuffer[j];
+            
+            drift= MAX(drift, (diff < __zero) ? -diff : diff);
+        }
+    }
+    
+    return drift;
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+@synthesize inputSize= _inputSize;
+@synthesize inputBuffer= _inputBuffer;
+
+@synthesize outputSize= _outputSize;
+@synthesize outputBuffer= _outputBuffer;
+
+@synthesize weightsMemorySize= _weightsMemorySize;
+@synthesize fastApproximateActivation= _fastApproximateActivation;
+
+
+@end
@@ -0,0 +1,74 @@
+//
+//  MLSoftmaxKernels.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+
+
+// Alias tables (Vose's method) to draw classes in constant time, with
+// probability proportional to weights: a class i drawn uniformly is kept
+// with probability probabilities[i], otherwise aliases[i] is taken;
+// workspace must hold 2 x size ints
+void MLBuildAliasTable(const MLReal * _Nonnull weights, NSUInteger size, MLReal * _Nonnull probabilities, int * _Nonnull aliases, int * _Nonnull workspace);
+
+// Huffman tree of size classes (at least 2) with the specified counts:
+// inner node n (root is size -2) has children[2n] on code 0 and
+// children[2n +1] on code 1, each a class index if below size, or
+// size + m for inner node m; parents (2 x size -1 ints, by the same
+// index) hold (m << 1 | code) of the parent, -1 for the root; returns
+// the sum of the depths of all classes, i.e. the length of all paths
+NSUInteger MLBuildHuffmanTree(const MLReal * _Nonnull counts, NSUInteger size, int * _Nonnull children, int * _Nonnull parents);
+
+// Paths from the root to each class: inner nodes of class c are
+// pathNodes[pathOffsets[c]] ... pathNodes[pathOffsets[c +1] -1], with
+// the code taken at each of them in pathCodes
+void MLBuildHuffmanPaths(const int * _Nonnull parents, NSUInteger size, int * _Nonnull pathOffsets, int * _Nonnull pathNodes, int * _Nonnull pathCodes);
+
+// Probabilities of all classes from the sigmoid outputs of inner nodes,
+// which give the probability of code 1; nodeProbabilities must hold
+// size -1 reals
+void MLHierarchicalProbabilities(const MLReal * _Nonnull nodeOutputs, const int * _Nonnull children, NSUInteger size, MLReal * _Nonnull nodeProbabilities, MLReal * _Nonnull probabilities);
+
+// Exact k most probable classes of the tree, sorted by decreasing
+// probability, with a best-first search: probabilities only decrease
+// along a path, so leaves are reached in order and only the inner nodes
+// above them are computed, each with a dot product of its row of
+// weights with input; heapValues and heapNodes must hold size entries;
+// returns the number of classes found
+NSUInteger MLHierarchicalTopClasses(const MLReal * _Nonnull weights, const MLReal * _Nonnull input, NSUInteger inputSize, const int * _Nonnull children, NSUInteger size, NSUInteger k, int * _Nonnull indices, MLReal * _Nullable probabilities, MLReal * _Nonnull heapValues, int * _Nonnull heapNodes);
+
+// Indices of the k largest values, sorted by decreasing value, with a
+// min-heap of k entries kept in indices and topValues; returns the
+// number of indices found
+NSUInteger MLSelectTopValues(const MLReal * _Nonnull values, NSUInteger size, NSUInteger k, int * _Nonnull indices, MLReal * _Nonnull topValues);
@@ -0,0 +1,363 @@
+//
+//  MLSoftmaxKernels.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLSoftmaxKernels.h"
+#import "MLAlloc.h"
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __minusFourty= -40.0;
+static const MLReal __zero=          0.0;
+static const MLReal __one=           1.0;
+static const MLReal __fourty=       40.0;
+
+
+#pragma mark -
+#pragma mark Static functions
+
+typedef struct {
+    MLReal count;
+    int index;
+} MLHuffmanLeaf;
+
+static int MLCompareLeaves(const void *a, const void *b) {
+    const MLHuffmanLeaf *x= (const MLHuffmanLeaf *) a;
+    const MLHuffmanLeaf *y= (const MLHuffmanLeaf *) b;
+    
+    // Ties are broken by index, so the tree doesn't depend on qsort
+    if (x->count != y->count)
+        return (x->count < y->count) ? -1 : 1;
+    
+    return (x->index < y->index) ? -1 : ((x->index > y->index) ? 1 : 0);
+}
+
+static inline MLReal MLSigmoid(MLReal x) {
+    
+    // Clipping avoids overflows of exp
+    x= (x < __minusFourty) ? __minusFourty : ((x > __fourty) ? __fourty : x);
+    
+    return __one / (__one + ML_EXP(-x));
+}
+
+static inline void MLSwapEntries(MLReal *values, int *indices, NSUInteger i, NSUInteger j) {
+    MLReal value= values[i];
+    values[i]= values[j];
+    values[j]= value;
+    
+    int index= indices[i];
+    indices[i]= indices[j];
+    indices[j]= index;
+}
+
+static void MLSiftDown(MLReal *values, int *indices, NSUInteger size, NSUInteger i, BOOL maxHeap) {
+    for (;;) {
+        NSUInteger left= 2 * i + 1;
+        NSUInteger right= left + 1;
+        NSUInteger top= i;
+        
+        if ((left < size) && (maxHeap ? (values[left] > values[top]) : (values[left] < values[top])))
+            top= left;
+        
+        if ((right < size) && (maxHeap ? (values[right] > values[top]) : (values[right] < values[top])))
+            top= right;
+        
+        if (top == i)
+            break;
+        
+        MLSwapEntries(values, indices, i, top);
+        i= top;
+    }
+}
+
+static void MLSiftUp(MLReal *values, int *indices, NSUInteger i, BOOL maxHeap) {
+    while (i > 0) {
+        NSUInteger parent= (i - 1) / 2;
+        
+        if (maxHeap ? (values[parent] >= values[i]) : (values[parent] <= values[i]))
+            break;
+        
+        MLSwapEntries(values, indices, i, parent);
+        i= parent;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Sampling kernels
+
+void MLBuildAliasTable(const MLReal *weights, NSUInteger size, MLReal *probabilities, int *aliases, int *workspace) {
+    MLReal sum= __zero;
+    for (NSUInteger i= 0; i < size; i++)
+        sum += weights[i];
+    
+    // Scale weights so that their mean is 1, then split classes
+    // in those below the mean (small) and above it (large)
+    int *small= workspace;
+    int *large= &workspace[size];
+    NSUInteger smallCount= 0, largeCount= 0;
+    
+    for (NSUInteger i= 0; i < size; i++) {
+        probabilities[i]= weights[i] * ((MLReal) size) / sum;
+        aliases[i]= (int) i;
+        
+        if (probabilities[i] < __one)
+            small[smallCount++]= (int) i;
+        else
+            large[largeCount++]= (int) i;
+    }
+    
+    // Each small class is filled up to the mean with a large one,
+    // which then gets smaller by the same amount
+    while ((smallCount > 0) && (largeCount > 0)) {
+        int s= small[--smallCount];
+        int l= large[largeCount -1];
+        
+        aliases[s]= l;
+        probabilities[l] -= __one - probabilities[s];
+        
+        if (probabilities[l] < __one) {
+            largeCount--;
+            small[smallCount++]= l;
+        }
+    }
+    
+    // Leftovers are at the mean, up to rounding errors
+    while (largeCount > 0)
+        probabilities[large[--largeCount]]= __one;
+    
+    while (smallCount > 0)
+        probabilities[small[--smallCount]]= __one;
+}
+
+
+#pragma mark -
+#pragma mark Hierarchical softmax kernels
+
+NSUInteger MLBuildHuffmanTree(const MLReal *counts, NSUInteger size, int *children, int *parents) {
+    
+    // Setup only: the workspace is allocated here
+    MLHuffmanLeaf *leaves= (MLHuffmanLeaf *) malloc(size * sizeof(MLHuffmanLeaf));
+    MLReal *nodeCounts= MLAllocRealBuffer(size -1);
+    int *depths= MLAllocIntBuffer(2 * size -1);
+    
+    for (NSUInteger i= 0; i < size; i++) {
+        leaves[i].count= counts[i];
+        leaves[i].index= (int) i;
+    }
+    
+    qsort(leaves, size, sizeof(MLHuffmanLeaf), MLCompareLeaves);
+    
+    // Two queues: sorted leaves, and inner nodes, which are created
+    // with nondecreasing counts; each step merges the two lowest
+    NSUInteger leaf= 0;
+    NSUInteger node= 0;
+    
+    for (NSUInteger n= 0; n < size -1; n++) {
+        for (int code= 0; code < 2; code++) {
+            int child= 0;
+            MLReal count= __zero;
+            
+            if ((leaf < size) && ((node >= n) || (leaves[leaf].count <= nodeCounts[node]))) {
+                child= leaves[leaf].index;
+                count= leaves[leaf].count;
+                leaf++;
+                
+            } else {
+                child= (int) (size + node);
+                count= nodeCounts[node];
+                node++;
+            }
+            
+            children[2 * n + code]= child;
+            parents[child]= (int) ((n << 1) | code);
+            nodeCounts[n]= (code == 0) ? count : (nodeCounts[n] + count);
+        }
+    }
+    
+    parents[2 * size -2]= -1;
+    
+    // Inner nodes are created after their children, hence
+    // depths can be computed going down from the root
+    NSUInteger totalLength= 0;
+    depths[2 * size -2]= 0;
+    
+    for (NSUInteger n= size -1; n > 0; n--) {
+        for (int code= 0; code < 2; code++) {
+            int child= children[2 * (n -1) + code];
+            depths[child]= depths[size + n -1] + 1;
+            
+            if (child < (int) size)
+                totalLength += depths[child];
+        }
+    }
+    
+    MLFreeIntBuffer(depths);
+    MLFreeRealBuffer(nodeCounts);
+    free(leaves);
+    
+    return totalLength;
+}
+
+void MLBuildHuffmanPaths(const int *parents, NSUInteger size, int *pathOffsets, int *pathNodes, int *pathCodes) {
+    NSUInteger offset= 0;
+    
+    for (NSUInteger c= 0; c < size; c++) {
+        pathOffsets[c]= (int) offset;
+        
+        // Count the inner nodes up to the root
+        NSUInteger length= 0;
+        for (int parent= parents[c]; parent >= 0; parent= parents[size + (parent >> 1)])
+            length++;
+        
+        // Then store them from the root down
+        NSUInteger i= offset + length;
+        for (int parent= parents[c]; parent >= 0; parent= parents[size + (parent >> 1)]) {
+            i--;
+            pathNodes[i]= parent >> 1;
+            pathCodes[i]= parent & 1;
+        }
+        
+        offset += length;
+    }
+    
+    pathOffsets[size]= (int) offset;
+}
+
+void MLHierarchicalProbabilities(const MLReal *nodeOutputs, const int *children, NSUInteger size, MLReal *nodeProbabilities, MLReal *probabilities) {
+    
+    // Children are created before their parent, going down from
+    // the root each node has its probability before its children
+    nodeProbabilities[size -2]= __one;
+    
+    for (NSUInteger n= size -1; n > 0; n--) {
+        MLReal probability= nodeProbabilities[n -1];
+        MLReal output= nodeOutputs[n -1];
+        
+        for (int code= 0; code < 2; code++) {
+            int child= children[2 * (n -1) + code];
+            MLReal childProbability= probability * ((code == 1) ? output : (__one - output));
+            
+            if (child < (int) size)
+                probabilities[child]= childProbability;
+            else
+                nodeProbabilities[child - size]= childProbability;
+        }
+    }
+}
+
+NSUInteger MLHierarchicalTopClasses(const MLReal *weights, const MLReal *input, NSUInteger inputSize, const int *children, NSUInteger size, NSUInteger k, int *indices, MLReal *probabilities, MLReal *heapValues, int *heapNodes) {
+    NSUInteger found= 0;
+    
+    // Max-heap of frontier nodes by probability, starting from the root;
+    // each expansion removes one node and adds two, so it never holds
+    // more than size nodes
+    NSUInteger heapSize= 1;
+    heapValues[0]= __one;
+    heapNodes[0]= (int) (2 * size -2);
+    
+    while ((found < k) && (heapSize > 0)) {
+        MLReal probability= heapValues[0];
+        int node= heapNodes[0];
+        
+        heapSize--;
+        MLSwapEntries(heapValues, heapNodes, 0, heapSize);
+        MLSiftDown(heapValues, heapNodes, heapSize, 0, YES);
+        
+        if (node < (int) size) {
+            
+            // No node left has a higher probability than this class
+            indices[found]= node;
+            if (probabilities)
+                probabilities[found]= probability;
+            
+            found++;
+            continue;
+        }
+        
+        // Expand the inner node
+        NSUInteger n= node - size;
+        
+        MLReal dot= __zero;
+        ML_DOTPR(&weights[n * inputSize], 1, input, 1, &dot, inputSize);
+        
+        MLReal output= MLSigmoid(dot);
+        
+        for (int code= 0; code < 2; code++) {
+            heapValues[heapSize]= probability * ((code == 1) ? output : (__one - output));
+            heapNodes[heapSize]= children[2 * n + code];
+            
+            MLSiftUp(heapValues, heapNodes, heapSize, YES);
+            heapSize++;
+        }
+    }
+    
+    return found;
+}
+
+
+#pragma mark -
+#pragma mark Selection kernels
+
+NSUInteger MLSelectTopValues(const MLReal *values, NSUInteger size, NSUInteger k, int *indices, MLReal *topValues) {
+    k= MIN(k, size);
+    if (k == 0)
+        return 0;
+    
+    // Min-heap of the k largest values seen so far
+    for (NSUInteger i= 0; i < k; i++) {
+        topValues[i]= values[i];
+        indices[i]= (int) i;
+        
+        MLSiftUp(topValues, indices, i, NO);
+    }
+    
+    for (NSUInteger i= k; i < size; i++) {
+        if (values[i] <= topValues[0])
+            continue;
+        
+        topValues[0]= values[i];
+        indices[0]= (int) i;
+        
+        MLSiftDown(topValues, indices, k, 0, NO);
+    }
+    
+    // Sort by decreasing value, moving the minimum to the end
+    for (NSUInteger i= k -1; i > 0; i--) {
+        MLSwapEntries(topValues, indices, 0, i);
+        MLSiftDown(topValues, indices, i, 0, NO);
+    }
+    
+    return k;
+}
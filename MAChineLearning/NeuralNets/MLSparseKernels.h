@@ -0,0 +1,49 @@
+//
+//  MLSparseKernels.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+
+
+// Matrix product with a sparse weights matrix in CSR format (row offsets,
+// column indices and values of nonzero weights): output[b][i] =
+// sum_k(values[k] * input[b][columns[k]]) for k in rowOffsets[i] ..
+// rowOffsets[i +1] -1, with input of batchSize x inputSize and output
+// rows spaced by outputStride, both row-major
+void MLSparseMatrixProduct(const int * _Nonnull rowOffsets, const int * _Nonnull columns, const MLReal * _Nonnull values, const MLReal * _Nonnull input, MLReal * _Nonnull output, NSUInteger batchSize, NSUInteger rows, NSUInteger inputSize, NSUInteger outputStride);
+
+// Sorts the magnitudes in place and returns the threshold that prunes
+// prunedCount of them, i.e. those strictly lower than the returned value;
+// prunedCount must be lower than size
+MLReal MLMagnitudeThreshold(MLReal * _Nonnull magnitudes, NSUInteger size, NSUInteger prunedCount);
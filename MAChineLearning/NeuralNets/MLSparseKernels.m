@@ -0,0 +1,95 @@
+//
+//  MLSparseKernels.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLSparseKernels.h"
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __zero= 0.0;
+
+
+#pragma mark -
+#pragma mark Static functions
+
+static int MLCompareReals(const void *a, const void *b) {
+    MLReal x= *((const MLReal *) a);
+    MLReal y= *((const MLReal *) b);
+    
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+
+#pragma mark -
+#pragma mark Matrix product kernel
+
+void MLSparseMatrixProduct(const int *rowOffsets, const int *columns, const MLReal *values, const MLReal *input, MLReal *output, NSUInteger batchSize, NSUInteger rows, NSUInteger inputSize, NSUInteger outputStride) {
+    for (NSUInteger b= 0; b < batchSize; b++) {
+        const MLReal *x= &input[b * inputSize];
+        MLReal *y= &output[b * outputStride];
+        
+        for (NSUInteger i= 0; i < rows; i++) {
+            int k= rowOffsets[i];
+            int end= rowOffsets[i +1];
+            
+            // Four independent sums, to hide the latency of gathers
+            MLReal sum0= __zero, sum1= __zero, sum2= __zero, sum3= __zero;
+            for (; k + 4 <= end; k += 4) {
+                sum0 += values[k] * x[columns[k]];
+                sum1 += values[k +1] * x[columns[k +1]];
+                sum2 += values[k +2] * x[columns[k +2]];
+                sum3 += values[k +3] * x[columns[k +3]];
+            }
+            
+            for (; k < end; k++)
+                sum0 += values[k] * x[columns[k]];
+            
+            y[i]= (sum0 + sum1) + (sum2 + sum3);
+        }
+    }
+}
+
+
+#pragma mark -
+#pragma mark Pruning support
+
+MLReal MLMagnitudeThreshold(MLReal *magnitudes, NSUInteger size, NSUInteger prunedCount) {
+    if (prunedCount == 0)
+        return __zero;
+    
+    qsort(magnitudes, size, sizeof(MLReal), MLCompareReals);
+    
+    // Ties with the threshold are kept, hence at most prunedCount are pruned
+    return magnitudes[prunedCount];
+}
@@ -0,0 +1,115 @@
+//
+//  MLTrainer.h
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "MLReal.h"
+
+
+@class MLNeuralNetwork;
+@class MLParallelTrainer;
+@class MLTrainer;
+
+
+#pragma mark -
+#pragma mark Data source protocol
+
+@protocol MLTrainerDataSource <NSObject>
+
+
+- (NSUInteger) numberOfSamplesForTrainer:(nonnull MLTrainer *)trainer;
+
+// Called on a background thread: must fill the buffers with the input
+// and the expected output of the sample at index, and must not touch
+// the network being trained
+- (void) trainer:(nonnull MLTrainer *)trainer
+ fillInputBuffer:(nonnull MLReal *)inputBuffer
+expectedOutputBuffer:(nonnull MLReal *)expectedOutputBuffer
+  forSampleAtIndex:(NSUInteger)index;
+
+
+@end
+
+
+#pragma mark -
+#pragma mark Callback types
+
+typedef void (^MLTrainerProgressHandler)(NSUInteger epoch, NSUInteger trainedSamples, MLReal cost, double samplesPerSecond, NSTimeInterval eta);
+typedef void (^MLTrainerEpochHandler)(NSUInteger epoch, MLReal cost);
+
+
+@interface MLTrainer : NSObject
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (nonnull instancetype) init NS_UNAVAILABLE;
+
+- (nonnull instancetype) initWithNetwork:(nonnull MLNeuralNetwork *)network
+                              dataSource:(nonnull id<MLTrainerDataSource>)dataSource
+                               batchSize:(NSUInteger)batchSize;
+
+- (nonnull instancetype) initWithParallelTrainer:(nonnull MLParallelTrainer *)parallelTrainer
+                                      dataSource:(nonnull id<MLTrainerDataSource>)dataSource;
+
+
+#pragma mark -
+#pragma mark Training
+
+- (NSUInteger) trainWithLearningRate:(MLReal)learningRate maxEpochs:(NSUInteger)maxEpochs;
+- (void) stop;
+
+
+#pragma mark -
+#pragma mark Properties
+
+@property (nonatomic, readonly, nonnull) MLNeuralNetwork *network;
+@property (nonatomic, readonly, nullable) MLParallelTrainer *parallelTrainer;
+@property (nonatomic, readonly, nonnull) id<MLTrainerDataSource> dataSource;
+
+@property (nonatomic, readonly) NSUInteger batchSize;
+
+@property (nonatomic, assign) BOOL shuffle;
+@property (nonatomic, assign) MLReal costLimit;
+@property (nonatomic, assign) MLReal gainCostLimit;
+
+@property (nonatomic, assign) NSUInteger progressInterval;
+@property (nonatomic, copy, nullable) MLTrainerProgressHandler progressHandler;
+@property (nonatomic, copy, nullable) MLTrainerEpochHandler epochHandler;
+
+@property (nonatomic, readonly) NSUInteger epochs;
+@property (nonatomic, readonly) MLReal lastCost;
+
+
+@end
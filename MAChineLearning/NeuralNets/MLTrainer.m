@@ -0,0 +1,431 @@
+//
+//  MLTrainer.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#import "MLTrainer.h"
+#import "MLNeuralNetwork.h"
+#import "MLParallelTrainer.h"
+#import "MLNeuralNetworkException.h"
+#import "MLRandom.h"
+
+#import "MLAlloc.h"
+
+#define DEFAULT_PROGRESS_INTERVAL            (1000)
+#define STAGING_SLOTS                        (2)
+
+
+#pragma mark -
+#pragma mark Trainer extension
+
+@interface MLTrainer () {
+    MLNeuralNetwork *_network;
+    MLParallelTrainer *_parallelTrainer;
+    id<MLTrainerDataSource> _dataSource;
+    
+    NSUInteger _batchSize;
+    NSUInteger _inputSize;
+    NSUInteger _outputSize;
+    
+    BOOL _shuffle;
+    MLReal _costLimit;
+    MLReal _gainCostLimit;
+    
+    NSUInteger _progressInterval;
+    MLTrainerProgressHandler _progressHandler;
+    MLTrainerEpochHandler _epochHandler;
+    
+    NSUInteger _epochs;
+    MLReal _lastCost;
+    
+    NSUInteger _sampleCount;
+    int *_indices;
+    
+    MLReal *_targetInputBuffer;
+    MLReal *_targetExpectedOutputBuffer;
+    
+    MLReal *_stagedInputBuffers[STAGING_SLOTS];
+    MLReal *_stagedExpectedOutputBuffers[STAGING_SLOTS];
+    NSUInteger _stagedSizes[STAGING_SLOTS];
+    dispatch_semaphore_t _stagedSemaphores[STAGING_SLOTS];
+    NSException *_stagingException;
+    
+    dispatch_queue_t _stagingQueue;
+    
+    BOOL _stopRequested;
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (void) setUpStagingBuffers;
+- (void) prepareIndices;
+- (void) shuffleIndices;
+
+- (void) stageBatch:(NSUInteger)batch;
+- (MLReal) trainBatchOfSize:(NSUInteger)size learningRate:(MLReal)learningRate;
+
+
+@end
+
+
+#pragma mark -
+#pragma mark Static constants
+
+static const MLReal __one= 1.0;
+
+
+#pragma mark -
+#pragma mark Trainer implementation
+
+@implementation MLTrainer
+
+
+#pragma mark -
+#pragma mark Initialization
+
+- (instancetype) init {
+    @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"MLTrainer class must be initialized properly"
+                                                             userInfo:nil];
+}
+
+- (instancetype) initWithNetwork:(MLNeuralNetwork *)network dataSource:(id<MLTrainerDataSource>)dataSource batchSize:(NSUInteger)batchSize {
+    if ((self = [super init])) {
+        
+        // Checks
+        if (network.readOnly)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Can't train a network with read-only weights"
+                                                                     userInfo:nil];
+        
+        if (batchSize == 0)
+            @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid batch size: must be positive"
+                                                                     userInfo:@{@"batchSize": @(batchSize)}];
+        
+        // Initialization
+        _network= network;
+        _dataSource= dataSource;
+        _batchSize= batchSize;
+        
+        // Samples are trained by mini-batch, directly on the network
+        [network setUpBatchOfSize:batchSize];
+        
+        _targetInputBuffer= network.batchInputBuffer;
+        _targetExpectedOutputBuffer= network.batchExpectedOutputBuffer;
+        
+        [self setUpStagingBuffers];
+    }
+    
+    return self;
+}
+
+- (instancetype) initWithParallelTrainer:(MLParallelTrainer *)parallelTrainer dataSource:(id<MLTrainerDataSource>)dataSource {
+    if ((self = [super init])) {
+        
+        // Initialization
+        _network= parallelTrainer.network;
+        _parallelTrainer= parallelTrainer;
+        _dataSource= dataSource;
+        _batchSize= parallelTrainer.batchSize;
+        
+        // Samples are trained by mini-batch, through the parallel trainer
+        _targetInputBuffer= parallelTrainer.batchInputBuffer;
+        _targetExpectedOutputBuffer= parallelTrainer.batchExpectedOutputBuffer;
+        
+        [self setUpStagingBuffers];
+    }
+    
+    return self;
+}
+
+- (void) dealloc {
+    for (NSUInteger i= 0; i < STAGING_SLOTS; i++) {
+        MLFreeRealBuffer(_stagedInputBuffers[i]);
+        _stagedInputBuffers[i]= NULL;
+        
+        MLFreeRealBuffer(_stagedExpectedOutputBuffers[i]);
+        _stagedExpectedOutputBuffers[i]= NULL;
+    }
+    
+    if (_indices) {
+        MLFreeIntBuffer(_indices);
+        _indices= NULL;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Training
+
+- (NSUInteger) trainWithLearningRate:(MLReal)learningRate maxEpochs:(NSUInteger)maxEpochs {
+    [self prepareIndices];
+    
+    __atomic_store_n(&_stopRequested, NO, __ATOMIC_RELEASE);
+    
+    NSUInteger batches= (_sampleCount + _batchSize -1) / _batchSize;
+    
+    _epochs= 0;
+    _lastCost= 0.0;
+    
+    // A max number of epochs of 0 means no limit
+    BOOL stop= NO;
+    while (!stop && ((maxEpochs == 0) || (_epochs < maxEpochs))) {
+        if (_shuffle)
+            [self shuffleIndices];
+        
+        NSDate *begin= [NSDate date];
+        NSUInteger nextProgress= _progressInterval;
+        NSUInteger trainedSamples= 0;
+        MLReal cost= 0.0;
+        
+        // While a batch is trained, the following one is staged on
+        // the background queue: the first two are staged in advance
+        NSUInteger stagedBatches= 0;
+        NSUInteger receivedBatches= 0;
+        
+        @try {
+            for (; (stagedBatches < batches) && (stagedBatches < STAGING_SLOTS); stagedBatches++)
+                [self stageBatch:stagedBatches];
+            
+            while (receivedBatches < batches) {
+                NSUInteger slot= receivedBatches % STAGING_SLOTS;
+                
+                dispatch_semaphore_wait(_stagedSemaphores[slot], DISPATCH_TIME_FOREVER);
+                receivedBatches++;
+                
+                if (_stagingException)
+                    @throw _stagingException;
+                
+                // Copy the staged batch in the network buffers,
+                // then its slot is free for the next batch
+                NSUInteger size= _stagedSizes[slot];
+                
+                ML_VSMUL(_stagedInputBuffers[slot], 1, &__one, _targetInputBuffer, 1, size * _inputSize);
+                ML_VSMUL(_stagedExpectedOutputBuffers[slot], 1, &__one, _targetExpectedOutputBuffer, 1, size * _outputSize);
+                
+                if (stagedBatches < batches) {
+                    [self stageBatch:stagedBatches];
+                    stagedBatches++;
+                }
+                
+                cost += [self trainBatchOfSize:size learningRate:learningRate];
+                trainedSamples += size;
+                
+                // Report progress
+                if (_progressHandler && (_progressInterval > 0) && (trainedSamples >= nextProgress)) {
+                    NSTimeInterval elapsed= [[NSDate date] timeIntervalSinceDate:begin];
+                    double samplesPerSecond= (elapsed > 0.0) ? (((double) trainedSamples) / elapsed) : 0.0;
+                    NSTimeInterval eta= (samplesPerSecond > 0.0) ? (((double) (_sampleCount - trainedSamples)) / samplesPerSecond) : 0.0;
+                    
+                    _progressHandler(_epochs +1, trainedSamples, cost / (MLReal) trainedSamples, samplesPerSecond, eta);
+                    
+                    nextProgress= ((trainedSamples / _progressInterval) +1) * _progressInterval;
+                }
+                
+                if (__atomic_load_n(&_stopRequested, __ATOMIC_ACQUIRE))
+                    break;
+            }
+            
+        } @finally {
+            
+            // Wait for batches still being staged, also
+            // when training is interrupted by an exception
+            for (NSUInteger i= receivedBatches; i < stagedBatches; i++)
+                dispatch_semaphore_wait(_stagedSemaphores[i % STAGING_SLOTS], DISPATCH_TIME_FOREVER);
+            
+            _stagingException= nil;
+        }
+        
+        // An interrupted epoch is not counted
+        if (trainedSamples < _sampleCount)
+            break;
+        
+        cost /= (MLReal) _sampleCount;
+        _epochs++;
+        
+        if (_epochHandler)
+            _epochHandler(_epochs, cost);
+        
+        // Check termination conditions
+        if ((_costLimit > 0.0) && (cost < _costLimit)) {
+            stop= YES;
+            
+        } else if ((_gainCostLimit > 0.0) && (_epochs > 1)) {
+            
+            // A zero cost can't improve further, consider it converged
+            if (_lastCost == 0.0) {
+                stop= YES;
+                
+            } else {
+                MLReal costGain= (_lastCost - cost) / _lastCost;
+                if (costGain < _gainCostLimit)
+                    stop= YES;
+            }
+        }
+        
+        if (__atomic_load_n(&_stopRequested, __ATOMIC_ACQUIRE))
+            stop= YES;
+        
+        _lastCost= cost;
+    }
+    
+    return _epochs;
+}
+
+- (void) stop {
+    __atomic_store_n(&_stopRequested, YES, __ATOMIC_RELEASE);
+}
+
+
+#pragma mark -
+#pragma mark Internals
+
+- (void) setUpStagingBuffers {
+    _inputSize= _network.inputSize;
+    _outputSize= _network.outputSize;
+    
+    _shuffle= YES;
+    _progressInterval= DEFAULT_PROGRESS_INTERVAL;
+    
+    for (NSUInteger i= 0; i < STAGING_SLOTS; i++) {
+        _stagedInputBuffers[i]= MLAllocRealBuffer(_batchSize * _inputSize);
+        _stagedExpectedOutputBuffers[i]= MLAllocRealBuffer(_batchSize * _outputSize);
+        
+        ML_VCLR(_stagedInputBuffers[i], 1, _batchSize * _inputSize);
+        ML_VCLR(_stagedExpectedOutputBuffers[i], 1, _batchSize * _outputSize);
+        
+        _stagedSemaphores[i]= dispatch_semaphore_create(0);
+    }
+    
+    // A serial queue keeps batches staged in order
+    _stagingQueue= dispatch_queue_create("MLTrainer staging", DISPATCH_QUEUE_SERIAL);
+}
+
+- (void) prepareIndices {
+    NSUInteger sampleCount= [_dataSource numberOfSamplesForTrainer:self];
+    if (sampleCount == 0)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid data source: it has no samples"
+                                                                 userInfo:nil];
+    
+    if (sampleCount > INT_MAX)
+        @throw [MLNeuralNetworkException neuralNetworkExceptionWithReason:@"Invalid data source: too many samples"
+                                                                 userInfo:@{@"samples": @(sampleCount)}];
+    
+    // Reallocate indices only if the number of samples has changed
+    if (sampleCount != _sampleCount) {
+        if (_indices)
+            MLFreeIntBuffer(_indices);
+        
+        _indices= MLAllocIntBuffer(sampleCount);
+        _sampleCount= sampleCount;
+    }
+    
+    for (NSUInteger i= 0; i < _sampleCount; i++)
+        _indices[i]= (int) i;
+}
+
+- (void) shuffleIndices {
+    
+    // Fisher-Yates shuffle
+    for (NSUInteger i= _sampleCount -1; i > 0; i--) {
+        NSUInteger j= [MLRandom nextUniformUIntWithMax:i +1];
+        
+        int temp= _indices[i];
+        _indices[i]= _indices[j];
+        _indices[j]= temp;
+    }
+}
+
+- (void) stageBatch:(NSUInteger)batch {
+    NSUInteger slot= batch % STAGING_SLOTS;
+    NSUInteger first= batch * _batchSize;
+    NSUInteger size= MIN(_batchSize, _sampleCount - first);
+    
+    dispatch_async(_stagingQueue, ^{
+        @try {
+            for (NSUInteger i= 0; i < size; i++) {
+                [_dataSource trainer:self
+                     fillInputBuffer:&_stagedInputBuffers[slot][i * _inputSize]
+                expectedOutputBuffer:&_stagedExpectedOutputBuffers[slot][i * _outputSize]
+                    forSampleAtIndex:_indices[first + i]];
+            }
+            
+        } @catch (NSException *e) {
+            
+            // The exception is rethrown on the training thread
+            _stagingException= e;
+        }
+        
+        _stagedSizes[slot]= size;
+        dispatch_semaphore_signal(_stagedSemaphores[slot]);
+    });
+}
+
+- (MLReal) trainBatchOfSize:(NSUInteger)size learningRate:(MLReal)learningRate {
+    if (_parallelTrainer) {
+        [_parallelTrainer trainBatchOfSize:size learningRate:learningRate];
+        
+        return _parallelTrainer.batchCost;
+    }
+    
+    [_network feedForwardBatchOfSize:size];
+    
+    MLReal cost= _network.batchCost;
+    
+    [_network backPropagateBatchWithLearningRate:learningRate];
+    [_network updateWeights];
+    
+    return cost;
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+@synthesize network= _network;
+@synthesize parallelTrainer= _parallelTrainer;
+@synthesize dataSource= _dataSource;
+
+@synthesize batchSize= _batchSize;
+
+@synthesize shuffle= _shuffle;
+@synthesize costLimit= _costLimit;
+@synthesize gainCostLimit= _gainCostLimit;
+
+@synthesize progressInterval= _progressInterval;
+@synthesize progressHandler= _progressHandler;
+@synthesize epochHandler= _epochHandler;
+
+@synthesize epochs= _epochs;
+@synthesize lastCost= _lastCost;
+
+
+@end
@@ -39,6 +39,9 @@
 @interface MLRandom : NSObject
 
 
++ (void) setSeed:(uint64_t)seed;
++ (void) setSeed:(uint64_t)seed stream:(NSUInteger)stream;
+
 + (NSUInteger) nextUniformUInt;
 + (NSUInteger) nextUniformUIntWithMax:(NSUInteger)max;
 
@@ -33,223 +33,424 @@
 
 #import "MLRandom.h"
 
-#import "MLAlloc.h"
+#define RANDOM_LANES                          (4)
 
-#define RANDOMIZATION_EXCEPTION_NAME          (@"MLRandomException")
+#define RANDOM_PARALLEL_THRESHOLD             (1 << 20)
+#define RANDOM_PARALLEL_CHUNK_SIZE            (1 << 18)
+
+#define ZIGGURAT_LAYERS                       (128)
+#define ZIGGURAT_R                            (3.442619855899)
+#define ZIGGURAT_V                            (9.91256303526217e-3)
+
+// Conversion of a 64 bit random to a real in range 0..1 (1 excluded),
+// using as many bits as the mantissa of MLReal
+#define RANDOM_TO_UNIT_REAL(x)                ((sizeof(MLReal) == sizeof(double)) ? \
+                                               (((MLReal) ((x) >> 11)) * 0x1.0p-53) : \
+                                               (((MLReal) ((int32_t) ((x) >> 40))) * 0x1.0p-24f))
 
 
 #pragma mark -
-#pragma mark Static constants
+#pragma mark Generator state
 
-static const MLReal __pi=                   M_PI;
-static const MLReal __two=                  2.0;
-static const MLReal __one=                  1.0;
-static const MLReal __minusTwo=            -2.0;
+// Each thread owns a stream of the xoshiro256 generator (see Blackman
+// and Vigna, 2018): a scalar state, for single randoms, and a few
+// interleaved lane states, for vector fills. Streams and lanes are
+// separated by jumps, so that they never overlap.
+typedef struct {
+    uint64_t state[4];
+    uint64_t laneState[4][RANDOM_LANES];
+    
+    uint64_t generation;
+} MLRandomThreadState;
 
 
 #pragma mark -
-#pragma mark Static variables
+#pragma mark Static constants
 
-static MLReal __spareGaussian=        0.0;
+static const uint64_t __jump[4]=           { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+static const uint64_t __longJump[4]=       { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
 
 
 #pragma mark -
-#pragma mark MLRandom implementation
+#pragma mark Static variables
 
-@implementation MLRandom
+// The master state is advanced by a long jump for each new stream,
+// the generation is incremented each time the master state is seeded
+static uint64_t __masterState[4];
+static uint64_t __generation= 0;
 
+static __thread MLRandomThreadState __threadState;
 
-+ (NSUInteger) nextUniformUInt {
-    NSUInteger random= 0;
-    
-    int result= SecRandomCopyBytes(kSecRandomDefault, sizeof(random), (uint8_t *) &random);
-    if (result != 0)
-        @throw [NSException exceptionWithName:RANDOMIZATION_EXCEPTION_NAME
-                                       reason:@"Non zero result from SecRandomCopyBytes"
-                                     userInfo:@{@"result": @(result)}];
-    
-    return random;
-}
+// Ziggurat tables for the normal distribution (see Marsaglia and Tsang,
+// 2000): layer widths, acceptance thresholds and density at layer edges
+static MLReal __zigguratW[ZIGGURAT_LAYERS];
+static uint32_t __zigguratK[ZIGGURAT_LAYERS];
+static MLReal __zigguratF[ZIGGURAT_LAYERS];
 
-+ (NSUInteger) nextUniformUIntWithMax:(NSUInteger)max {
-    NSUInteger random= [MLRandom nextUniformUInt];
 
-    return (random % max);
+#pragma mark -
+#pragma mark Static functions
+
+static inline uint64_t MLRandomRotateLeft(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
 }
 
-+ (MLReal) nextUniformReal {
+static inline uint64_t MLRandomSplitMix(uint64_t *seed) {
+    uint64_t z= (*seed += 0x9e3779b97f4a7c15ULL);
+    z= (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z= (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
     
-    // Use 23 bits to take maximum advatange of the float's mantissa,
-    // in case MLReal is double we waste some bits of its 52 bit mantissa
-    MLReal random= (MLReal) [MLRandom nextUniformUIntWithMax:(1 << 23)];
-    return (random * (1.0 / ((MLReal) ((1 << 23) - 1))));
+    return z ^ (z >> 31);
 }
 
-+ (MLReal) nextUniformRealWithMin:(MLReal)min max:(MLReal)max {
-    MLReal random= [MLRandom nextUniformReal];
-    return ((random * (max - min)) + min);
+static inline void MLRandomAdvance(uint64_t *s) {
+    uint64_t t= s[1] << 17;
+    
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3]= MLRandomRotateLeft(s[3], 45);
 }
 
-+ (void) fillVector:(MLReal *)vector size:(NSUInteger)size ofUniformRealsWithMin:(MLReal)min max:(MLReal)max {
+static inline uint64_t MLRandomNext(uint64_t *s) {
     
-    // Allocate and fill a temp integer vector
-    int *tempUniform= MLAllocIntBuffer(size);
+    // xoshiro256** output function
+    uint64_t result= MLRandomRotateLeft(s[1] * 5, 7) * 9;
+    MLRandomAdvance(s);
     
-    int result= SecRandomCopyBytes(kSecRandomDefault, sizeof(int) * size, (uint8_t *) tempUniform);
-    if (result != 0)
-        @throw [NSException exceptionWithName:RANDOMIZATION_EXCEPTION_NAME
-                                       reason:@"Non zero result from SecRandomCopyBytes"
-                                     userInfo:@{@"result": @(result)}];
+    return result;
+}
+
+static void MLRandomJump(uint64_t *s, const uint64_t *jump) {
+    uint64_t t[4]= { 0, 0, 0, 0 };
     
+    for (int i= 0; i < 4; i++) {
+        for (int b= 0; b < 64; b++) {
+            if (jump[i] & (1ULL << b)) {
+                t[0] ^= s[0];
+                t[1] ^= s[1];
+                t[2] ^= s[2];
+                t[3] ^= s[3];
+            }
+            
+            MLRandomAdvance(s);
+        }
+    }
     
-    // Use vector absolute value to avoid signed randoms
-    vDSP_vabsi(tempUniform, 1, tempUniform, 1, size);
+    s[0]= t[0];
+    s[1]= t[1];
+    s[2]= t[2];
+    s[3]= t[3];
+}
+
+static void MLRandomSeedState(uint64_t *s, uint64_t seed) {
     
-    // Get the division factor to reduce significant digits
-    // to the same size of float's mantissa (23 bits)
-    int intBits= (sizeof(int) * 8) -1;
-    int intDivisor= 1 << (intBits - 23);
+    // Expand the seed with SplitMix64, as recommended by xoshiro authors
+    for (int i= 0; i < 4; i++)
+        s[i]= MLRandomSplitMix(&seed);
+}
 
-    // Use vector integer division
-    vDSP_vsdivi(tempUniform, 1, &intDivisor, tempUniform, 1, size);
+static void MLRandomStartStream(MLRandomThreadState *threadState, const uint64_t *streamState, uint64_t generation) {
+    uint64_t s[4]= { streamState[0], streamState[1], streamState[2], streamState[3] };
     
-    // Convert the vector to floating point
-    ML_VFLT32(tempUniform, 1, vector, 1, size);
+    // The scalar state starts at the stream origin,
+    // lanes follow at one short jump from each other
+    for (int i= 0; i < 4; i++)
+        threadState->state[i]= s[i];
     
-    // Scale randoms in range 0..1
-    MLReal factor= 1.0 / ((MLReal) ((1 << 23) - 1));
-    ML_VSMUL(vector, 1, &factor, vector, 1, size);
+    for (int l= 0; l < RANDOM_LANES; l++) {
+        MLRandomJump(s, __jump);
+        
+        for (int i= 0; i < 4; i++)
+            threadState->laneState[i][l]= s[i];
+    }
+    
+    threadState->generation= generation;
+}
+
+static MLRandomThreadState *MLRandomGetThreadState(void) {
+    MLRandomThreadState *threadState= &__threadState;
     
-    // Finally apply limits
-    MLReal delta= max - min;
-    ML_VSMUL(vector, 1, &delta, vector, 1, size);
-    ML_VSADD(vector, 1, &min, vector, 1, size);
+    // Take a new stream from the master state if the thread has never
+    // used the generator, or if the master state has been seeded again
+    if (threadState->generation != __atomic_load_n(&__generation, __ATOMIC_ACQUIRE)) {
+        @synchronized ([MLRandom class]) {
+            MLRandomStartStream(threadState, __masterState, __generation);
+            MLRandomJump(__masterState, __longJump);
+        }
+    }
     
-    // Free the temp vector
-    MLFreeIntBuffer(tempUniform);
+    return threadState;
 }
 
-+ (MLReal) nextGaussianRealWithMean:(MLReal)mean sigma:(MLReal)sigma {
-    MLReal gaussian= 0.0;
+static inline void MLRandomNextLanes(uint64_t s[4][RANDOM_LANES], uint64_t *random) {
     
-    if (__spareGaussian == 0.0) {
-        
-        // Get a pair of random numbers
-        MLReal random1= [MLRandom nextUniformReal];
-        MLReal random2= [MLRandom nextUniformReal];
+    // Lanes are independent, so that the compiler can
+    // vectorize the generator (xoshiro256+ in this case)
+    for (int l= 0; l < RANDOM_LANES; l++) {
+        random[l]= s[0][l] + s[3][l];
         
-        // Apple Box–Muller transform
-        MLReal r= ML_SQRT(-2.0 * ML_LOG(random1));
-        MLReal phi= 2.0 * M_PI * random2;
+        uint64_t t= s[1][l] << 17;
         
-        gaussian= r * ML_COS(phi) * sigma + mean;
-        __spareGaussian= r * ML_SIN(phi);
+        s[2][l] ^= s[0][l];
+        s[3][l] ^= s[1][l];
+        s[1][l] ^= s[2][l];
+        s[0][l] ^= s[3][l];
+        s[2][l] ^= t;
+        s[3][l]= MLRandomRotateLeft(s[3][l], 45);
+    }
+}
+
+static void MLRandomFillUnitReals(MLRandomThreadState *threadState, MLReal *vector, NSUInteger size, MLReal min, MLReal delta) {
+    uint64_t s[4][RANDOM_LANES];
+    uint64_t random[RANDOM_LANES];
+    
+    // Work on a local copy of lane states, so that they stay in registers
+    memcpy(s, threadState->laneState, sizeof(s));
     
-    } else {
-        gaussian= __spareGaussian * sigma + mean;
-        __spareGaussian= 0.0;
+    for (NSUInteger i= 0; i < size; i += RANDOM_LANES) {
+        MLRandomNextLanes(s, random);
+        
+        NSUInteger count= MIN(RANDOM_LANES, size - i);
+        for (NSUInteger l= 0; l < count; l++)
+            vector[i + l]= min + (delta * RANDOM_TO_UNIT_REAL(random[l]));
     }
     
-    return gaussian;
+    memcpy(threadState->laneState, s, sizeof(s));
 }
 
-+ (MLReal) nextFastGaussianRealWithMean:(MLReal)mean sigma:(MLReal)sigma {
-    MLReal gaussian= 0.0;
+static void MLRandomSetUpZiggurat(void) {
+    double m= 2147483648.0;
+    double d= ZIGGURAT_R, t= ZIGGURAT_R;
+    double q= ZIGGURAT_V / exp(-0.5 * d * d);
+    
+    __zigguratK[0]= (uint32_t) ((d / q) * m);
+    __zigguratK[1]= 0;
+    
+    __zigguratW[0]= q / m;
+    __zigguratW[ZIGGURAT_LAYERS -1]= d / m;
     
-    if (__spareGaussian == 0.0) {
+    __zigguratF[0]= 1.0;
+    __zigguratF[ZIGGURAT_LAYERS -1]= exp(-0.5 * d * d);
+    
+    for (int i= ZIGGURAT_LAYERS -2; i >= 1; i--) {
+        d= sqrt(-2.0 * log((ZIGGURAT_V / d) + exp(-0.5 * d * d)));
+        
+        __zigguratK[i +1]= (uint32_t) ((d / t) * m);
+        t= d;
+        
+        __zigguratF[i]= exp(-0.5 * d * d);
+        __zigguratW[i]= d / m;
+    }
+}
+
+static inline uint32_t MLRandomZigguratMagnitude(int32_t hz) {
+    return (uint32_t) ((hz < 0) ? -((int64_t) hz) : hz);
+}
+
+static MLReal MLRandomZigguratReject(uint64_t *s, uint64_t random) {
+    for (;;) {
+        int32_t hz= (int32_t) (random >> 32);
+        uint32_t iz= (uint32_t) (random & (ZIGGURAT_LAYERS -1));
+        MLReal x= ((MLReal) hz) * __zigguratW[iz];
         
-        // Get a pair of (fast) random numbers
-        MLReal random1= [MLRandom nextUniformReal];
-        MLReal random2= [MLRandom nextUniformReal];
+        if (MLRandomZigguratMagnitude(hz) < __zigguratK[iz])
+            return x;
         
-        // Apple Box–Muller transform
-        MLReal r= ML_SQRT(-2.0 * ML_LOG(random1));
-        MLReal phi= 2.0 * M_PI * random2;
+        if (iz == 0) {
+            
+            // Sample from the tail, beyond the base layer
+            MLReal tailX= 0.0, tailY= 0.0;
+            do {
+                tailX= -ML_LOG(1.0 - RANDOM_TO_UNIT_REAL(MLRandomNext(s))) / ZIGGURAT_R;
+                tailY= -ML_LOG(1.0 - RANDOM_TO_UNIT_REAL(MLRandomNext(s)));
+            } while (tailY + tailY < tailX * tailX);
+            
+            return (hz > 0) ? (ZIGGURAT_R + tailX) : -(ZIGGURAT_R + tailX);
+        }
         
-        gaussian= r * ML_COS(phi) * sigma + mean;
-        __spareGaussian= r * ML_SIN(phi);
+        // Sample from the wedge between the layer and the density
+        MLReal y= __zigguratF[iz] + (RANDOM_TO_UNIT_REAL(MLRandomNext(s)) * (__zigguratF[iz -1] - __zigguratF[iz]));
+        if (y < ML_EXP(-0.5 * x * x))
+            return x;
         
-    } else {
-        gaussian= __spareGaussian * sigma + mean;
-        __spareGaussian= 0.0;
+        random= MLRandomNext(s);
     }
-    
-    return gaussian;
 }
 
-+ (void) fillVector:(MLReal *)vector size:(NSUInteger)size ofGaussianRealsWithMean:(MLReal)mean sigma:(MLReal)sigma {
+static void MLRandomFillGaussianReals(MLRandomThreadState *threadState, MLReal *vector, NSUInteger size, MLReal mean, MLReal sigma) {
+    uint64_t s[4][RANDOM_LANES];
+    uint64_t random[RANDOM_LANES];
+    MLReal candidate[RANDOM_LANES];
+    int accepted[RANDOM_LANES];
+    
+    memcpy(s, threadState->laneState, sizeof(s));
     
-    // When using strides the size must be scaled, but we have
-    // to consider the last element if the original size is odd:
-    // - if we have e.g. 3 elements and want to use a stride of 2,
-    //   we need a size of 2 (not 1), or the element at [2] will
-    //   not be considered
-    // - but if we want to use a stride of 2 on odd elements
-    //   (i.e. starting with &vector[1]), we need a size of 1,
-    //   or it tries to consider element [3], which does not exist
-    NSUInteger evenStridedSize= (size % 2 == 0) ? (size / 2) : ((size / 2) +1);
-    NSUInteger oddStridedSize= (size % 2 == 0) ? evenStridedSize : (evenStridedSize -1);
+    for (NSUInteger i= 0; i < size; i += RANDOM_LANES) {
+        MLRandomNextLanes(s, random);
+        
+        // Fast path: about 99% of samples fall inside their layer
+        // and need just a table lookup and a multiplication
+        for (int l= 0; l < RANDOM_LANES; l++) {
+            int32_t hz= (int32_t) (random[l] >> 32);
+            uint32_t iz= (uint32_t) (random[l] & (ZIGGURAT_LAYERS -1));
+            
+            candidate[l]= ((MLReal) hz) * __zigguratW[iz];
+            accepted[l]= (MLRandomZigguratMagnitude(hz) < __zigguratK[iz]);
+        }
+        
+        // Slow path: the few rejected samples are drawn again
+        // from the scalar state, with tail and wedge sampling
+        NSUInteger count= MIN(RANDOM_LANES, size - i);
+        for (NSUInteger l= 0; l < count; l++) {
+            MLReal x= accepted[l] ? candidate[l] : MLRandomZigguratReject(threadState->state, random[l]);
+            
+            vector[i + l]= (x * sigma) + mean;
+        }
+    }
     
-    // Allocate and fill a temp vectors with uniform randoms
-    MLReal *tempGaussian1= MLAllocRealBuffer(size);
+    memcpy(threadState->laneState, s, sizeof(s));
+}
+
+
+#pragma mark -
+#pragma mark MLRandom implementation
+
+@implementation MLRandom
+
 
-    [MLRandom fillVector:tempGaussian1 size:size ofUniformRealsWithMin:0.0 max:1.0];
+#pragma mark -
+#pragma mark Initialization
+
++ (void) initialize {
+    if (self != [MLRandom class])
+        return;
     
-    if (size > 1) {
+    // Seed with time and process ID, until a seed is explicitly set
+    uint64_t seed= (uint64_t) ([NSDate timeIntervalSinceReferenceDate] * 1.0e9);
+    seed ^= ((uint64_t) [NSProcessInfo processInfo].processIdentifier) << 32;
+    
+    @synchronized ([MLRandom class]) {
+        MLRandomSeedState(__masterState, seed);
+        __atomic_store_n(&__generation, 1, __ATOMIC_RELEASE);
+    }
+    
+    MLRandomSetUpZiggurat();
+}
+
+
+#pragma mark -
+#pragma mark Seeding
+
++ (void) setSeed:(uint64_t)seed {
+    @synchronized ([MLRandom class]) {
+        MLRandomSeedState(__masterState, seed);
+        __atomic_store_n(&__generation, __generation +1, __ATOMIC_RELEASE);
         
-        // Copy even elements on odd elements, so that
-        // we have pairs of identical random numbers
-        ML_VSMUL(tempGaussian1, 2, &__one, &tempGaussian1[1], 2, oddStridedSize);
+        // The calling thread always gets the first stream
+        MLRandomStartStream(&__threadState, __masterState, __generation);
+        MLRandomJump(__masterState, __longJump);
     }
+}
+
++ (void) setSeed:(uint64_t)seed stream:(NSUInteger)stream {
+    uint64_t s[4];
+    MLRandomSeedState(s, seed);
+    
+    for (NSUInteger i= 0; i < stream; i++)
+        MLRandomJump(s, __longJump);
+    
+    // Seeds only the calling thread, streams of other threads are not changed
+    MLRandomStartStream(&__threadState, s, __atomic_load_n(&__generation, __ATOMIC_ACQUIRE));
+}
+
+
+#pragma mark -
+#pragma mark Uniform distribution
+
++ (NSUInteger) nextUniformUInt {
+    MLRandomThreadState *threadState= MLRandomGetThreadState();
     
-    MLReal *tempGaussian2= MLAllocRealBuffer(size);
+    return (NSUInteger) MLRandomNext(threadState->state);
+}
+
++ (NSUInteger) nextUniformUIntWithMax:(NSUInteger)max {
+    // Empty range, nothing to draw (and avoid a division by zero)
+    if (max == 0)
+        return 0;
     
-    // Duplicate temp1 on temp2
-    ML_VSMUL(tempGaussian1, 1, &__one, tempGaussian2, 1, size);
+    MLRandomThreadState *threadState= MLRandomGetThreadState();
     
-    // Now fill vector with uniform random numbers, and copy
-    // even elements on odd elements as we have done with temp1
-    [MLRandom fillVector:vector size:size ofUniformRealsWithMin:0.0 max:1.0];
+    // Reject randoms below 2^n % max, to avoid modulo bias
+    NSUInteger threshold= (-max) % max;
     
-    if (size > 1)
-        ML_VSMUL(vector, 2, &__one, &vector[1], 2, oddStridedSize);
+    NSUInteger random= 0;
+    do {
+        random= (NSUInteger) MLRandomNext(threadState->state);
+    } while (random < threshold);
+
+    return (random % max);
+}
+
++ (MLReal) nextUniformReal {
+    MLRandomThreadState *threadState= MLRandomGetThreadState();
     
-    // Now we jave two sets of random numbers, with one set duplicated on
-    // two separate temp vectors, and both sets have numbers duplicated
-    // on even and odd elements: we can proceed with Box-Muller transform
+    return RANDOM_TO_UNIT_REAL(MLRandomNext(threadState->state));
+}
+
++ (MLReal) nextUniformRealWithMin:(MLReal)min max:(MLReal)max {
+    MLReal random= [MLRandom nextUniformReal];
+    return ((random * (max - min)) + min);
+}
+
++ (void) fillVector:(MLReal *)vector size:(NSUInteger)size ofUniformRealsWithMin:(MLReal)min max:(MLReal)max {
+    MLRandomThreadState *threadState= MLRandomGetThreadState();
     
-    // An "int" size is needed by vvlog and vvsqrt
-    int intSize= (int) size;
+    MLRandomFillUnitReals(threadState, vector, size, min, max - min);
+}
 
-    // Compute first term of Box-Muller transform
-    // directly on the vector
-    ML_VVLOG(vector, vector, &intSize);
-    ML_VSMUL(vector, 1, &__minusTwo, vector, 1, size);
-    ML_VVSQRT(vector, vector, &intSize);
+
+#pragma mark -
+#pragma mark Gaussian distribution
+
++ (MLReal) nextGaussianRealWithMean:(MLReal)mean sigma:(MLReal)sigma {
+    MLRandomThreadState *threadState= MLRandomGetThreadState();
     
-    // Compute the second term of Box-Muller transform
-    // on temp vectors, cosine for temp1 and sine for temp2
-    ML_VSMUL(tempGaussian1, 1, &__pi, tempGaussian1, 1, size);
-    ML_VSMUL(tempGaussian1, 1, &__two, tempGaussian1, 1, size);
-    ML_VVCOS(tempGaussian1, tempGaussian1, &intSize);
+    // Use the slow path directly, it includes the fast path check
+    MLReal gaussian= MLRandomZigguratReject(threadState->state, MLRandomNext(threadState->state));
     
-    ML_VSMUL(tempGaussian2, 1, &__pi, tempGaussian2, 1, size);
-    ML_VSMUL(tempGaussian2, 1, &__two, tempGaussian2, 1, size);
-    ML_VVSIN(tempGaussian2, tempGaussian2, &intSize);
+    return (gaussian * sigma) + mean;
+}
+
++ (void) fillVector:(MLReal *)vector size:(NSUInteger)size ofGaussianRealsWithMean:(MLReal)mean sigma:(MLReal)sigma {
+    MLRandomThreadState *threadState= MLRandomGetThreadState();
     
-    // Now form gaussian random numbers by multipling vector by temp1
-    // on even indexes and vector by temp2 on odd indexes
-    ML_VMUL(vector, 2, tempGaussian1, 2, vector, 2, evenStridedSize);
-    ML_VMUL(&vector[1], 2, tempGaussian2, 2, &vector[1], 2, oddStridedSize);
+    if (size < RANDOM_PARALLEL_THRESHOLD) {
+        MLRandomFillGaussianReals(threadState, vector, size, mean, sigma);
+        return;
+    }
     
-    // Finally apply limits
-    ML_VSMUL(vector, 1, &sigma, vector, 1, size);
-    ML_VSADD(vector, 1, &mean, vector, 1, size);
+    // Large vectors are filled in chunks, concurrently: each chunk has
+    // its own stream, seeded from the stream of the calling thread and
+    // its index, so that the result does not depend on thread scheduling
+    uint64_t seed= MLRandomNext(threadState->state);
+    NSUInteger chunks= (size + RANDOM_PARALLEL_CHUNK_SIZE -1) / RANDOM_PARALLEL_CHUNK_SIZE;
     
-    // Free the temp vectors
-    MLFreeRealBuffer(tempGaussian1);
-    MLFreeRealBuffer(tempGaussian2);
+    dispatch_apply(chunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        NSUInteger offset= chunk * RANDOM_PARALLEL_CHUNK_SIZE;
+        NSUInteger length= MIN(RANDOM_PARALLEL_CHUNK_SIZE, size - offset);
+        
+        uint64_t index= chunk;
+        uint64_t chunkStreamState[4];
+        MLRandomSeedState(chunkStreamState, seed ^ MLRandomSplitMix(&index));
+        
+        MLRandomThreadState chunkState;
+        MLRandomStartStream(&chunkState, chunkStreamState, 0);
+        
+        MLRandomFillGaussianReals(&chunkState, &vector[offset], length, mean, sigma);
+    });
 }
 
-
 @end
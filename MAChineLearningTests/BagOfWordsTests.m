@@ -318,6 +318,16 @@
 		XCTAssertEqual(bag.outputBuffer[[dictionary infoForWord:@"eliza"].position], 3.0);
 		XCTAssertEqual(bag.outputBuffer[[dictionary infoForWord:@"joseph weizenbaum"].position], 1.0);
 		
+		// Sparse representation must list exactly the nonzero features
+		NSUInteger nonZeroCount= 0;
+		for (NSUInteger i= 0; i < bag.outputSize; i++)
+			nonZeroCount += (bag.outputBuffer[i] != 0.0) ? 1 : 0;
+		
+		XCTAssertEqual(bag.sparseSize, nonZeroCount);
+		
+		for (NSUInteger i= 0; i < bag.sparseSize; i++)
+			XCTAssertEqual(bag.sparseValues[i], bag.outputBuffer[bag.sparseIndices[i]]);
+		
 	} @catch (NSException *e) {
 		XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
 	}
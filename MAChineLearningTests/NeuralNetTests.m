@@ -52,11 +52,129 @@
 #define LOAD_SAVE_TEST_TRAIN_CYCLES                    (100)
 #define LOAD_SAVE_TEST_LEARNING_RATE                     (0.1)
 
+#define BATCH_TEST_TRAIN_CYCLES                         (10)
+#define BATCH_TEST_BATCH_SIZE                            (4)
+#define BATCH_TEST_LEARNING_RATE                         (0.1)
+
+#define GRADIENT_TEST_EPSILON                            (0.01)
+#define GRADIENT_TEST_ACCURACY                           (0.0001)
+
+#define PARALLEL_TEST_TRAIN_CYCLES                      (5)
+#define PARALLEL_TEST_WORKERS                            (4)
+#define PARALLEL_TEST_BATCH_SIZE                        (10)
+#define PARALLEL_TEST_LEARNING_RATE                      (0.1)
+
+#define HOGWILD_TEST_INPUT_SIZE                        (100)
+#define HOGWILD_TEST_NONZEROS                            (4)
+#define HOGWILD_TEST_TRAIN_CYCLES                       (20)
+
+#define MODEL_FILE_TEST_SAMPLES                        (16)
+
+#define SPARSE_TEST_INPUT_SIZE                        (200)
+#define SPARSE_TEST_NONZEROS                             (8)
+#define SPARSE_TEST_TRAIN_CYCLES                        (10)
+#define SPARSE_TEST_LEARNING_RATE                        (0.1)
+
+#define QUANTIZATION_TEST_SAMPLES                      (32)
+#define QUANTIZATION_TEST_MAX_DRIFT                      (0.05)
+
+#define CONTEXT_TEST_SAMPLES                           (64)
+#define CONTEXT_TEST_BATCH_SIZE                          (8)
+
+#define PLAN_TEST_SAMPLES                              (64)
+#define PLAN_TEST_ACCURACY                               (0.00001)
+
+#define FAST_ACTIVATION_TEST_SAMPLES                    (20)
+#define FAST_ACTIVATION_TEST_ACCURACY                    (0.0001)
+
+#define ALLOCATION_TEST_TRAIN_CYCLES                    (10)
+#define ALLOCATION_TEST_BATCH_SIZE                       (4)
+
+#define TRAINER_TEST_SAMPLES                           (64)
+#define TRAINER_TEST_BATCH_SIZE                          (8)
+#define TRAINER_TEST_MAX_EPOCHS                         (20)
+#define TRAINER_TEST_LEARNING_RATE                       (0.5)
+
+#define PROFILE_TEST_TRAIN_CYCLES                      (10)
+#define PROFILE_TEST_BATCH_SIZE                          (4)
+#define PROFILE_TEST_TRACE_EVENTS                       (16)
+
+#define OPTIMIZER_TEST_TRAIN_CYCLES                    (50)
+#define OPTIMIZER_TEST_LEARNING_RATE                     (0.05)
+#define OPTIMIZER_TEST_IRPROP_EPOCHS                   (50)
+
+#define HALF_TEST_SAMPLES                              (32)
+#define HALF_TEST_ACCURACY                               (0.01)
+#define BFLOAT16_TEST_ACCURACY                           (0.05)
+
+#define PRUNING_TEST_SAMPLES                           (16)
+#define PRUNING_TEST_SPARSITY                            (0.8)
+#define PRUNING_TEST_TRAIN_CYCLES                       (10)
+
+#define FACTORIZATION_TEST_SAMPLES                     (16)
+#define FACTORIZATION_TEST_RANK                         (8)
+#define FACTORIZATION_TEST_MAX_ERROR                     (0.5)
+
+#define EMBEDDING_TEST_VOCABULARY_SIZE                 (10)
+#define EMBEDDING_TEST_SIZE                             (4)
+#define EMBEDDING_TEST_TRAIN_CYCLES                   (500)
+#define EMBEDDING_TEST_LEARNING_RATE                     (0.5)
+
+#define SOFTMAX_TEST_CLASSES                            (8)
+#define SOFTMAX_TEST_TRAIN_CYCLES                     (200)
+#define SOFTMAX_TEST_LEARNING_RATE                       (0.5)
+#define SOFTMAX_TEST_SAMPLES                             (3)
+
+
+#pragma mark -
+#pragma mark TrainerTestSource declaration
+
+// Feeds the NAND truth table, repeated, to MLTrainer
+@interface TrainerTestSource : NSObject <MLTrainerDataSource>
+
+@property (nonatomic, assign) NSUInteger failingIndex;
+
+@end
+
+
+#pragma mark -
+#pragma mark TrainerTestSource implementation
+
+@implementation TrainerTestSource
+
+- (NSUInteger) numberOfSamplesForTrainer:(MLTrainer *)trainer {
+    return TRAINER_TEST_SAMPLES;
+}
+
+- (void) trainer:(MLTrainer *)trainer fillInputBuffer:(MLReal *)inputBuffer expectedOutputBuffer:(MLReal *)expectedOutputBuffer forSampleAtIndex:(NSUInteger)index {
+    if ((_failingIndex > 0) && (index == _failingIndex))
+        @throw [NSException exceptionWithName:@"TrainerTestSourceException"
+                                       reason:@"Failing sample"
+                                     userInfo:nil];
+    
+    int a= index % 2;
+    int b= (index / 2) % 2;
+    
+    inputBuffer[0]= a;
+    inputBuffer[1]= b;
+    expectedOutputBuffer[0]= (a && b) ? 0.0 : 1.0;
+}
+
+@end
+
 
 #pragma mark -
 #pragma mark NeuralNetTests declaration
 
 @interface NeuralNetTests : XCTestCase
+
+
+#pragma mark -
+#pragma mark Utility methods
+
++ (void) computeGradientOfNetwork:(MLNeuralNetwork *)net gradient:(MLReal *)gradient;
+
+
 @end
 
 
@@ -390,4 +508,1590 @@
 }
 
 
+- (void) testBatch {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@3, @4, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        // Create an identical network for batch processing
+        MLNeuralNetwork *batchNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        [batchNet setUpBatchOfSize:BATCH_TEST_BATCH_SIZE];
+        
+        // Fill the batch with some inputs
+        for (int i= 0; i < BATCH_TEST_BATCH_SIZE; i++) {
+            MLReal base= 1.0 / ((MLReal) (i +1));
+            batchNet.batchInputBuffer[i * batchNet.inputSize]= base - 0.07;
+            batchNet.batchInputBuffer[i * batchNet.inputSize +1]= base + 0.05;
+            batchNet.batchInputBuffer[i * batchNet.inputSize +2]= base + 0.13;
+        }
+        
+        [batchNet feedForwardBatchOfSize:BATCH_TEST_BATCH_SIZE];
+        
+        // Check each output of the batch is the same of a sample by sample feed forward
+        for (int i= 0; i < BATCH_TEST_BATCH_SIZE; i++) {
+            for (int j= 0; j < net.inputSize; j++)
+                net.inputBuffer[j]= batchNet.batchInputBuffer[i * batchNet.inputSize + j];
+            
+            [net feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                XCTAssertEqualWithAccuracy(batchNet.batchOutputBuffer[i * batchNet.outputSize + j], net.outputBuffer[j], 0.00001);
+        }
+        
+        // A batch of one sample must follow the gradient of the cost, with
+        // hidden errors computed from the weights as they were before the batch
+        MLNeuralNetwork *singleBatchNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        [singleBatchNet setUpBatchOfSize:1];
+        
+        for (int j= 0; j < net.inputSize; j++) {
+            net.inputBuffer[j]= batchNet.batchInputBuffer[j];
+            singleBatchNet.batchInputBuffer[j]= batchNet.batchInputBuffer[j];
+        }
+        
+        net.expectedOutputBuffer[0]= 1.0;
+        net.expectedOutputBuffer[1]= 0.0;
+        singleBatchNet.batchExpectedOutputBuffer[0]= 1.0;
+        singleBatchNet.batchExpectedOutputBuffer[1]= 0.0;
+        
+        NSUInteger weightsCount= 0;
+        for (int i= 1; i < net.layers.count; i++)
+            weightsCount += ((MLNeuronLayer *) net.layers[i]).size * net.layers[i].previousLayer.size;
+        
+        MLReal *gradient= MLAllocRealBuffer(weightsCount);
+        MLReal *weights= MLAllocRealBuffer(weightsCount);
+        
+        [NeuralNetTests computeGradientOfNetwork:net gradient:gradient];
+        
+        for (int i= 1, k= 0; i < singleBatchNet.layers.count; i++) {
+            MLNeuronLayer *layer= (MLNeuronLayer *) singleBatchNet.layers[i];
+            
+            for (int j= 0; j < layer.size * layer.previousLayer.size; j++)
+                weights[k++]= layer.weights[j];
+        }
+        
+        [singleBatchNet feedForwardBatchOfSize:1];
+        [singleBatchNet backPropagateBatchWithLearningRate:BATCH_TEST_LEARNING_RATE];
+        [singleBatchNet updateWeights];
+        
+        for (int i= 1, k= 0; i < singleBatchNet.layers.count; i++) {
+            MLNeuronLayer *layer= (MLNeuronLayer *) singleBatchNet.layers[i];
+            
+            for (int j= 0; j < layer.size * layer.previousLayer.size; j++, k++)
+                XCTAssertEqualWithAccuracy((layer.weights[j] - weights[k]) / BATCH_TEST_LEARNING_RATE, gradient[k], GRADIENT_TEST_ACCURACY);
+        }
+        
+        MLFreeRealBuffer(gradient);
+        MLFreeRealBuffer(weights);
+        
+        NSDate *begin= [NSDate date];
+        
+        // Train the batch network for a few cycles and check the cost decreases
+        for (int i= 0; i < BATCH_TEST_BATCH_SIZE; i++) {
+            batchNet.batchExpectedOutputBuffer[i * batchNet.outputSize]= (i % 2 == 0) ? 1.0 : 0.0;
+            batchNet.batchExpectedOutputBuffer[i * batchNet.outputSize +1]= (i % 2 == 0) ? 0.0 : 1.0;
+        }
+        
+        MLReal firstCost= 0.0;
+        MLReal lastCost= 0.0;
+        for (int i= 0; i < BATCH_TEST_TRAIN_CYCLES; i++) {
+            [batchNet feedForwardBatchOfSize:BATCH_TEST_BATCH_SIZE];
+            
+            lastCost= batchNet.batchCost;
+            if (i == 0)
+                firstCost= lastCost;
+            
+            [batchNet backPropagateBatchWithLearningRate:BATCH_TEST_LEARNING_RATE];
+            [batchNet updateWeights];
+        }
+        
+        NSTimeInterval elapsed= [[NSDate date] timeIntervalSinceDate:begin];
+        NSLog(@"testBatch: average training time: %.2f µs per sample", (elapsed * 1000000.0) / ((double) BATCH_TEST_BATCH_SIZE * BATCH_TEST_TRAIN_CYCLES));
+        
+        XCTAssertLessThan(lastCost, firstCost);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testNoAllocationsDuringTraining {
+#if DEBUG
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@3, @4, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeCrossEntropy
+                                                      backPropagationType:MLBackPropagationTypeResilient
+                                                       hiddenFunctionType:MLActivationFunctionTypeTanH
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        [net setUpBatchOfSize:ALLOCATION_TEST_BATCH_SIZE];
+        
+        for (int i= 0; i < net.inputSize; i++)
+            net.inputBuffer[i]= 0.1 * (i +1);
+        
+        for (int i= 0; i < ALLOCATION_TEST_BATCH_SIZE * net.inputSize; i++)
+            net.batchInputBuffer[i]= 0.05 * (i +1);
+        
+        net.expectedOutputBuffer[0]= 1.0;
+        net.batchExpectedOutputBuffer[0]= 1.0;
+        
+        // Count allocations after setup, nothing
+        // else should be allocated during training
+        NSUInteger allocations= MLAllocBufferCount();
+        
+        for (int i= 0; i < ALLOCATION_TEST_TRAIN_CYCLES; i++) {
+            [net feedForward];
+            
+            MLReal cost= net.cost;
+            XCTAssertFalse(isnan(cost));
+            
+            [net backPropagate];
+            [net updateWeights];
+            
+            [net feedForwardBatchOfSize:ALLOCATION_TEST_BATCH_SIZE];
+            
+            MLReal batchCost= net.batchCost;
+            XCTAssertFalse(isnan(batchCost));
+            
+            [net backPropagateBatch];
+            [net updateWeights];
+        }
+        
+        XCTAssertEqual(MLAllocBufferCount(), allocations);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+#endif // DEBUG
+}
+
+
+- (void) testFastApproximateActivation {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@3, @8, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeTanH
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        // Create an identical network with fast activation
+        MLNeuralNetwork *fastNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        fastNet.fastApproximateActivation= YES;
+        
+        XCTAssertTrue(fastNet.fastApproximateActivation);
+        XCTAssertFalse(net.fastApproximateActivation);
+        
+        // Check outputs are the same within the approximation
+        for (int i= 0; i < FAST_ACTIVATION_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++) {
+                net.inputBuffer[j]= ((MLReal) (i - (FAST_ACTIVATION_TEST_SAMPLES / 2))) / ((MLReal) (j +1));
+                fastNet.inputBuffer[j]= net.inputBuffer[j];
+            }
+            
+            [net feedForward];
+            [fastNet feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                XCTAssertEqualWithAccuracy(fastNet.outputBuffer[j], net.outputBuffer[j], FAST_ACTIVATION_TEST_ACCURACY);
+        }
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testParallelTraining {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@3, @5, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        // Create an identical network for serial batch training
+        MLNeuralNetwork *serialNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        [serialNet setUpBatchOfSize:PARALLEL_TEST_BATCH_SIZE];
+        
+        MLParallelTrainer *trainer= [[MLParallelTrainer alloc] initWithNetwork:net
+                                                                       workers:PARALLEL_TEST_WORKERS
+                                                                     batchSize:PARALLEL_TEST_BATCH_SIZE];
+        
+        // Fill the batch with the same inputs on both
+        for (int i= 0; i < PARALLEL_TEST_BATCH_SIZE; i++) {
+            for (int j= 0; j < net.inputSize; j++) {
+                trainer.batchInputBuffer[i * net.inputSize + j]= ((MLReal) ((i + j) % 5)) / 5.0;
+                serialNet.batchInputBuffer[i * net.inputSize + j]= trainer.batchInputBuffer[i * net.inputSize + j];
+            }
+            
+            trainer.batchExpectedOutputBuffer[i * net.outputSize]= (i % 2 == 0) ? 1.0 : 0.0;
+            trainer.batchExpectedOutputBuffer[i * net.outputSize +1]= (i % 2 == 0) ? 0.0 : 1.0;
+            
+            for (int j= 0; j < net.outputSize; j++)
+                serialNet.batchExpectedOutputBuffer[i * net.outputSize + j]= trainer.batchExpectedOutputBuffer[i * net.outputSize + j];
+        }
+        
+        // Train both and check the cost is the same at each cycle
+        for (int i= 0; i < PARALLEL_TEST_TRAIN_CYCLES; i++) {
+            [trainer trainBatchOfSize:PARALLEL_TEST_BATCH_SIZE learningRate:PARALLEL_TEST_LEARNING_RATE];
+            
+            [serialNet feedForwardBatchOfSize:PARALLEL_TEST_BATCH_SIZE];
+            XCTAssertEqualWithAccuracy(trainer.batchCost, serialNet.batchCost, 0.0001);
+            
+            [serialNet backPropagateBatchWithLearningRate:PARALLEL_TEST_LEARNING_RATE];
+            [serialNet updateWeights];
+        }
+        
+        // Check final weights are the same
+        for (int i= 1; i < net.layers.count; i++) {
+            MLNeuronLayer *layer= (MLNeuronLayer *) net.layers[i];
+            MLNeuronLayer *serialLayer= (MLNeuronLayer *) serialNet.layers[i];
+            
+            for (int j= 0; j < layer.size * layer.previousLayer.size; j++)
+                XCTAssertEqualWithAccuracy(layer.weights[j], serialLayer.weights[j], 0.0001);
+        }
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testHogwildSparseInput {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@(HOGWILD_TEST_INPUT_SIZE), @8, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [MLRandom setSeed:42];
+        [net randomizeWeights];
+        
+        // Create an identical network for serial training, sample by sample
+        MLNeuralNetwork *serialNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        MLNeuralNetwork *parallelNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        
+        // With a single worker, Hogwild must train as the serial network
+        MLParallelTrainer *trainer= [[MLParallelTrainer alloc] initWithNetwork:net
+                                                                       workers:1
+                                                                     batchSize:PARALLEL_TEST_BATCH_SIZE
+                                                                       hogwild:YES];
+        
+        MLParallelTrainer *parallelTrainer= [[MLParallelTrainer alloc] initWithNetwork:parallelNet
+                                                                               workers:PARALLEL_TEST_WORKERS
+                                                                             batchSize:PARALLEL_TEST_BATCH_SIZE
+                                                                               hogwild:YES];
+        
+        // Fill the batch with sparse inputs, the last columns are never used
+        for (int i= 0; i < PARALLEL_TEST_BATCH_SIZE; i++) {
+            for (int j= 0; j < HOGWILD_TEST_NONZEROS; j++) {
+                int index= (i * 7 + j * 13) % (HOGWILD_TEST_INPUT_SIZE / 2);
+                
+                trainer.batchInputBuffer[i * net.inputSize + index]= 1.0;
+                parallelTrainer.batchInputBuffer[i * net.inputSize + index]= 1.0;
+            }
+            
+            for (int j= 0; j < net.outputSize; j++) {
+                MLReal expected= ((i + j) % 2 == 0) ? 1.0 : 0.0;
+                
+                trainer.batchExpectedOutputBuffer[i * net.outputSize + j]= expected;
+                parallelTrainer.batchExpectedOutputBuffer[i * net.outputSize + j]= expected;
+            }
+        }
+        
+        MLNeuronLayer *parallelLayer= (MLNeuronLayer *) parallelNet.layers[1];
+        MLReal unusedWeight= parallelLayer.weights[HOGWILD_TEST_INPUT_SIZE -1];
+        
+        MLReal firstCost= 0.0;
+        for (int cycle= 0; cycle < HOGWILD_TEST_TRAIN_CYCLES; cycle++) {
+            [trainer trainBatchOfSize:PARALLEL_TEST_BATCH_SIZE learningRate:PARALLEL_TEST_LEARNING_RATE];
+            [parallelTrainer trainBatchOfSize:PARALLEL_TEST_BATCH_SIZE learningRate:PARALLEL_TEST_LEARNING_RATE];
+            
+            if (cycle == 0)
+                firstCost= parallelTrainer.batchCost;
+            
+            for (int i= 0; i < PARALLEL_TEST_BATCH_SIZE; i++) {
+                for (int j= 0; j < serialNet.inputSize; j++)
+                    serialNet.inputBuffer[j]= trainer.batchInputBuffer[i * net.inputSize + j];
+                
+                for (int j= 0; j < serialNet.outputSize; j++)
+                    serialNet.expectedOutputBuffer[j]= trainer.batchExpectedOutputBuffer[i * net.outputSize + j];
+                
+                [serialNet feedForward];
+                [serialNet backPropagateWithLearningRate:PARALLEL_TEST_LEARNING_RATE];
+                [serialNet updateWeights];
+            }
+        }
+        
+        for (int i= 1; i < net.layers.count; i++) {
+            MLNeuronLayer *layer= (MLNeuronLayer *) net.layers[i];
+            MLNeuronLayer *serialLayer= (MLNeuronLayer *) serialNet.layers[i];
+            
+            for (int j= 0; j < layer.size * layer.previousLayer.size; j++)
+                XCTAssertEqualWithAccuracy(layer.weights[j], serialLayer.weights[j], 0.0001);
+        }
+        
+        // With several workers, columns of unused inputs are never written
+        XCTAssertLessThan(parallelTrainer.batchCost, firstCost);
+        XCTAssertEqual(parallelLayer.weights[HOGWILD_TEST_INPUT_SIZE -1], unusedWeight);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testTrainer {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@2, @4, @1]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [MLRandom setSeed:42];
+        [net randomizeWeights];
+        
+        TrainerTestSource *source= [[TrainerTestSource alloc] init];
+        MLTrainer *trainer= [[MLTrainer alloc] initWithNetwork:net dataSource:source batchSize:TRAINER_TEST_BATCH_SIZE];
+        trainer.progressInterval= TRAINER_TEST_SAMPLES / 2;
+        
+        __block NSUInteger progressCalls= 0;
+        trainer.progressHandler= ^(NSUInteger epoch, NSUInteger trainedSamples, MLReal cost, double samplesPerSecond, NSTimeInterval eta) {
+            progressCalls++;
+        };
+        
+        __block MLReal firstCost= 0.0;
+        trainer.epochHandler= ^(NSUInteger epoch, MLReal cost) {
+            if (epoch == 1)
+                firstCost= cost;
+        };
+        
+        // Train for the max number of epochs, each reports progress twice
+        NSUInteger epochs= [trainer trainWithLearningRate:TRAINER_TEST_LEARNING_RATE maxEpochs:TRAINER_TEST_MAX_EPOCHS];
+        
+        XCTAssertEqual(epochs, TRAINER_TEST_MAX_EPOCHS);
+        XCTAssertEqual(progressCalls, 2 * TRAINER_TEST_MAX_EPOCHS);
+        XCTAssertLessThan(trainer.lastCost, firstCost);
+        
+        // Stop from the epoch handler
+        __weak MLTrainer *weakTrainer= trainer;
+        trainer.epochHandler= ^(NSUInteger epoch, MLReal cost) {
+            if (epoch == 2)
+                [weakTrainer stop];
+        };
+        
+        XCTAssertEqual([trainer trainWithLearningRate:TRAINER_TEST_LEARNING_RATE maxEpochs:TRAINER_TEST_MAX_EPOCHS], 2);
+        
+        // Stop by cost gain
+        trainer.epochHandler= nil;
+        trainer.gainCostLimit= 1.0;
+        
+        XCTAssertEqual([trainer trainWithLearningRate:TRAINER_TEST_LEARNING_RATE maxEpochs:TRAINER_TEST_MAX_EPOCHS], 2);
+        
+        // Exceptions of the data source are rethrown on the training thread
+        source.failingIndex= TRAINER_TEST_SAMPLES -1;
+        
+        XCTAssertThrows([trainer trainWithLearningRate:TRAINER_TEST_LEARNING_RATE maxEpochs:TRAINER_TEST_MAX_EPOCHS]);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testInferenceContexts {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@4, @6, @3]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeTanH
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        // Compute expected outputs with the network
+        MLReal *expectedOutputs= MLAllocRealBuffer(CONTEXT_TEST_SAMPLES * net.outputSize);
+        
+        for (int i= 0; i < CONTEXT_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++)
+                net.inputBuffer[j]= ((MLReal) ((i * (j +1)) % 7)) / 7.0;
+            
+            [net feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                expectedOutputs[i * net.outputSize + j]= net.outputBuffer[j];
+        }
+        
+        // Compute the same outputs concurrently, with one context per sample
+        MLReal *outputs= MLAllocRealBuffer(CONTEXT_TEST_SAMPLES * net.outputSize);
+        
+        dispatch_apply(CONTEXT_TEST_SAMPLES, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+            MLNeuralNetworkContext *context= [[MLNeuralNetworkContext alloc] initWithNetwork:net];
+            
+            for (int j= 0; j < context.inputSize; j++)
+                context.inputBuffer[j]= ((MLReal) ((i * (j +1)) % 7)) / 7.0;
+            
+            [context feedForward];
+            
+            for (int j= 0; j < context.outputSize; j++)
+                outputs[i * context.outputSize + j]= context.outputBuffer[j];
+        });
+        
+        for (int i= 0; i < CONTEXT_TEST_SAMPLES * net.outputSize; i++)
+            XCTAssertEqualWithAccuracy(outputs[i], expectedOutputs[i], 0.00001);
+        
+        // Check batch feed forward of a context
+        MLNeuralNetworkContext *context= [[MLNeuralNetworkContext alloc] initWithNetwork:net batchSize:CONTEXT_TEST_BATCH_SIZE];
+        
+        for (int i= 0; i < CONTEXT_TEST_BATCH_SIZE; i++) {
+            for (int j= 0; j < context.inputSize; j++)
+                context.batchInputBuffer[i * context.inputSize + j]= ((MLReal) ((i * (j +1)) % 7)) / 7.0;
+        }
+        
+        [context feedForwardBatchOfSize:CONTEXT_TEST_BATCH_SIZE];
+        
+        for (int i= 0; i < CONTEXT_TEST_BATCH_SIZE * context.outputSize; i++)
+            XCTAssertEqualWithAccuracy(context.batchOutputBuffer[i], expectedOutputs[i], 0.00001);
+        
+        // The network status must not be affected
+        XCTAssertEqual(net.status, MLNeuralNetworkStatusFeededForward);
+        
+        MLFreeRealBuffer(outputs);
+        MLFreeRealBuffer(expectedOutputs);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testInferencePlan {
+    @try {
+        
+        // First network has small layers with rectified linear activation,
+        // second one has layers large enough to be computed with BLAS
+        NSArray<NSArray<NSNumber *> *> *sizes= @[@[@4, @6, @5, @3], @[@64, @40, @10]];
+        NSArray<NSNumber *> *hiddenFuncTypes= @[@(MLActivationFunctionTypeRectifiedLinear), @(MLActivationFunctionTypeTanH)];
+        
+        for (int k= 0; k < sizes.count; k++) {
+            MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:sizes[k]
+                                                                      useBias:YES
+                                                             costFunctionType:MLCostFunctionTypeSquaredError
+                                                          backPropagationType:MLBackPropagationTypeStandard
+                                                           hiddenFunctionType:hiddenFuncTypes[k].unsignedIntegerValue
+                                                           outputFunctionType:MLActivationFunctionTypeSigmoid];
+            
+            [net randomizeWeights];
+            
+            MLInferencePlan *plan= MLInferencePlanCreate(net);
+            
+            XCTAssertEqual(MLInferencePlanInputSize(plan), net.inputSize);
+            XCTAssertEqual(MLInferencePlanOutputSize(plan), net.outputSize);
+            
+            MLReal *output= MLAllocRealBuffer(net.outputSize);
+            
+            // Outputs must match those of the network, computed
+            // both with the buffers of the plan and with external ones
+            for (int i= 0; i < PLAN_TEST_SAMPLES; i++) {
+                for (int j= 0; j < net.inputSize; j++) {
+                    MLReal value= ((MLReal) ((i * (j +1)) % 7)) / 7.0 - 0.5;
+                    
+                    net.inputBuffer[j]= value;
+                    MLInferencePlanInputBuffer(plan)[j]= value;
+                }
+                
+                [net feedForward];
+                
+                MLInferencePlanFeedForward(plan);
+                MLInferencePlanPredict(plan, net.inputBuffer, output);
+                
+                for (int j= 0; j < net.outputSize; j++) {
+                    XCTAssertEqualWithAccuracy(MLInferencePlanOutputBuffer(plan)[j], net.outputBuffer[j], PLAN_TEST_ACCURACY);
+                    XCTAssertEqualWithAccuracy(output[j], net.outputBuffer[j], PLAN_TEST_ACCURACY);
+                }
+            }
+            
+            // Weights are copied: the plan is not affected by later training
+            MLReal frozenOutput= output[0];
+            
+            [net randomizeWeights];
+            MLInferencePlanPredict(plan, net.inputBuffer, output);
+            
+            XCTAssertEqual(output[0], frozenOutput);
+            
+            NSDate *begin= [NSDate date];
+            
+            for (int i= 0; i < PLAN_TEST_SAMPLES; i++)
+                MLInferencePlanFeedForward(plan);
+            
+            NSTimeInterval elapsed= [[NSDate date] timeIntervalSinceDate:begin];
+            NSLog(@"testInferencePlan: average prediction time: %.2f µs", (elapsed * 1000000.0) / ((double) PLAN_TEST_SAMPLES));
+            
+            MLFreeRealBuffer(output);
+            MLInferencePlanFree(plan);
+        }
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testModelFile {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@5, @7, @3]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeTanH
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        NSString *path= [NSTemporaryDirectory() stringByAppendingPathComponent:@"MAChineLearningModelFileTest.mlnn"];
+        [net saveModelToFile:path];
+        
+        // Load the model by copy and by memory mapping
+        MLNeuralNetwork *copiedNet= [MLNeuralNetwork createNetworkFromModelFile:path];
+        MLNeuralNetwork *mappedNet= [MLNeuralNetwork createNetworkByMappingModelFile:path];
+        
+        XCTAssertFalse(copiedNet.readOnly);
+        XCTAssertTrue(mappedNet.readOnly);
+        
+        // Outputs must be identical
+        for (int i= 0; i < MODEL_FILE_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++) {
+                MLReal value= ((MLReal) ((i * (j +1)) % 5)) / 5.0;
+                
+                net.inputBuffer[j]= value;
+                copiedNet.inputBuffer[j]= value;
+                mappedNet.inputBuffer[j]= value;
+            }
+            
+            [net feedForward];
+            [copiedNet feedForward];
+            [mappedNet feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++) {
+                XCTAssertEqual(copiedNet.outputBuffer[j], net.outputBuffer[j]);
+                XCTAssertEqual(mappedNet.outputBuffer[j], net.outputBuffer[j]);
+            }
+        }
+        
+        // Weights of the mapped network can't be changed
+        XCTAssertThrowsSpecific([mappedNet randomizeWeights], MLNeuralNetworkException);
+        
+        // The copied network can still be trained
+        [copiedNet backPropagateWithLearningRate:0.1];
+        [copiedNet updateWeights];
+        
+        // A truncated file must be rejected
+        NSData *data= [NSData dataWithContentsOfFile:path];
+        [[data subdataWithRange:NSMakeRange(0, data.length / 2)] writeToFile:path atomically:YES];
+        
+        XCTAssertThrowsSpecific([MLNeuralNetwork createNetworkFromModelFile:path], MLNeuralNetworkException);
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testProfiling {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@3, @4, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        [net setUpBatchOfSize:PROFILE_TEST_BATCH_SIZE];
+        
+        XCTAssertNil(net.profile);
+        
+        [net enableProfilingWithMaxTraceEvents:PROFILE_TEST_TRACE_EVENTS];
+        
+        MLNeuralNetworkProfile *profile= net.profile;
+        XCTAssertNotNil(profile);
+        XCTAssertEqual(profile.layers, net.layers.count);
+        
+        for (int i= 0; i < PROFILE_TEST_BATCH_SIZE * net.inputSize; i++)
+            net.batchInputBuffer[i]= ((MLReal) (i % 7)) / 7.0;
+        
+        for (int i= 0; i < PROFILE_TEST_BATCH_SIZE * net.outputSize; i++)
+            net.batchExpectedOutputBuffer[i]= (i % 2 == 0) ? 1.0 : 0.0;
+        
+        for (int i= 0; i < PROFILE_TEST_TRAIN_CYCLES; i++) {
+            [net feedForwardBatchOfSize:PROFILE_TEST_BATCH_SIZE];
+            [net backPropagateBatchWithLearningRate:0.1];
+            [net updateWeights];
+        }
+        
+        NSLog(@"testProfiling: profile:\n%@", [profile report]);
+        
+        // Each neuron layer goes through each phase once per cycle,
+        // the input layer never does
+        for (int i= 0; i < net.layers.count; i++) {
+            for (MLProfilePhase phase= MLProfilePhaseFeedForward; phase <= MLProfilePhaseWeightsUpdate; phase++)
+                XCTAssertEqual([profile callsOfLayer:i phase:phase], (NSUInteger) ((i == 0) ? 0 : PROFILE_TEST_TRAIN_CYCLES));
+        }
+        
+        // FLOPs of the feed forward are those of the matrix multiplication
+        NSUInteger outputSize= net.layers[2].size;
+        NSUInteger inputSize= net.layers[1].size;
+        XCTAssertEqual([profile flopsOfLayer:2 phase:MLProfilePhaseFeedForward], (uint64_t) (PROFILE_TEST_TRAIN_CYCLES * 2 * PROFILE_TEST_BATCH_SIZE * outputSize * inputSize));
+        XCTAssertGreaterThan([profile bytesOfLayer:2 phase:MLProfilePhaseFeedForward], (uint64_t) 0);
+        XCTAssertGreaterThan([profile timeOfLayer:1 phase:MLProfilePhaseBackPropagation], 0.0);
+        
+        XCTAssertThrowsSpecific([profile callsOfLayer:net.layers.count phase:MLProfilePhaseFeedForward], MLNeuralNetworkException);
+        
+        // Trace events are capped and must form a valid Chrome trace
+        XCTAssertEqual(profile.traceEventCount, (NSUInteger) PROFILE_TEST_TRACE_EVENTS);
+        
+        NSDictionary *trace= [NSJSONSerialization JSONObjectWithData:[profile chromeTrace] options:0 error:nil];
+        NSArray *events= trace[@"traceEvents"];
+        XCTAssertEqual(events.count, (NSUInteger) PROFILE_TEST_TRACE_EVENTS);
+        XCTAssertEqualObjects(events[0][@"ph"], @"X");
+        XCTAssertEqualObjects(events[0][@"name"], @"feedForward");
+        
+        [profile reset];
+        
+        XCTAssertEqual([profile callsOfLayer:1 phase:MLProfilePhaseFeedForward], (NSUInteger) 0);
+        XCTAssertEqual(profile.traceEventCount, (NSUInteger) 0);
+        
+        // Once disabled, nothing is recorded anymore
+        [net disableProfiling];
+        XCTAssertNil(net.profile);
+        
+        [net feedForwardBatchOfSize:PROFILE_TEST_BATCH_SIZE];
+        
+        XCTAssertEqual([profile callsOfLayer:1 phase:MLProfilePhaseFeedForward], (NSUInteger) 0);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testQuantizedNetwork {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@20, @12, @4]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeTanH
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        MLQuantizedNeuralNetwork *quantizedNet= [[MLQuantizedNeuralNetwork alloc] initWithNetwork:net];
+        
+        XCTAssertEqual(quantizedNet.inputSize, net.inputSize);
+        XCTAssertEqual(quantizedNet.outputSize, net.outputSize);
+        
+        // Weights must take about a quarter of the memory
+        NSUInteger floatWeightsSize= ((13 * 20) + (4 * 13)) * sizeof(MLReal);
+        XCTAssertLessThan(quantizedNet.weightsMemorySize, floatWeightsSize / 2);
+        
+        // Outputs must stay close to those of the original network
+        MLReal *inputs= MLAllocRealBuffer(QUANTIZATION_TEST_SAMPLES * net.inputSize);
+        
+        for (int i= 0; i < QUANTIZATION_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++)
+                inputs[i * net.inputSize + j]= ((MLReal) ((i * (j +1)) % 9)) / 9.0;
+        }
+        
+        MLReal drift= [quantizedNet outputDriftFromNetwork:net inputBuffer:inputs samples:QUANTIZATION_TEST_SAMPLES];
+        XCTAssertLessThan(drift, QUANTIZATION_TEST_MAX_DRIFT);
+        
+        // The original network must not be affected
+        XCTAssertEqual(net.status, MLNeuralNetworkStatusIdle);
+        
+        MLFreeRealBuffer(inputs);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+- (void) testSparseInput {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@SPARSE_TEST_INPUT_SIZE, @10, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        // Clone the network, the clone will be trained with dense input
+        MLNeuralNetwork *denseNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        
+        int indices[SPARSE_TEST_NONZEROS];
+        MLReal values[SPARSE_TEST_NONZEROS];
+        
+        for (int cycle= 0; cycle < SPARSE_TEST_TRAIN_CYCLES; cycle++) {
+            ML_VCLR(denseNet.inputBuffer, 1, denseNet.inputSize);
+            
+            for (int i= 0; i < SPARSE_TEST_NONZEROS; i++) {
+                indices[i]= (cycle * 7 + i * 23) % SPARSE_TEST_INPUT_SIZE;
+                values[i]= ((MLReal) (i +1)) / SPARSE_TEST_NONZEROS;
+                
+                denseNet.inputBuffer[indices[i]]= values[i];
+            }
+            
+            [net feedForwardSparseInputWithIndices:indices values:values size:SPARSE_TEST_NONZEROS];
+            [denseNet feedForward];
+            
+            for (int i= 0; i < net.outputSize; i++)
+                XCTAssertEqualWithAccuracy(net.outputBuffer[i], denseNet.outputBuffer[i], 0.00001);
+            
+            net.expectedOutputBuffer[0]= 1.0;
+            net.expectedOutputBuffer[1]= 0.0;
+            denseNet.expectedOutputBuffer[0]= 1.0;
+            denseNet.expectedOutputBuffer[1]= 0.0;
+            
+            [net backPropagateWithLearningRate:SPARSE_TEST_LEARNING_RATE];
+            [denseNet backPropagateWithLearningRate:SPARSE_TEST_LEARNING_RATE];
+            
+            [net updateWeights];
+            [denseNet updateWeights];
+        }
+        
+        // Weights must be the same, including the untouched ones
+        for (int i= 1; i < net.layers.count; i++) {
+            MLNeuronLayer *layer= (MLNeuronLayer *) net.layers[i];
+            MLNeuronLayer *denseLayer= (MLNeuronLayer *) denseNet.layers[i];
+            
+            for (int j= 0; j < layer.size * layer.previousLayer.size; j++)
+                XCTAssertEqualWithAccuracy(layer.weights[j], denseLayer.weights[j], 0.00001);
+        }
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testAdaptiveOptimizers {
+    @try {
+        MLBackPropagationType backPropTypes[]= { MLBackPropagationTypeMomentum,
+                                                 MLBackPropagationTypeNesterov,
+                                                 MLBackPropagationTypeRMSProp,
+                                                 MLBackPropagationTypeAdam };
+        
+        for (int k= 0; k < 4; k++) {
+            MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@2, @4, @1]
+                                                                      useBias:YES
+                                                             costFunctionType:MLCostFunctionTypeSquaredError
+                                                          backPropagationType:backPropTypes[k]
+                                                           hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                           outputFunctionType:MLActivationFunctionTypeSigmoid];
+            
+            [MLRandom setSeed:42];
+            [net randomizeWeights];
+            
+            // Adaptive optimizers need a learning rate
+            XCTAssertThrowsSpecific([net backPropagate], MLNeuralNetworkException);
+            
+            // Clone the network, the clone will be trained sample by sample
+            MLNeuralNetwork *sampleNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+            
+            // Train on the NAND truth table as a single batch
+            [net setUpBatchOfSize:4];
+            
+            for (int i= 0; i < 4; i++) {
+                net.batchInputBuffer[i * 2]= (MLReal) (i / 2);
+                net.batchInputBuffer[i * 2 +1]= (MLReal) (i % 2);
+                net.batchExpectedOutputBuffer[i]= (i == 3) ? 0.0 : 1.0;
+            }
+            
+            MLReal firstCost= 0.0;
+            MLReal lastCost= 0.0;
+            for (int cycle= 0; cycle < OPTIMIZER_TEST_TRAIN_CYCLES; cycle++) {
+                [net feedForwardBatchOfSize:4];
+                
+                lastCost= net.batchCost;
+                if (cycle == 0)
+                    firstCost= lastCost;
+                
+                [net backPropagateBatchWithLearningRate:OPTIMIZER_TEST_LEARNING_RATE];
+                [net updateWeights];
+            }
+            
+            XCTAssertLessThan(lastCost, firstCost);
+            
+            // Train on the same table sample by sample
+            firstCost= 0.0;
+            lastCost= 0.0;
+            for (int cycle= 0; cycle < OPTIMIZER_TEST_TRAIN_CYCLES; cycle++) {
+                MLReal cost= 0.0;
+                
+                for (int i= 0; i < 4; i++) {
+                    sampleNet.inputBuffer[0]= (MLReal) (i / 2);
+                    sampleNet.inputBuffer[1]= (MLReal) (i % 2);
+                    sampleNet.expectedOutputBuffer[0]= (i == 3) ? 0.0 : 1.0;
+                    
+                    [sampleNet feedForward];
+                    cost += sampleNet.cost;
+                    
+                    [sampleNet backPropagateWithLearningRate:OPTIMIZER_TEST_LEARNING_RATE];
+                    [sampleNet updateWeights];
+                }
+                
+                lastCost= cost;
+                if (cycle == 0)
+                    firstCost= cost;
+            }
+            
+            XCTAssertLessThan(lastCost, firstCost);
+        }
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testAdaptiveOptimizerGradients {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@3, @4, @2]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeMomentum
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [MLRandom setSeed:42];
+        [net randomizeWeights];
+        
+        // Clone the network, the clone will be trained with a batch of one sample
+        MLNeuralNetwork *batchNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        [batchNet setUpBatchOfSize:1];
+        
+        for (int j= 0; j < net.inputSize; j++) {
+            net.inputBuffer[j]= 0.93 + 0.1 * j;
+            batchNet.batchInputBuffer[j]= 0.93 + 0.1 * j;
+        }
+        
+        net.expectedOutputBuffer[0]= 1.0;
+        net.expectedOutputBuffer[1]= 0.0;
+        batchNet.batchExpectedOutputBuffer[0]= 1.0;
+        batchNet.batchExpectedOutputBuffer[1]= 0.0;
+        
+        NSUInteger weightsCount= 0;
+        for (int i= 1; i < net.layers.count; i++)
+            weightsCount += ((MLNeuronLayer *) net.layers[i]).size * net.layers[i].previousLayer.size;
+        
+        MLReal *gradient= MLAllocRealBuffer(weightsCount);
+        MLReal *weights= MLAllocRealBuffer(weightsCount);
+        
+        [NeuralNetTests computeGradientOfNetwork:net gradient:gradient];
+        
+        for (int i= 1, k= 0; i < net.layers.count; i++) {
+            MLNeuronLayer *layer= (MLNeuronLayer *) net.layers[i];
+            
+            for (int j= 0; j < layer.size * layer.previousLayer.size; j++)
+                weights[k++]= layer.weights[j];
+        }
+        
+        // Train one step sample by sample and by batch
+        [net backPropagateWithLearningRate:OPTIMIZER_TEST_LEARNING_RATE];
+        [net updateWeights];
+        
+        [batchNet feedForwardBatchOfSize:1];
+        [batchNet backPropagateBatchWithLearningRate:OPTIMIZER_TEST_LEARNING_RATE];
+        [batchNet updateWeights];
+        
+        // With a zero initial velocity, the first step of momentum is the
+        // learning rate times the gradient, hidden layers included
+        for (int i= 1, k= 0; i < net.layers.count; i++) {
+            MLNeuronLayer *layer= (MLNeuronLayer *) net.layers[i];
+            MLNeuronLayer *batchLayer= (MLNeuronLayer *) batchNet.layers[i];
+            
+            for (int j= 0; j < layer.size * layer.previousLayer.size; j++, k++) {
+                XCTAssertEqualWithAccuracy((layer.weights[j] - weights[k]) / OPTIMIZER_TEST_LEARNING_RATE, gradient[k], GRADIENT_TEST_ACCURACY);
+                XCTAssertEqualWithAccuracy((batchLayer.weights[j] - weights[k]) / OPTIMIZER_TEST_LEARNING_RATE, gradient[k], GRADIENT_TEST_ACCURACY);
+            }
+        }
+        
+        MLFreeRealBuffer(gradient);
+        MLFreeRealBuffer(weights);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testImprovedResilientBackpropagation {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@2, @4, @1]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeImprovedResilient
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [MLRandom setSeed:42];
+        [net randomizeWeights];
+        
+        // RPROP makes no use of learning rate
+        XCTAssertThrowsSpecific([net backPropagateWithLearningRate:0.1], MLNeuralNetworkException);
+        
+        // Train on the whole NAND truth table as a single batch, i.e. full-batch iRPROP-
+        [net setUpBatchOfSize:4];
+        
+        for (int i= 0; i < 4; i++) {
+            net.batchInputBuffer[i * 2]= (MLReal) (i / 2);
+            net.batchInputBuffer[i * 2 +1]= (MLReal) (i % 2);
+            net.batchExpectedOutputBuffer[i]= (i == 3) ? 0.0 : 1.0;
+        }
+        
+        MLReal firstCost= 0.0;
+        MLReal lastCost= 0.0;
+        for (int epoch= 0; epoch < OPTIMIZER_TEST_IRPROP_EPOCHS; epoch++) {
+            [net feedForwardBatchOfSize:4];
+            
+            lastCost= net.batchCost;
+            if (epoch == 0)
+                firstCost= lastCost;
+            
+            [net backPropagateBatch];
+            [net updateWeights];
+        }
+        
+        XCTAssertLessThan(lastCost, firstCost);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testHalfWeightsStorage {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@5, @7, @3]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeTanH
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [net randomizeWeights];
+        
+        // Clone the network twice, with half and bfloat16 weights
+        MLNeuralNetwork *halfNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        halfNet.weightsStorageType= MLWeightsStorageTypeHalf;
+        
+        MLNeuralNetwork *bfloatNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        bfloatNet.weightsStorageType= MLWeightsStorageTypeBFloat16;
+        
+        XCTAssertEqual(halfNet.weightsStorageType, MLWeightsStorageTypeHalf);
+        XCTAssertEqual(bfloatNet.weightsStorageType, MLWeightsStorageTypeBFloat16);
+        
+        // Outputs must be close to those of the original network
+        for (int i= 0; i < HALF_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++) {
+                MLReal value= ((MLReal) ((i * (j +1)) % 5)) / 5.0;
+                
+                net.inputBuffer[j]= value;
+                halfNet.inputBuffer[j]= value;
+                bfloatNet.inputBuffer[j]= value;
+            }
+            
+            [net feedForward];
+            [halfNet feedForward];
+            [bfloatNet feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++) {
+                XCTAssertEqualWithAccuracy(halfNet.outputBuffer[j], net.outputBuffer[j], HALF_TEST_ACCURACY);
+                XCTAssertEqualWithAccuracy(bfloatNet.outputBuffer[j], net.outputBuffer[j], BFLOAT16_TEST_ACCURACY);
+            }
+        }
+        
+        // Training updates the master weights and their half-precision copy
+        for (int j= 0; j < halfNet.outputSize; j++)
+            halfNet.expectedOutputBuffer[j]= 0.5;
+        
+        [halfNet backPropagateWithLearningRate:0.1];
+        [halfNet updateWeights];
+        
+        MLNeuronLayer *layer= (MLNeuronLayer *) halfNet.layers[2];
+        NSUInteger weightsCount= layer.size * layer.previousLayer.size;
+        
+        MLNeuralNetwork *checkNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[halfNet saveConfigurationToDictionary]];
+        checkNet.weightsStorageType= MLWeightsStorageTypeHalf;
+        
+        MLNeuronLayer *checkLayer= (MLNeuronLayer *) checkNet.layers[2];
+        for (NSUInteger i= 0; i < weightsCount; i++)
+            XCTAssertEqual(layer.halfWeights[i], checkLayer.halfWeights[i]);
+        
+        // Half-precision models are saved with 16-bit weights
+        NSString *path= [NSTemporaryDirectory() stringByAppendingPathComponent:@"MAChineLearningHalfModelFileTest.mlnn"];
+        NSString *realPath= [NSTemporaryDirectory() stringByAppendingPathComponent:@"MAChineLearningRealModelFileTest.mlnn"];
+        [halfNet saveModelToFile:path];
+        [net saveModelToFile:realPath];
+        
+        NSUInteger halfLength= [NSData dataWithContentsOfFile:path].length;
+        NSUInteger realLength= [NSData dataWithContentsOfFile:realPath].length;
+        XCTAssertLessThan(halfLength, realLength);
+        
+        // Loading restores the storage type, with identical outputs
+        MLNeuralNetwork *loadedNet= [MLNeuralNetwork createNetworkFromModelFile:path];
+        XCTAssertEqual(loadedNet.weightsStorageType, MLWeightsStorageTypeHalf);
+        
+        for (int j= 0; j < halfNet.inputSize; j++) {
+            halfNet.inputBuffer[j]= 0.1 * j;
+            loadedNet.inputBuffer[j]= 0.1 * j;
+        }
+        
+        [halfNet feedForward];
+        [loadedNet feedForward];
+        
+        for (int j= 0; j < halfNet.outputSize; j++)
+            XCTAssertEqual(loadedNet.outputBuffer[j], halfNet.outputBuffer[j]);
+        
+        // Half-precision models can't be mapped
+        XCTAssertThrowsSpecific([MLNeuralNetwork createNetworkByMappingModelFile:path], MLNeuralNetworkException);
+        
+        // Master weights are saved only with real storage
+        halfNet.weightsStorageType= MLWeightsStorageTypeReal;
+        [halfNet saveModelToFile:path];
+        
+        MLNeuralNetwork *trainableNet= [MLNeuralNetwork createNetworkFromModelFile:path];
+        trainableNet.weightsStorageType= MLWeightsStorageTypeHalf;
+        
+        MLNeuronLayer *trainableLayer= (MLNeuronLayer *) trainableNet.layers[2];
+        for (NSUInteger i= 0; i < weightsCount; i++) {
+            XCTAssertEqual(trainableLayer.weights[i], layer.weights[i]);
+            XCTAssertEqual(trainableLayer.halfWeights[i], checkLayer.halfWeights[i]);
+        }
+        
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+        [[NSFileManager defaultManager] removeItemAtPath:realPath error:nil];
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testPruning {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@20, @16, @4]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [MLRandom setSeed:42];
+        [net randomizeWeights];
+        
+        XCTAssertThrowsSpecific([net pruneWithSparsity:1.0], MLNeuralNetworkException);
+        XCTAssertThrowsSpecific([net pruneLayersWithSparsities:@[@0.5]], MLNeuralNetworkException);
+        
+        // Prune with a global target
+        [net pruneWithSparsity:PRUNING_TEST_SPARSITY];
+        
+        XCTAssertEqualWithAccuracy(net.sparsity, PRUNING_TEST_SPARSITY, 0.01);
+        
+        for (int i= 1; i < net.layers.count; i++)
+            XCTAssertTrue(((MLNeuronLayer *) net.layers[i]).pruned);
+        
+        // Fine-tune for a few cycles, the mask must be kept
+        for (int cycle= 0; cycle < PRUNING_TEST_TRAIN_CYCLES; cycle++) {
+            for (int j= 0; j < net.inputSize; j++)
+                net.inputBuffer[j]= ((MLReal) ((cycle * (j +1)) % 7)) / 7.0;
+            
+            [net feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                net.expectedOutputBuffer[j]= (j == cycle % net.outputSize) ? 1.0 : 0.0;
+            
+            [net backPropagateWithLearningRate:0.1];
+            [net updateWeights];
+        }
+        
+        XCTAssertEqualWithAccuracy(net.sparsity, PRUNING_TEST_SPARSITY, 0.01);
+        
+        // Outputs of the sparse matrices must match those of a dense clone
+        MLNeuralNetwork *denseNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        
+        for (int i= 0; i < PRUNING_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++) {
+                MLReal value= ((MLReal) ((i * (j +1)) % 5)) / 5.0;
+                
+                net.inputBuffer[j]= value;
+                denseNet.inputBuffer[j]= value;
+            }
+            
+            [net feedForward];
+            [denseNet feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                XCTAssertEqualWithAccuracy(net.outputBuffer[j], denseNet.outputBuffer[j], 0.00001);
+        }
+        
+        // Prune with per-layer targets, then remove pruning
+        [denseNet pruneLayersWithSparsities:@[@0.9, @0.5]];
+        
+        XCTAssertEqualWithAccuracy(((MLNeuronLayer *) denseNet.layers[1]).sparsity, 0.9, 0.01);
+        XCTAssertEqualWithAccuracy(((MLNeuronLayer *) denseNet.layers[2]).sparsity, 0.5, 0.05);
+        
+        [denseNet removePruning];
+        
+        XCTAssertEqual(denseNet.sparsity, 0.0);
+        
+        // Fine-tune with adaptive optimizers, the optimizer state
+        // must not move pruned weights away from zero
+        MLBackPropagationType backPropTypes[]= { MLBackPropagationTypeMomentum,
+                                                 MLBackPropagationTypeAdam };
+        
+        for (int k= 0; k < 2; k++) {
+            MLNeuralNetwork *adaptiveNet= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@20, @16, @4]
+                                                                              useBias:YES
+                                                                     costFunctionType:MLCostFunctionTypeSquaredError
+                                                                  backPropagationType:backPropTypes[k]
+                                                                   hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                                   outputFunctionType:MLActivationFunctionTypeSigmoid];
+            
+            [MLRandom setSeed:42];
+            [adaptiveNet randomizeWeights];
+            
+            // Train before pruning too, so that the optimizer state is not zero
+            for (int phase= 0; phase < 2; phase++) {
+                for (int cycle= 0; cycle < PRUNING_TEST_TRAIN_CYCLES; cycle++) {
+                    for (int j= 0; j < adaptiveNet.inputSize; j++)
+                        adaptiveNet.inputBuffer[j]= ((MLReal) ((cycle * (j +1)) % 7)) / 7.0;
+                    
+                    [adaptiveNet feedForward];
+                    
+                    for (int j= 0; j < adaptiveNet.outputSize; j++)
+                        adaptiveNet.expectedOutputBuffer[j]= (j == cycle % adaptiveNet.outputSize) ? 1.0 : 0.0;
+                    
+                    [adaptiveNet backPropagateWithLearningRate:OPTIMIZER_TEST_LEARNING_RATE];
+                    [adaptiveNet updateWeights];
+                }
+                
+                if (phase == 0)
+                    [adaptiveNet pruneWithSparsity:PRUNING_TEST_SPARSITY];
+            }
+            
+            XCTAssertEqualWithAccuracy(adaptiveNet.sparsity, PRUNING_TEST_SPARSITY, 0.01);
+            
+            // Weights pruned by the mask must still be exactly zero
+            for (int i= 1; i < adaptiveNet.layers.count; i++) {
+                MLNeuronLayer *layer= (MLNeuronLayer *) adaptiveNet.layers[i];
+                NSUInteger weightsCount= (layer.size -1) * layer.previousLayer.size;
+                
+                // Bias row excluded
+                NSUInteger zeros= 0;
+                for (NSUInteger j= 0; j < weightsCount; j++)
+                    zeros += (layer.weights[j] == 0.0) ? 1 : 0;
+                
+                XCTAssertEqual(zeros, weightsCount - layer.nonzeroWeightsCount);
+            }
+        }
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testLowRankFactorization {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@20, @16, @4]
+                                                                  useBias:YES
+                                                         costFunctionType:MLCostFunctionTypeSquaredError
+                                                      backPropagationType:MLBackPropagationTypeStandard
+                                                       hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                       outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [MLRandom setSeed:42];
+        [net randomizeWeights];
+        
+        MLNeuronLayer *layer= (MLNeuronLayer *) net.layers[1];
+        
+        XCTAssertThrowsSpecific([layer factorizeWithRank:0], MLNeuralNetworkException);
+        XCTAssertThrowsSpecific([layer factorizeWithRank:17], MLNeuralNetworkException);
+        XCTAssertThrowsSpecific([net factorizeLayersWithRanks:@[@8]], MLNeuralNetworkException);
+        
+        // A full-rank factorization must reproduce the original weights
+        MLNeuralNetwork *denseNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        
+        [layer factorizeWithRank:16];
+        
+        XCTAssertTrue(layer.factorized);
+        XCTAssertEqualWithAccuracy(layer.factorizationError, 0.0, 0.0001);
+        XCTAssertEqual(layer.singularValues.count, (NSUInteger) 16);
+        
+        for (int i= 1; i < layer.singularValues.count; i++)
+            XCTAssertLessThanOrEqual(layer.singularValues[i].doubleValue, layer.singularValues[i -1].doubleValue);
+        
+        for (int i= 0; i < FACTORIZATION_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++) {
+                MLReal value= ((MLReal) ((i * (j +1)) % 5)) / 5.0;
+                
+                net.inputBuffer[j]= value;
+                denseNet.inputBuffer[j]= value;
+            }
+            
+            [net feedForward];
+            [denseNet feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                XCTAssertEqualWithAccuracy(net.outputBuffer[j], denseNet.outputBuffer[j], 0.0001);
+        }
+        
+        // A truncated factorization is smaller, and its outputs must
+        // match those of a dense clone with the truncated weights
+        [net factorizeLayersWithRanks:@[@(FACTORIZATION_TEST_RANK), @0]];
+        
+        XCTAssertEqual(layer.factorizationRank, (NSUInteger) FACTORIZATION_TEST_RANK);
+        XCTAssertEqual(layer.factorizedWeightsCount, (NSUInteger) (FACTORIZATION_TEST_RANK * (16 + 20)));
+        XCTAssertGreaterThan(layer.factorizationError, 0.0);
+        XCTAssertLessThan(layer.factorizationError, 1.0);
+        XCTAssertFalse(((MLNeuronLayer *) net.layers[2]).factorized);
+        
+        XCTAssertThrowsSpecific([layer updateWeights], MLNeuralNetworkException);
+        XCTAssertThrowsSpecific([layer pruneWithSparsity:0.5], MLNeuralNetworkException);
+        
+        MLNeuralNetwork *truncatedNet= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        
+        for (int i= 0; i < FACTORIZATION_TEST_SAMPLES; i++) {
+            for (int j= 0; j < net.inputSize; j++) {
+                MLReal value= ((MLReal) ((i * (j +3)) % 7)) / 7.0;
+                
+                net.inputBuffer[j]= value;
+                truncatedNet.inputBuffer[j]= value;
+            }
+            
+            [net feedForward];
+            [truncatedNet feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                XCTAssertEqualWithAccuracy(net.outputBuffer[j], truncatedNet.outputBuffer[j], 0.0001);
+        }
+        
+        // Factorize by error: each layer is either within the error or dense
+        [denseNet factorizeWithMaxError:FACTORIZATION_TEST_MAX_ERROR];
+        
+        for (int i= 1; i < denseNet.layers.count; i++) {
+            MLNeuronLayer *denseLayer= (MLNeuronLayer *) denseNet.layers[i];
+            
+            if (denseLayer.factorized) {
+                XCTAssertLessThanOrEqual(denseLayer.factorizationError, FACTORIZATION_TEST_MAX_ERROR);
+                XCTAssertLessThan(denseLayer.factorizedWeightsCount, (denseLayer.usingBias ? (denseLayer.size -1) : denseLayer.size) * denseLayer.previousLayer.size);
+            }
+        }
+        
+        XCTAssertTrue([[denseNet factorizationReport] containsString:@"Total"]);
+        
+        [denseNet removeFactorization];
+        
+        for (int i= 1; i < denseNet.layers.count; i++)
+            XCTAssertFalse(((MLNeuronLayer *) denseNet.layers[i]).factorized);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testEmbeddingInputLayer {
+    @try {
+        MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithVocabularySize:EMBEDDING_TEST_VOCABULARY_SIZE
+                                                         embeddingPoolingType:MLEmbeddingPoolingTypeMean
+                                                                   layerSizes:@[@EMBEDDING_TEST_SIZE, @6, @2]
+                                                                      useBias:YES
+                                                             costFunctionType:MLCostFunctionTypeSquaredError
+                                                          backPropagationType:MLBackPropagationTypeStandard
+                                                           hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                           outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        [MLRandom setSeed:42];
+        [net randomizeWeights];
+        
+        MLEmbeddingLayer *embeddingLayer= net.embeddingLayer;
+        XCTAssertNotNil(embeddingLayer);
+        XCTAssertEqual(net.inputSize, (NSUInteger) EMBEDDING_TEST_SIZE);
+        
+        // Initialize part of the embeddings from word vectors
+        MLReal vec[EMBEDDING_TEST_SIZE]= { 0.1, -0.2, 0.3, -0.4 };
+        MLWordVector *vector= [[MLWordVector alloc] initWithVector:vec size:EMBEDDING_TEST_SIZE freeVectorOnDealloc:NO];
+        MLWordVectorDictionary *vectorDictionary= [[MLWordVectorDictionary alloc] initWithDictionary:[@{@"alpha": vector} mutableCopy]];
+        
+        MLWordDictionary *wordDictionary= [[MLWordDictionary alloc] initWithWordInfos:@[[[MLWordInfo alloc] initWithWord:@"alpha" position:0],
+                                                                                      [[MLWordInfo alloc] initWithWord:@"beta" position:1]]];
+        
+        XCTAssertEqual([embeddingLayer loadEmbeddingsFromWordVectorDictionary:vectorDictionary wordDictionary:wordDictionary], (NSUInteger) 1);
+        
+        NSUInteger alphaPosition= [wordDictionary infoForWord:@"alpha"].position;
+        for (int j= 0; j < EMBEDDING_TEST_SIZE; j++)
+            XCTAssertEqual(embeddingLayer.embeddings[alphaPosition * EMBEDDING_TEST_SIZE + j], vec[j]);
+        
+        // Pooling must average the rows of fed words, repeated words included
+        int positions[]= { 1, 3, 3 };
+        [net feedForwardWordPositions:positions count:3];
+        
+        for (int j= 0; j < EMBEDDING_TEST_SIZE; j++) {
+            MLReal mean= (embeddingLayer.embeddings[1 * EMBEDDING_TEST_SIZE + j] + 2.0 * embeddingLayer.embeddings[3 * EMBEDDING_TEST_SIZE + j]) / 3.0;
+            XCTAssertEqualWithAccuracy(net.inputBuffer[j], mean, 0.000001);
+        }
+        
+        int wrongPositions[]= { 1, EMBEDDING_TEST_VOCABULARY_SIZE };
+        XCTAssertThrowsSpecific([net feedForwardWordPositions:wrongPositions count:2], MLNeuralNetworkException);
+        
+        // Train to tell apart two documents, rows of unused words must not change
+        MLReal unusedRow[EMBEDDING_TEST_SIZE];
+        for (int j= 0; j < EMBEDDING_TEST_SIZE; j++)
+            unusedRow[j]= embeddingLayer.embeddings[9 * EMBEDDING_TEST_SIZE + j];
+        
+        int document1[]= { 0, 1, 2 };
+        int document2[]= { 5, 6, 7 };
+        
+        for (int cycle= 0; cycle < EMBEDDING_TEST_TRAIN_CYCLES; cycle++) {
+            BOOL first= (cycle % 2 == 0);
+            
+            [net feedForwardWordPositions:(first ? document1 : document2) count:3];
+            
+            net.expectedOutputBuffer[0]= first ? 1.0 : 0.0;
+            net.expectedOutputBuffer[1]= first ? 0.0 : 1.0;
+            
+            [net backPropagateWithLearningRate:EMBEDDING_TEST_LEARNING_RATE];
+            [net updateWeights];
+        }
+        
+        for (int j= 0; j < EMBEDDING_TEST_SIZE; j++)
+            XCTAssertEqual(embeddingLayer.embeddings[9 * EMBEDDING_TEST_SIZE + j], unusedRow[j]);
+        
+        [net feedForwardWordPositions:document1 count:3];
+        XCTAssertGreaterThan(net.outputBuffer[0], net.outputBuffer[1]);
+        
+        [net feedForwardWordPositions:document2 count:3];
+        XCTAssertGreaterThan(net.outputBuffer[1], net.outputBuffer[0]);
+        
+        // Embeddings must survive a configuration round trip
+        MLNeuralNetwork *net2= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+        
+        XCTAssertEqual(net2.embeddingLayer.vocabularySize, (NSUInteger) EMBEDDING_TEST_VOCABULARY_SIZE);
+        XCTAssertEqual(net2.embeddingLayer.poolingType, MLEmbeddingPoolingTypeMean);
+        
+        [net2 feedForwardWordPositions:document2 count:3];
+        
+        for (int j= 0; j < net.outputSize; j++)
+            XCTAssertEqualWithAccuracy(net2.outputBuffer[j], net.outputBuffer[j], 0.000001);
+        
+        // Batch training requires frozen embeddings
+        [net2 setUpBatchOfSize:2];
+        [net2 feedForwardBatchOfSize:2];
+        
+        XCTAssertThrowsSpecific([net2 backPropagateBatchWithLearningRate:EMBEDDING_TEST_LEARNING_RATE], MLNeuralNetworkException);
+        
+        // Plain networks don't take word positions
+        MLNeuralNetwork *plainNet= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@4, @2]
+                                                                       useBias:NO
+                                                              costFunctionType:MLCostFunctionTypeSquaredError
+                                                           backPropagationType:MLBackPropagationTypeStandard
+                                                            hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                            outputFunctionType:MLActivationFunctionTypeSigmoid];
+        
+        XCTAssertNil(plainNet.embeddingLayer);
+        XCTAssertThrowsSpecific([plainNet feedForwardWordPositions:document1 count:3], MLNeuralNetworkException);
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+- (void) testSoftmaxOutput {
+    @try {
+        XCTAssertThrowsSpecific([[MLNeuralNetwork alloc] initWithLayerSizes:@[@8, @12, @8]
+                                                                    useBias:YES
+                                                           costFunctionType:MLCostFunctionTypeCrossEntropy
+                                                        backPropagationType:MLBackPropagationTypeStandard
+                                                         hiddenFunctionType:MLActivationFunctionTypeSoftmax
+                                                         outputFunctionType:MLActivationFunctionTypeSoftmax], MLNeuralNetworkException);
+        
+        XCTAssertThrowsSpecific([[MLNeuralNetwork alloc] initWithLayerSizes:@[@8, @12, @8]
+                                                                    useBias:YES
+                                                           costFunctionType:MLCostFunctionTypeSquaredError
+                                                        backPropagationType:MLBackPropagationTypeStandard
+                                                         hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                         outputFunctionType:MLActivationFunctionTypeSoftmax], MLNeuralNetworkException);
+        
+        NSArray<NSNumber *> *classCounts= @[@40, @20, @10, @8, @6, @4, @2, @1];
+        
+        for (MLSoftmaxTrainingType trainingType= MLSoftmaxTrainingTypeFull; trainingType <= MLSoftmaxTrainingTypeHierarchical; trainingType++) {
+            MLNeuralNetwork *net= [[MLNeuralNetwork alloc] initWithLayerSizes:@[@(SOFTMAX_TEST_CLASSES), @12, @(SOFTMAX_TEST_CLASSES)]
+                                                                      useBias:YES
+                                                             costFunctionType:MLCostFunctionTypeCrossEntropy
+                                                          backPropagationType:MLBackPropagationTypeStandard
+                                                           hiddenFunctionType:MLActivationFunctionTypeSigmoid
+                                                           outputFunctionType:MLActivationFunctionTypeSoftmax];
+            
+            [MLRandom setSeed:42];
+            [net randomizeWeights];
+            
+            switch (trainingType) {
+                case MLSoftmaxTrainingTypeSampled:
+                    XCTAssertThrowsSpecific([net setUpSampledSoftmaxWithSamples:0 classCounts:classCounts], MLNeuralNetworkException);
+                    XCTAssertThrowsSpecific([net setUpSampledSoftmaxWithSamples:SOFTMAX_TEST_SAMPLES classCounts:@[@1, @2]], MLNeuralNetworkException);
+                    
+                    [net setUpSampledSoftmaxWithSamples:SOFTMAX_TEST_SAMPLES classCounts:classCounts];
+                    break;
+                    
+                case MLSoftmaxTrainingTypeHierarchical:
+                    [net setUpHierarchicalSoftmaxWithClassCounts:classCounts];
+                    break;
+                    
+                default:
+                    break;
+            }
+            
+            XCTAssertEqual(net.softmaxTrainingType, trainingType);
+            
+            // Train to tell apart one-hot inputs, skipping the
+            // output layer when it is not needed
+            net.skipOutputLayer= (trainingType != MLSoftmaxTrainingTypeFull);
+            
+            for (int cycle= 0; cycle < SOFTMAX_TEST_TRAIN_CYCLES; cycle++) {
+                for (int i= 0; i < SOFTMAX_TEST_CLASSES; i++) {
+                    ML_VCLR(net.inputBuffer, 1, net.inputSize);
+                    net.inputBuffer[i]= 1.0;
+                    
+                    [net feedForward];
+                    
+                    if (trainingType != MLSoftmaxTrainingTypeFull)
+                        XCTAssertThrowsSpecific([net backPropagateWithLearningRate:SOFTMAX_TEST_LEARNING_RATE], MLNeuralNetworkException);
+                    
+                    [net backPropagateClass:i learningRate:SOFTMAX_TEST_LEARNING_RATE];
+                    [net updateWeights];
+                    
+                    XCTAssertGreaterThanOrEqual(net.classCost, 0.0);
+                }
+            }
+            
+            // Outputs must be probabilities, and top classes must
+            // be those of the outputs sorted in decreasing order
+            net.skipOutputLayer= NO;
+            
+            for (int i= 0; i < SOFTMAX_TEST_CLASSES; i++) {
+                ML_VCLR(net.inputBuffer, 1, net.inputSize);
+                net.inputBuffer[i]= 1.0;
+                
+                [net feedForward];
+                
+                MLReal sum= 0.0;
+                for (int j= 0; j < net.outputSize; j++)
+                    sum += net.outputBuffer[j];
+                
+                XCTAssertEqualWithAccuracy(sum, 1.0, 0.0001);
+                
+                int indices[3];
+                MLReal probabilities[3];
+                XCTAssertEqual([net computeTopClasses:3 indices:indices probabilities:probabilities], (NSUInteger) 3);
+                XCTAssertEqual(indices[0], i);
+                
+                for (int j= 0; j < 3; j++) {
+                    XCTAssertEqualWithAccuracy(probabilities[j], net.outputBuffer[indices[j]], 0.0001);
+                    
+                    if (j > 0)
+                        XCTAssertLessThanOrEqual(probabilities[j], probabilities[j -1]);
+                }
+                
+                for (int j= 0; j < net.outputSize; j++)
+                    XCTAssertLessThanOrEqual(net.outputBuffer[j], probabilities[0] + 0.0001);
+                
+                // Cost is the cross entropy of the one-hot class
+                ML_VCLR(net.expectedOutputBuffer, 1, net.outputSize);
+                net.expectedOutputBuffer[i]= 1.0;
+                
+                XCTAssertEqualWithAccuracy(net.cost, -log(net.outputBuffer[i]), 0.0001);
+            }
+            
+            // Approximation must survive a configuration round trip
+            MLNeuralNetwork *net2= [MLNeuralNetwork createNetworkFromConfigurationDictionary:[net saveConfigurationToDictionary]];
+            XCTAssertEqual(net2.softmaxTrainingType, trainingType);
+            
+            for (int j= 0; j < net.inputSize; j++)
+                net2.inputBuffer[j]= net.inputBuffer[j];
+            
+            [net2 feedForward];
+            
+            for (int j= 0; j < net.outputSize; j++)
+                XCTAssertEqualWithAccuracy(net2.outputBuffer[j], net.outputBuffer[j], 0.000001);
+            
+            if (trainingType == MLSoftmaxTrainingTypeHierarchical) {
+                
+                // Weights belong to the tree, they can't be used otherwise
+                XCTAssertThrowsSpecific([net removeSoftmaxApproximation], MLNeuralNetworkException);
+                XCTAssertThrowsSpecific(MLInferencePlanCreate(net), MLNeuralNetworkException);
+                
+                [net setUpBatchOfSize:2];
+                XCTAssertThrowsSpecific([net feedForwardBatchOfSize:2], MLNeuralNetworkException);
+                
+            } else {
+                [net removeSoftmaxApproximation];
+                XCTAssertEqual(net.softmaxTrainingType, MLSoftmaxTrainingTypeFull);
+            }
+        }
+        
+    } @catch (NSException *e) {
+        XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+    }
+}
+
+
+#pragma mark -
+#pragma mark Utility methods
+
++ (void) computeGradientOfNetwork:(MLNeuralNetwork *)net gradient:(MLReal *)gradient {
+    
+    // Gradient of the cost with central finite differences, one weight at a time,
+    // with the sign of the weights delta: gradient = -dCost/dWeight
+    for (int i= 1, k= 0; i < net.layers.count; i++) {
+        MLNeuronLayer *layer= (MLNeuronLayer *) net.layers[i];
+        
+        for (int j= 0; j < layer.size * layer.previousLayer.size; j++, k++) {
+            MLReal weight= layer.weights[j];
+            
+            layer.weights[j]= weight + GRADIENT_TEST_EPSILON;
+            [net feedForward];
+            MLReal costPlus= net.cost;
+            
+            layer.weights[j]= weight - GRADIENT_TEST_EPSILON;
+            [net feedForward];
+            MLReal costMinus= net.cost;
+            
+            layer.weights[j]= weight;
+            gradient[k]= (costMinus - costPlus) / (2.0 * GRADIENT_TEST_EPSILON);
+        }
+    }
+    
+    // Leave the network fed forward with its own weights
+    [net feedForward];
+}
+
+
 @end
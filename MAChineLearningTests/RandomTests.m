@@ -42,6 +42,9 @@
 
 #define UNIFORM_TEST_SIZE              (1000)
 #define GAUSSIAN_TEST_SIZE             (1000)
+#define SEED_TEST_SIZE                  (100)
+#define SEED_TEST_STREAMS                 (4)
+#define LARGE_GAUSSIAN_TEST_SIZE    (3000000)
 
 #define DUMP_INTERVALS                  (100)
 
@@ -164,6 +167,117 @@
 	}
 }
 
+- (void) testSeeding {
+	@try {
+		MLReal *sequence1= MLAllocRealBuffer(SEED_TEST_SIZE);
+		MLReal *sequence2= MLAllocRealBuffer(SEED_TEST_SIZE);
+		
+		// The same seed must produce the same randoms
+		[MLRandom setSeed:42];
+		[MLRandom fillVector:sequence1 size:SEED_TEST_SIZE ofGaussianRealsWithMean:0.0 sigma:1.0];
+		NSUInteger value1= [MLRandom nextUniformUInt];
+		
+		[MLRandom setSeed:42];
+		[MLRandom fillVector:sequence2 size:SEED_TEST_SIZE ofGaussianRealsWithMean:0.0 sigma:1.0];
+		NSUInteger value2= [MLRandom nextUniformUInt];
+		
+		XCTAssertEqual(value1, value2);
+		for (int i= 0; i < SEED_TEST_SIZE; i++)
+			XCTAssertEqual(sequence1[i], sequence2[i]);
+		
+		// Different streams of the same seed must differ
+		[MLRandom setSeed:42 stream:1];
+		[MLRandom fillVector:sequence2 size:SEED_TEST_SIZE ofGaussianRealsWithMean:0.0 sigma:1.0];
+		
+		int equals= 0;
+		for (int i= 0; i < SEED_TEST_SIZE; i++)
+			equals += (sequence1[i] == sequence2[i]) ? 1 : 0;
+		
+		XCTAssertLessThan(equals, SEED_TEST_SIZE / 10);
+		
+		// Streams seeded on different threads must be reproducible
+		MLReal *results= MLAllocRealBuffer(SEED_TEST_STREAMS * SEED_TEST_SIZE);
+		MLReal *expected= MLAllocRealBuffer(SEED_TEST_STREAMS * SEED_TEST_SIZE);
+		
+		for (int i= 0; i < SEED_TEST_STREAMS; i++) {
+			[MLRandom setSeed:7 stream:i];
+			[MLRandom fillVector:&expected[i * SEED_TEST_SIZE] size:SEED_TEST_SIZE ofUniformRealsWithMin:0.0 max:1.0];
+		}
+		
+		dispatch_apply(SEED_TEST_STREAMS, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+			[MLRandom setSeed:7 stream:i];
+			[MLRandom fillVector:&results[i * SEED_TEST_SIZE] size:SEED_TEST_SIZE ofUniformRealsWithMin:0.0 max:1.0];
+		});
+		
+		for (int i= 0; i < SEED_TEST_STREAMS * SEED_TEST_SIZE; i++)
+			XCTAssertEqual(results[i], expected[i]);
+		
+		// Bounded randoms must stay within bounds
+		for (int i= 0; i < SEED_TEST_SIZE; i++)
+			XCTAssertLessThan([MLRandom nextUniformUIntWithMax:7], 7);
+		
+		// Degenerate ranges must not fail
+		XCTAssertEqual([MLRandom nextUniformUIntWithMax:1], 0);
+		XCTAssertEqual([MLRandom nextUniformUIntWithMax:0], 0);
+		
+		MLFreeRealBuffer(sequence1);
+		MLFreeRealBuffer(sequence2);
+		MLFreeRealBuffer(results);
+		MLFreeRealBuffer(expected);
+		
+	} @catch (NSException *e) {
+		XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+	}
+}
+
+- (void) testLargeGaussian {
+	@try {
+		MLReal *distribution= MLAllocRealBuffer(LARGE_GAUSSIAN_TEST_SIZE);
+		
+		// Large vectors are filled concurrently, in chunks
+		[MLRandom setSeed:42];
+		[MLRandom fillVector:distribution size:LARGE_GAUSSIAN_TEST_SIZE ofGaussianRealsWithMean:1.0 sigma:2.0];
+		
+		double sum= 0.0;
+		for (int i= 0; i < LARGE_GAUSSIAN_TEST_SIZE; i++)
+			sum += distribution[i];
+		
+		double mean= sum / ((double) LARGE_GAUSSIAN_TEST_SIZE);
+		
+		double variance= 0.0;
+		int beyondThreeSigmas= 0;
+		for (int i= 0; i < LARGE_GAUSSIAN_TEST_SIZE; i++) {
+			variance += (distribution[i] - mean) * (distribution[i] - mean);
+			
+			if (fabs(distribution[i] - 1.0) > 6.0)
+				beyondThreeSigmas++;
+		}
+		
+		variance /= ((double) LARGE_GAUSSIAN_TEST_SIZE);
+		
+		XCTAssertEqualWithAccuracy(mean, 1.0, 0.01);
+		XCTAssertEqualWithAccuracy(sqrt(variance), 2.0, 0.01);
+		
+		// About 0.27% of samples lie beyond 3 sigmas
+		XCTAssertEqualWithAccuracy(((double) beyondThreeSigmas) / ((double) LARGE_GAUSSIAN_TEST_SIZE), 0.0027, 0.0003);
+		
+		// The result must not depend on thread scheduling
+		MLReal first= distribution[0];
+		MLReal last= distribution[LARGE_GAUSSIAN_TEST_SIZE -1];
+		
+		[MLRandom setSeed:42];
+		[MLRandom fillVector:distribution size:LARGE_GAUSSIAN_TEST_SIZE ofGaussianRealsWithMean:1.0 sigma:2.0];
+		
+		XCTAssertEqual(distribution[0], first);
+		XCTAssertEqual(distribution[LARGE_GAUSSIAN_TEST_SIZE -1], last);
+		
+		MLFreeRealBuffer(distribution);
+		
+	} @catch (NSException *e) {
+		XCTFail(@"Exception caught while testing: %@, reason: '%@', user info: %@\nStack trace:%@", e.name, e.reason, e.userInfo, e.callStackSymbols);
+	}
+}
+
 
 #pragma mark -
 #pragma mark Utility methods
@@ -0,0 +1,240 @@
+//
+//  VectorKernelTests.m
+//  MAChineLearning
+//
+//  Created by Gianluca Bertani on 17/10/2026.
+//  Copyright © 2026 Gianluca Bertani. All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions
+//  are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//  * Neither the name of Gianluca Bertani nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+//  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+//  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+//  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+//  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+//  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+//  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#if TARGET_OS_MAC
+#import <Cocoa/Cocoa.h>
+#else // !TARGET_OS_MAC
+#import <Foundation/Foundation.h>
+#endif // TARGET_OS_MAC
+
+#import <XCTest/XCTest.h>
+#import <MAChineLearning/MAChineLearning.h>
+
+#define ELEMENTWISE_TEST_MAX_SIZE     (100)
+#define ELEMENTWISE_TEST_ACCURACY     (0.00001)
+
+#define MATRIX_TEST_M                 (13)
+#define MATRIX_TEST_N                 (21)
+#define MATRIX_TEST_K                 (35)
+#define MATRIX_TEST_ACCURACY          (0.0001)
+
+
+#pragma mark -
+#pragma mark VectorKernelTests declaration
+
+@interface VectorKernelTests : XCTestCase
+
+
+#pragma mark -
+#pragma mark Utility methods
+
++ (void) fillBuffer:(float *)buffer size:(NSUInteger)size seed:(unsigned int)seed;
+
+
+@end
+
+
+#pragma mark -
+#pragma mark VectorKernelTests implementation
+
+@implementation VectorKernelTests
+
+
+#pragma mark -
+#pragma mark Setup and tear down
+
+- (void) setUp {
+    [super setUp];
+}
+
+- (void) tearDown {
+    [super tearDown];
+}
+
+
+#pragma mark -
+#pragma mark Tests
+
+- (void) testElementwiseKernels {
+    NSLog(@"Portable kernels instruction set: %s", MLVKInstructionSet());
+    
+    float a[ELEMENTWISE_TEST_MAX_SIZE], b[ELEMENTWISE_TEST_MAX_SIZE], c[ELEMENTWISE_TEST_MAX_SIZE];
+    float scalar= 0.75f;
+    
+    // Check every size up to the maximum, so that
+    // all vector widths and remainders are exercised
+    for (int n= 0; n <= ELEMENTWISE_TEST_MAX_SIZE; n++) {
+        [VectorKernelTests fillBuffer:a size:n seed:n];
+        [VectorKernelTests fillBuffer:b size:n seed:n + 1000];
+        
+        MLVK_vadd(a, 1, b, 1, c, 1, n);
+        for (int i= 0; i < n; i++)
+            XCTAssertEqualWithAccuracy(c[i], a[i] + b[i], ELEMENTWISE_TEST_ACCURACY);
+        
+        MLVK_vsub(a, 1, b, 1, c, 1, n);
+        for (int i= 0; i < n; i++)
+            XCTAssertEqualWithAccuracy(c[i], b[i] - a[i], ELEMENTWISE_TEST_ACCURACY);
+        
+        MLVK_vmul(a, 1, b, 1, c, 1, n);
+        for (int i= 0; i < n; i++)
+            XCTAssertEqualWithAccuracy(c[i], a[i] * b[i], ELEMENTWISE_TEST_ACCURACY);
+        
+        MLVK_vsmul(a, 1, &scalar, c, 1, n);
+        for (int i= 0; i < n; i++)
+            XCTAssertEqualWithAccuracy(c[i], a[i] * scalar, ELEMENTWISE_TEST_ACCURACY);
+        
+        // In-place multiply-add takes the axpy path
+        for (int i= 0; i < n; i++)
+            c[i]= b[i];
+        
+        MLVK_vsma(a, 1, &scalar, c, 1, c, 1, n);
+        for (int i= 0; i < n; i++)
+            XCTAssertEqualWithAccuracy(c[i], (a[i] * scalar) + b[i], ELEMENTWISE_TEST_ACCURACY);
+        
+        float dot= 0.0f, refDot= 0.0f;
+        MLVK_dotpr(a, 1, b, 1, &dot, n);
+        for (int i= 0; i < n; i++)
+            refDot += a[i] * b[i];
+        
+        XCTAssertEqualWithAccuracy(dot, refDot, ELEMENTWISE_TEST_ACCURACY * (n +1));
+        
+        float sumsq= 0.0f, refSumsq= 0.0f;
+        MLVK_svesq(a, 1, &sumsq, n);
+        for (int i= 0; i < n; i++)
+            refSumsq += a[i] * a[i];
+        
+        XCTAssertEqualWithAccuracy(sumsq, refSumsq, ELEMENTWISE_TEST_ACCURACY * (n +1));
+    }
+    
+    // Check strided access on the scalar path
+    [VectorKernelTests fillBuffer:a size:ELEMENTWISE_TEST_MAX_SIZE seed:1];
+    [VectorKernelTests fillBuffer:b size:ELEMENTWISE_TEST_MAX_SIZE seed:2];
+    
+    MLVK_vadd(a, 2, b, 2, c, 2, ELEMENTWISE_TEST_MAX_SIZE / 2);
+    for (int i= 0; i < ELEMENTWISE_TEST_MAX_SIZE; i += 2)
+        XCTAssertEqualWithAccuracy(c[i], a[i] + b[i], ELEMENTWISE_TEST_ACCURACY);
+}
+
+- (void) testMatrixKernels {
+    int M= MATRIX_TEST_M, N= MATRIX_TEST_N, K= MATRIX_TEST_K;
+    
+    
+    // Kernels are tested in single precision, whatever MLReal is
+    float a[MATRIX_TEST_M * MATRIX_TEST_K], refA[MATRIX_TEST_M * MATRIX_TEST_K];
+    float b[MATRIX_TEST_K * MATRIX_TEST_N];
+    float c[MATRIX_TEST_M * MATRIX_TEST_N], ref[MATRIX_TEST_M * MATRIX_TEST_N];
+    
+    // Check GEMM, row-major, with all combinations of transposes
+    for (int transA= 0; transA < 2; transA++) {
+        for (int transB= 0; transB < 2; transB++) {
+            [VectorKernelTests fillBuffer:a size:M * K seed:1];
+            [VectorKernelTests fillBuffer:b size:K * N seed:2];
+            [VectorKernelTests fillBuffer:c size:M * N seed:3];
+            
+            int lda= transA ? M : K;
+            int ldb= transB ? K : N;
+            
+            for (int i= 0; i < M; i++) {
+                for (int j= 0; j < N; j++) {
+                    float sum= 0.0f;
+                    for (int k= 0; k < K; k++)
+                        sum += (transA ? a[k * lda + i] : a[i * lda + k]) * (transB ? b[j * ldb + k] : b[k * ldb + j]);
+                    
+                    ref[i * N + j]= (0.5f * sum) + (2.0f * c[i * N + j]);
+                }
+            }
+            
+            MLVK_gemm(MLVKRowMajor, transA ? MLVKTrans : MLVKNoTrans, transB ? MLVKTrans : MLVKNoTrans,
+                      M, N, K, 0.5f, a, lda, b, ldb, 2.0f, c, N);
+            
+            for (int i= 0; i < M * N; i++)
+                XCTAssertEqualWithAccuracy(c[i], ref[i], MATRIX_TEST_ACCURACY);
+        }
+    }
+    
+    // Check GEMV, with and without transpose
+    float x[MATRIX_TEST_K], y[MATRIX_TEST_K], refY[MATRIX_TEST_K];
+    
+    for (int trans= 0; trans < 2; trans++) {
+        int sizeX= trans ? M : K;
+        int sizeY= trans ? K : M;
+        
+        [VectorKernelTests fillBuffer:x size:sizeX seed:4];
+        [VectorKernelTests fillBuffer:y size:sizeY seed:5];
+        
+        for (int i= 0; i < sizeY; i++) {
+            float sum= 0.0f;
+            for (int j= 0; j < sizeX; j++)
+                sum += (trans ? a[j * K + i] : a[i * K + j]) * x[j];
+            
+            refY[i]= sum + (0.5f * y[i]);
+        }
+        
+        MLVK_gemv(MLVKRowMajor, trans ? MLVKTrans : MLVKNoTrans, M, K, 1.0f, a, K, x, 1, 0.5f, y, 1);
+        
+        for (int i= 0; i < sizeY; i++)
+            XCTAssertEqualWithAccuracy(y[i], refY[i], MATRIX_TEST_ACCURACY);
+    }
+    
+    // Check GER
+    [VectorKernelTests fillBuffer:x size:M seed:6];
+    [VectorKernelTests fillBuffer:y size:K seed:7];
+    
+    for (int i= 0; i < M; i++) {
+        for (int j= 0; j < K; j++)
+            refA[i * K + j]= a[i * K + j] + (0.25f * x[i] * y[j]);
+    }
+    
+    MLVK_ger(MLVKRowMajor, M, K, 0.25f, x, 1, y, 1, a, K);
+    
+    for (int i= 0; i < M * K; i++)
+        XCTAssertEqualWithAccuracy(a[i], refA[i], MATRIX_TEST_ACCURACY);
+}
+
+
+#pragma mark -
+#pragma mark Utility methods
+
++ (void) fillBuffer:(float *)buffer size:(NSUInteger)size seed:(unsigned int)seed {
+    
+    // A simple deterministic sequence in -1..1 is enough here
+    unsigned int state= (seed * 2654435761u) + 1;
+    
+    for (NSUInteger i= 0; i < size; i++) {
+        state= (state * 1664525u) + 1013904223u;
+        buffer[i]= (((float) (state >> 8)) / ((float) (1 << 24))) * 2.0f - 1.0f;
+    }
+}
+
+
+@end
@@ -41,10 +41,52 @@
 #define TEST_IMAGES_FILE_NAME         (@"t10k-images-idx3-ubyte")
 #define TEST_LABELS_FILE_NAME         (@"t10k-labels-idx1-ubyte")
 
+#define TRAINING_BATCH_SIZE           (10)
+#define TRAINING_LEARNING_RATE        (0.05)
 #define TRAINING_COST_LIMIT           (0.001)
 #define TRAINING_GAIN_COST_LIMIT      (0.1)
 
 
+#pragma mark -
+#pragma mark Training data source
+
+@interface MNISTTrainingSource : NSObject <MLTrainerDataSource>
+
+- (nonnull instancetype) initWithImageSet:(nonnull MNISTDataset *)imageSet labelSet:(nonnull MNISTDataset *)labelSet;
+
+@end
+
+
+@implementation MNISTTrainingSource {
+    MNISTDataset *_imageSet;
+    MNISTDataset *_labelSet;
+}
+
+- (instancetype) initWithImageSet:(MNISTDataset *)imageSet labelSet:(MNISTDataset *)labelSet {
+    if ((self = [super init])) {
+        _imageSet= imageSet;
+        _labelSet= labelSet;
+    }
+    
+    return self;
+}
+
+- (NSUInteger) numberOfSamplesForTrainer:(MLTrainer *)trainer {
+    return _imageSet.items;
+}
+
+- (void) trainer:(MLTrainer *)trainer fillInputBuffer:(MLReal *)inputBuffer expectedOutputBuffer:(MLReal *)expectedOutputBuffer forSampleAtIndex:(NSUInteger)index {
+    memcpy(inputBuffer, [_imageSet itemAtIndex:index], _imageSet.itemSize * sizeof(MLReal));
+    memcpy(expectedOutputBuffer, [_labelSet itemAtIndex:index], _labelSet.itemSize * sizeof(MLReal));
+}
+
+@end
+
+
+#pragma mark -
+#pragma mark Main
+
+
 int main(int argc, const char * argv[]) {
     @autoreleasepool {
         @try {
@@ -73,61 +115,24 @@ int main(int argc, const char * argv[]) {
             
             [net randomizeWeights];
             
+            // Prepare the trainer: samples are shuffled and staged
+            // on a background thread, while the network trains by batch
+            MNISTTrainingSource *source= [[MNISTTrainingSource alloc] initWithImageSet:trainingImageSet labelSet:trainingLabelSet];
+            MLTrainer *trainer= [[MLTrainer alloc] initWithNetwork:net dataSource:source batchSize:TRAINING_BATCH_SIZE];
+            
+            trainer.costLimit= TRAINING_COST_LIMIT;
+            trainer.gainCostLimit= TRAINING_GAIN_COST_LIMIT;
+            
+            trainer.progressHandler= ^(NSUInteger epoch, NSUInteger trainedSamples, MLReal cost, double samplesPerSecond, NSTimeInterval eta) {
+                NSLog(@"  - Trained %5lu samples, %2lu epochs, %7.0f samples/sec, ETA: %6.2f secs...", trainedSamples, epoch -1, samplesPerSecond, eta);
+            };
+            
+            trainer.epochHandler= ^(NSUInteger epoch, MLReal cost) {
+                NSLog(@"- Trained %2lu epochs, current error: %7.5f", epoch, cost);
+            };
+            
             // Training loop
-            int epochs= 0;
-            MLReal lastCost= 0.0;
-            do {
-                NSDate *begin= [NSDate date];
-                
-                // Run an epoch
-                MLReal cost= 0.0;
-                for (int i= 0; i < trainingImageSet.items; i++) {
-                    
-                    // Fill the input buffer
-                    ML_VCLR(net.inputBuffer, 1, net.inputSize);
-                    ML_VADD([trainingImageSet itemAtIndex:i], 1, net.inputBuffer, 1, net.inputBuffer, 1, net.inputSize);
-                    
-                    // Fill the expected output buffer
-                    ML_VCLR(net.expectedOutputBuffer, 1, net.outputSize);
-                    ML_VADD([trainingLabelSet itemAtIndex:i], 1, net.expectedOutputBuffer, 1, net.expectedOutputBuffer, 1, net.outputSize);
-                    
-                    // Run the network
-                    [net feedForward];
-                    [net backPropagateWithLearningRate:0.1];
-                    [net updateWeights];
-                    
-                    // Sum the cost
-                    cost += net.cost;
-                    
-                    // Log every 1000 samples
-                    if ((i > 0) && (i % 1000 == 0)) {
-                        NSDate *end= [NSDate date];
-                        NSTimeInterval elapsed= [end timeIntervalSinceDate:begin];
-                        NSTimeInterval elapsedPerSample= elapsed / (double) i;
-                        NSTimeInterval eta= (double)(trainingImageSet.items - i) * elapsedPerSample;
-
-                        NSLog(@"  - Trained %5d samples, %2d epochs, ETA: %6.2f secs...", i, epochs, eta);
-                    }
-                }
-                
-                cost /= (MLReal) trainingImageSet.items;
-                epochs++;
-                
-                NSLog(@"- Trained %2d epochs, current error: %7.5f", epochs, cost);
-                
-                // Check termination condition
-                if (cost < TRAINING_COST_LIMIT) {
-                    break;
-                
-                } else if (epochs > 1) {
-                    double costGain= (lastCost - cost) / lastCost;
-                    if (costGain < TRAINING_GAIN_COST_LIMIT)
-                        break;
-                }
-                
-                lastCost= cost;
-                
-            } while (YES);
+            [trainer trainWithLearningRate:TRAINING_LEARNING_RATE maxEpochs:0];
             
             
             ////////////////////////////////////////////////////////////////